@@ -26,6 +26,8 @@
 #define _GMIC_QT_ABSTRACTPARAMETER_H_
 
 #include <QObject>
+#include <QStringList>
+struct ParameterDefinition;
 
 class AbstractParameter : public QObject {
   Q_OBJECT
@@ -41,15 +43,14 @@ public:
   virtual void clear();
   virtual void setValue(const QString & value) = 0;
   virtual void reset() = 0;
-  static AbstractParameter * createFromText(const char * text, int & length, QString & error, QObject * parent = 0);
-  virtual void initFromText(const char * text, int & textLength) = 0;
+  static AbstractParameter * createFromDefinition(const ParameterDefinition & definition, QObject * parent = 0);
+  virtual void initFromDefinition(const ParameterDefinition & definition) = 0;
 
 signals:
   void valueChanged();
 
 protected:
-  QStringList parseText(const QString & type, const char * text, int & length);
-  bool matchType(const QString & type, const char * text) const;
+  QStringList parseDefinition(const ParameterDefinition & definition);
   bool _update;
   const bool _actualParameter;
 };
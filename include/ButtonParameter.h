@@ -43,7 +43,7 @@ public:
   void clear();
   void setValue(const QString &);
   void reset();
-  void initFromText(const char * text, int & textLength);
+  void initFromDefinition(const ParameterDefinition & definition);
 public slots:
   void onPushButtonClicked(bool);
 signals:
@@ -40,7 +40,7 @@ public:
   QString textValue() const;
   void setValue(const QString &);
   void reset();
-  void initFromText(const char * text, int & textLength);
+  void initFromDefinition(const ParameterDefinition & definition);
 public slots:
   void onComboBoxIndexChanged(int);
 signals:
@@ -0,0 +1,53 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file CimgzDecoder.h
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef _GMIC_QT_CIMGZDECODER_H_
+#define _GMIC_QT_CIMGZDECODER_H_
+
+#include <QByteArray>
+
+/**
+ * @brief In-memory decoder for the .cimg(z) files holding filter sources.
+ *
+ *  A .cimg(z) file starts with a "<count> <pixel type> <endianness>_endian"
+ *  line (lines starting with '#' are comments), followed for each image by a
+ *  "<width> <height> <depth> <spectrum>[ #<compressed size>]" line and the
+ *  pixel values, zlib-compressed if the size is given.
+ */
+class CimgzDecoder
+{
+public:
+  /**
+   * @brief Decode 8-bit images, concatenated as CImg<unsigned char>::load_cimg()
+   *        would do (i.e. appended along z).
+   * @param supported Set to false if the layout is not handled here
+   *        (other pixel types, or images that would not be concatenated)
+   * @return A null array if the data is unsupported or corrupted
+   */
+  static QByteArray decode(const char * data, qint64 size, bool & supported);
+private:
+  CimgzDecoder() = delete;
+};
+
+#endif // _GMIC_QT_CIMGZDECODER_H_
@@ -44,7 +44,7 @@ public:
   QString textValue() const;
   void setValue(const QString & value);
   void reset();
-  void initFromText(const char * text, int & textLength);
+  void initFromDefinition(const ParameterDefinition & definition);
 public slots:
   void onButtonPressed();
 signals:
@@ -54,7 +54,11 @@ template<typename T> inline void unused(const T&, ...) {}
 
 #define SLIDER_MIN_WIDTH 60
 #define PARAMETERS_CACHE_FILENAME "gmic_qt_params.dat"
+#define PARAMETERS_STORE_FILENAME "gmic_qt_params.kv"
+#define USER_CATALOG_FILENAME "gmic_qt_catalog.kv"
 #define FILTERS_VISIBILITY_FILENAME "gmic_qt_visibility.dat"
+#define STDLIB_CACHE_FILENAME "gmic_qt_stdlib.cache"
+#define STDLIB_CACHE_MANIFEST_FILENAME "gmic_qt_stdlib.manifest"
 
 #define FAVE_FOLDER_TEXT "<b>Faves</b>"
 #define FAVES_IMPORT_KEY "Faves/ImportedGTK179"
@@ -62,6 +66,8 @@ template<typename T> inline void unused(const T&, ...) {}
 #define REFRESH_USING_INTERNET_KEY "Config/RefreshInternetUpdate"
 #define INTERNET_UPDATE_PERIODICITY_KEY "Config/UpdatesPeriodicityValue"
 #define INTERNET_NEVER_UPDATE_PERIODICITY std::numeric_limits<int>::max()
+#define INTERNET_MIRROR_KEY "Config/SourcesMirrorURL"
+#define INTERNET_MAX_DOWNLOADS_KEY "Config/MaxConcurrentDownloads"
 
 #define PREVIEW_MAX_ZOOM_FACTOR 40.0
 
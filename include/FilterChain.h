@@ -0,0 +1,75 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file FilterChain.h
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef _GMIC_QT_FILTERCHAIN_H_
+#define _GMIC_QT_FILTERCHAIN_H_
+
+#include <QString>
+#include <QList>
+
+/**
+ * @brief An ordered list of filters (with their parameters) that are
+ *        run, in a single interpreter pass, before the selected filter.
+ *
+ *  The chain is turned into a command line prefix (see
+ *  FilterThread::setCommandPrefix()) so that intermediate results
+ *  never go back to the host.
+ */
+class FilterChain
+{
+public:
+  struct Entry {
+    QString name;
+    QString command;
+    QString previewCommand;
+    QString arguments;
+  };
+
+  FilterChain();
+  void append(const QString & name,
+              const QString & command,
+              const QString & previewCommand,
+              const QString & arguments);
+  void clear();
+  bool isEmpty() const;
+  int size() const;
+  const Entry & at(int index) const;
+
+  /**
+   * @brief The plain names of the chained filters, e.g. "Blur > Sharpen"
+   */
+  QString names() const;
+
+  /**
+   * @brief Commands of the chain, e.g. "-fx_blur 3,1 -fx_sharpen 50"
+   * @param preview If true, preview commands are used instead, except
+   *        for filters without one (their full command is then used).
+   */
+  QString commandLine(bool preview) const;
+
+private:
+  QList<Entry> _entries;
+};
+
+#endif // _GMIC_QT_FILTERCHAIN_H_
@@ -33,6 +33,7 @@
 #include <QModelIndex>
 class AbstractParameter;
 class QLabel;
+class QGridLayout;
 class FiltersTreeAbstractFilterItem;
 
 class FilterParamsWidget : public QWidget {
@@ -45,6 +46,10 @@ public:
   void setNoFilter();
   virtual ~FilterParamsWidget();
   const QString & valueString() const;
+  /**
+   * @brief Hash of the current values, updated along with valueString()
+   */
+  uint valueFingerprint() const;
   QStringList valueStringList() const;
   void setValues(const QStringList &, bool notify);
   void reset(bool notify);
@@ -56,13 +61,20 @@ public:
 
 public slots:
   void updateValueString(bool notify = true);
+  void onParameterValueChanged();
 
 signals:
   void valueChanged();
 
 protected:
   void clear();
+  QGridLayout * resetLayout();
+  void serializeValue(int index);
+  void assembleValueString();
   QVector<AbstractParameter*> _presetParameters;
+  QVector<QString> _serializedValues;
+  QVector<uint> _serializedValuesHashes;
+  uint _valueFingerprint;
   int _actualParametersCount;
   QString _valueString;
   QLabel * _labelNoParams;
@@ -32,6 +32,7 @@ class ImageSource;
 class QMutex;
 class QImage;
 class QSemaphore;
+struct gmic;
 #include <QApplication>
 #include <QColor>
 #include <QFont>
@@ -64,6 +65,12 @@ public:
   virtual ~FilterThread();
   void run();
   void setArguments(const QString &);
+  void setCommandPrefix(const QString &);
+  /**
+   * @brief Run in the given interpreter instead of a new one.
+   *        The caller sets its _host variable and resets it between jobs.
+   */
+  void setInterpreter(gmic * interpreter);
   void setInputImages( const cimg_library::CImgList<float> & list,
                        const cimg_library::CImgList<char> & imageNames );
   const cimg_library::CImgList<float> & images() const;
@@ -76,6 +83,10 @@ public:
   float progress() const;
   QString name() const;
   QString fullCommand() const;
+  static QString buildCommandLine(const QString & command,
+                                  const QString & arguments,
+                                  GmicQt::OutputMessageMode mode,
+                                  const QString & commandPrefix = QString());
 
 public slots:
   void abortGmic();
@@ -87,9 +98,11 @@ private:
   void setCommand(const QString & command);
   QString _command;
   QString _arguments;
+  QString _commandPrefix;
   QString _environment;
   cimg_library::CImgList<float> * _images;
   cimg_library::CImgList<char> * _imageNames;
+  gmic * _interpreter;
   bool _gmicAbort;
   bool _failed;
   QString _gmicStatus;
@@ -0,0 +1,68 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file FiltersRegistry.h
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef _GMIC_QT_FILTERSREGISTRY_H_
+#define _GMIC_QT_FILTERSREGISTRY_H_
+
+#include <QHash>
+#include <QString>
+
+class QStandardItem;
+class FiltersTreeAbstractFilterItem;
+class FiltersTreeFilterItem;
+class FiltersTreeFaveItem;
+
+/**
+ * @brief Hash tables of the filters and faves present in the filters tree.
+ *
+ *  Built once per tree, then kept up to date when faves are
+ *  added, renamed or removed.
+ */
+class FiltersRegistry
+{
+public:
+  FiltersRegistry();
+  void clear();
+
+  /**
+   * @brief Register all filters and faves below a tree item
+   */
+  void addItems(QStandardItem * folder);
+  void add(FiltersTreeAbstractFilterItem * item);
+  void remove(FiltersTreeAbstractFilterItem * item);
+
+  /**
+   * @brief Update the key of a fave whose hash has changed (e.g. renamed)
+   */
+  void rehash(const QString & previousHash, FiltersTreeFaveItem * fave);
+
+  FiltersTreeFilterItem * filter(const QString & hash) const;
+  FiltersTreeFaveItem * fave(const QString & hash) const;
+
+private:
+  QHash<QString,FiltersTreeFilterItem*> _filters;
+  QHash<QString,FiltersTreeFaveItem*> _faves;
+};
+
+#endif // _GMIC_QT_FILTERSREGISTRY_H_
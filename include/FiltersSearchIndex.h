@@ -0,0 +1,108 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file FiltersSearchIndex.h
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef _GMIC_QT_FILTERSSEARCHINDEX_H_
+#define _GMIC_QT_FILTERSSEARCHINDEX_H_
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QVector>
+#include <QDateTime>
+
+class QStandardItem;
+class FiltersTreeAbstractFilterItem;
+
+/**
+ * @brief Index of the filters tree, used by the search field.
+ *
+ *  Filter names, folder paths and parameter labels are split once into
+ *  (lowercase, accent-folded) words. A query word matches an indexed word
+ *  if it is a prefix of it or, with a few typos, close to one of its
+ *  prefixes (candidates are found through shared trigrams, then checked
+ *  with a bounded edit distance). A filter matches if all query words
+ *  match; results are ranked by field (name > folder > parameter),
+ *  match quality and usage of the filter.
+ */
+class FiltersSearchIndex
+{
+public:
+  FiltersSearchIndex();
+
+  /**
+   * @brief Index all filters and faves below a tree item.
+   *        Must be called again whenever items are added, renamed or removed.
+   */
+  void build(QStandardItem * root);
+  void clear();
+  int size() const;
+
+  /**
+   * @brief Filters matching all words of a query, best first
+   */
+  const QVector<FiltersTreeAbstractFilterItem*> & search(const QString & query);
+
+  /**
+   * @brief Record that a filter (or fave) has been applied,
+   *        so that it ranks higher in subsequent searches.
+   */
+  void recordUsage(const QString & hash);
+
+  static QString normalize(const QString & text);
+  static QStringList words(const QString & text);
+
+private:
+  enum Field { NameField = 0, PathField, ParameterField };
+  struct Posting {
+    int item;
+    int field;
+  };
+  struct Usage {
+    Usage() : count(0) { }
+    int count;
+    QDateTime last;
+  };
+  void addItems(QStandardItem * folder);
+  void addWords(int item, const QStringList & words, Field field);
+  const QHash<int,float> & matches(const QString & word);
+  QVector<int> fuzzyCandidates(const QString & word, int maxDistance) const;
+  float usageBoost(int item, const QDateTime & now) const;
+  void loadUsage();
+  static int prefixDistance(const QString & word, const QString & text, int maxDistance);
+  static QStringList parameterLabels(const QString & parameters);
+
+  QVector<FiltersTreeAbstractFilterItem*> _items;
+  QStringList _hashes;
+  QStringList _words;
+  QHash<QString,int> _wordIds;
+  QVector<QVector<Posting>> _postings;
+  QHash<QString,QVector<int>> _prefixes;
+  QHash<QString,QVector<int>> _trigrams;
+  QHash<QString,QHash<int,float>> _matchesCache;
+  QHash<QString,Usage> _usage;
+  bool _usageLoaded;
+  QVector<FiltersTreeAbstractFilterItem*> _result;
+};
+
+#endif // _GMIC_QT_FILTERSSEARCHINDEX_H_
@@ -0,0 +1,73 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file FiltersSearchProxyModel.h
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef _GMIC_QT_FILTERSSEARCHPROXYMODEL_H_
+#define _GMIC_QT_FILTERSSEARCHPROXYMODEL_H_
+
+#include <QAbstractProxyModel>
+#include <QHash>
+#include <QVector>
+
+class QStandardItem;
+class QStandardItemModel;
+class FiltersTreeAbstractFilterItem;
+
+/**
+ * @brief Flat view of the filters tree model listing search results,
+ *        in the order given by the search index (best first).
+ *
+ *  Rows map to the items of the tree model, so that editing them (e.g.
+ *  the visibility check box) edits the tree. The list is emptied whenever
+ *  rows of the tree model are removed, until setResults() is called again.
+ */
+class FiltersSearchProxyModel : public QAbstractProxyModel
+{
+  Q_OBJECT
+
+public:
+  explicit FiltersSearchProxyModel(QObject * parent = 0);
+  void setSourceModel(QStandardItemModel * model);
+  void setResults(const QVector<FiltersTreeAbstractFilterItem*> & results);
+
+  QModelIndex index(int row, int column, const QModelIndex & parent = QModelIndex()) const override;
+  QModelIndex parent(const QModelIndex & child) const override;
+  int rowCount(const QModelIndex & parent = QModelIndex()) const override;
+  int columnCount(const QModelIndex & parent = QModelIndex()) const override;
+  QModelIndex mapToSource(const QModelIndex & proxyIndex) const override;
+  QModelIndex mapFromSource(const QModelIndex & sourceIndex) const override;
+  QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+public slots:
+  void clear();
+
+private slots:
+  void onSourceDataChanged(const QModelIndex & topLeft, const QModelIndex & bottomRight);
+
+private:
+  QStandardItemModel * _model;
+  QVector<QStandardItem*> _results;
+  QHash<const QStandardItem*,int> _rows;
+};
+
+#endif // _GMIC_QT_FILTERSSEARCHPROXYMODEL_H_
@@ -31,31 +31,60 @@
 
 class FiltersTreeFaveItem;
 class FiltersTreeFilterItem;
+class FiltersTreeFolderItem;
+class FiltersTreeAbstractFilterItem;
 
 class FiltersTreeAbstractItem : public QStandardItem
 {
 public:
+  /*
+   * Values returned by type(), so that the tree can be walked
+   * without a dynamic_cast on each item.
+   */
+  enum ItemType {
+    FolderItemType = QStandardItem::UserType + 1,
+    FilterItemType,
+    FaveItemType
+  };
+
   FiltersTreeAbstractItem(const QString & name);
   ~FiltersTreeAbstractItem();
   QString name() const;
   QString plainText() const;
-  virtual FiltersTreeAbstractItem * deepClone(const QStringList &) const = 0;
-  virtual FiltersTreeAbstractItem * deepClone() const = 0;
   virtual bool isWarning() const;
 
   QStringList path() const;
+  /**
+   * @brief Number of filters below an item (faves and the "Testing" folder
+   *        are not counted). Counts are cached by folders, see
+   *        FiltersTreeFolderItem::leafCount().
+   */
   static int countLeaves( QStandardItem * item );
   static FiltersTreeFaveItem * findFave( QStandardItem * folder, QString hash );
   static FiltersTreeFilterItem * findFilter( QStandardItem * folder, QString hash );
   bool operator<(const QStandardItem & other ) const;
-  static bool matchWordList(const QStringList & words, const QString & str);
 
   void setVisibilityItem( QStandardItem * );
   bool isVisible() const;
   void setVisibility(bool visibility);
 
+  static bool isFolder( const QStandardItem * item );
+  static bool isFilter( const QStandardItem * item );
+  static bool isFave( const QStandardItem * item );
+  static bool isAbstractFilter( const QStandardItem * item );
+  static FiltersTreeFolderItem * toFolder( QStandardItem * item );
+  static FiltersTreeFilterItem * toFilter( QStandardItem * item );
+  static FiltersTreeFaveItem * toFave( QStandardItem * item );
+  static FiltersTreeAbstractFilterItem * toAbstractFilter( QStandardItem * item );
+  static FiltersTreeAbstractItem * toAbstractItem( QStandardItem * item );
+
   static bool cleanupFolders(QStandardItem *item);
-  static void uncheckFullyUncheckedFolders(QStandardItem * folder);
+  /**
+   * @brief Uncheck the folders holding no visible filter nor fave
+   *        (a single walk of the tree).
+   * @return true if folder holds a visible filter or fave
+   */
+  static bool uncheckFullyUncheckedFolders(QStandardItem * folder);
   static void buildHashesList(QStandardItem * item, QSet<QString> & hashes);
 
 protected:
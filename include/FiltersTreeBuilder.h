@@ -0,0 +1,69 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file FiltersTreeBuilder.h
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef _GMIC_QT_FILTERSTREEBUILDER_H_
+#define _GMIC_QT_FILTERSTREEBUILDER_H_
+
+#include <QByteArray>
+#include <QThread>
+
+class QStandardItem;
+
+/**
+ * @brief Builds a filters tree outside of any model, so that it can be
+ *        done in a worker thread and then moved into the view's model.
+ *
+ *  The resulting tree is sorted, and its empty folders are removed (or
+ *  folders are unchecked when visibility check boxes are shown).
+ *  Faves are not part of it.
+ */
+class FiltersTreeBuilder : public QThread
+{
+  Q_OBJECT
+
+public:
+  /**
+   * @param stdlib The stdlib to be parsed
+   */
+  FiltersTreeBuilder(QObject * parent, const QByteArray & stdlib, bool withVisibility, int generation = 0);
+  ~FiltersTreeBuilder();
+
+  void run();
+  void build();
+
+  QStandardItem * takeRoot();
+  const QByteArray & stdlib() const;
+  bool withVisibility() const;
+  int filtersCount() const;
+  int generation() const;
+
+private:
+  QByteArray _stdlib;
+  bool _withVisibility;
+  int _generation;
+  QStandardItem * _root;
+  int _filtersCount;
+};
+
+#endif // _GMIC_QT_FILTERSTREEBUILDER_H_
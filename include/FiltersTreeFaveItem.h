@@ -42,9 +42,8 @@ public:
                       const QString & name,
                       const QList<QString> & defaultValues );
   ~FiltersTreeFaveItem();
+  int type() const override;
   void rename(const QString &);
-  FiltersTreeAbstractItem * deepClone(const QStringList & selection) const override;
-  FiltersTreeAbstractItem * deepClone() const override;
   QString originalFilterHash() const;
   QString originalFilterName() const;
   QList<QString> defaultValues() const;
@@ -40,8 +40,7 @@ public:
                         float previewFactor,
                         bool accurateIfZoomed );
   ~FiltersTreeFilterItem();
-  FiltersTreeAbstractItem * deepClone(const QStringList &) const override;
-  FiltersTreeAbstractItem * deepClone() const override;
+  int type() const override;
   void setWarningFlag(bool);
   bool isWarning() const override;
 protected:
@@ -43,17 +43,23 @@ public:
   bool isFaveFolder() const;
   void setWarningFlag(bool);
   bool isWarning() const override;
-  FiltersTreeAbstractItem * deepClone(const QStringList &) const override;
-  FiltersTreeAbstractItem * deepClone() const override;
+  int type() const override;
+
+  /**
+   * @brief Number of filters in the folder and its subfolders.
+   *        Computed when first needed, then cached: filters are only added
+   *        while the tree is built, and faves are not counted.
+   */
+  int leafCount() const;
 
   void setItemsVisibility(bool visible);
-  bool isFullyUnchecked();
   void applyVisibilityStatusToFolderContents();
 
 private:
   QString _plainText;
   const bool _isFaveFolder;
   bool _isWarning;
+  mutable int _leafCount;
 };
 
 #endif // _GMIC_QT_FILTERSTREEFOLDERITEM_H_
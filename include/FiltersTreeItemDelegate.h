@@ -26,6 +26,9 @@
 #define _GMIC_QT_FILTERSTREEITEMDELEGATE_H_
 
 #include <QStyledItemDelegate>
+#include <QCache>
+#include <QString>
+class QTextDocument;
 
 class FiltersTreeItemDelegate : public QStyledItemDelegate
 {
@@ -34,6 +37,10 @@ public:
 protected:
   void paint(QPainter * painter, const QStyleOptionViewItem & option, const QModelIndex & index) const;
   QSize sizeHint(const QStyleOptionViewItem & option, const QModelIndex & index) const;
+private:
+  QTextDocument * document(const QString & html, qreal textWidth) const;
+  static const int DocumentCacheSize = 2048;
+  mutable QCache<QString,QTextDocument> _documents;
 };
 
 #endif // _GMIC_QT_FILTERSTREEITEMDELEGATE_H_
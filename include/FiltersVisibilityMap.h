@@ -25,6 +25,9 @@
 #ifndef _GMIC_QT_FILTERSVISIBILITYMAP_H_
 #define _GMIC_QT_FILTERSVISIBILITYMAP_H_
 
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
 #include <QSet>
 
 class FiltersVisibilityMap
@@ -36,9 +39,16 @@ public:
   static void load();
   static void save();
 
+  /**
+   * @brief Catalog records equivalent to the previous visibility file
+   */
+  static void importLegacyFile(QHash<QByteArray,QByteArray> & records);
+
 protected:
 private:
+  static bool readLegacyFile(QSet<QString> & hiddenFilters);
   static QSet<QString> _hiddenFilters;
+  static QMutex _mutex; // The filters tree may be built by a worker thread
   FiltersVisibilityMap() = delete;
 };
 
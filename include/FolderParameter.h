@@ -40,7 +40,7 @@ public:
   QString unquotedTextValue() const;
   void setValue(const QString & value);
   void reset();
-  void initFromText(const char * text, int & textLength);
+  void initFromDefinition(const ParameterDefinition & definition);
 public slots:
   void onButtonPressed();
 signals:
@@ -28,7 +28,6 @@
 #include <QByteArray>
 
 class QTreeView;
-class QStandardItemModel;
 class QStandardItem;
 class QStringList;
 class FiltersTreeAbstractItem;
@@ -36,7 +35,11 @@ class GmicStdLibParser
 {
 public:
   GmicStdLibParser();
-  static void buildFiltersTree(QStandardItemModel & model, bool withVisibility);
+  /**
+   * @brief Append the folders and filters defined in stdlib to root.
+   *        May be called from a worker thread on an item not (yet) part of a model.
+   */
+  static void buildFiltersTree(QStandardItem * root, const QByteArray & stdlib, bool withVisibility);
   static void saveFiltersVisibility(QStandardItem * );
   static void loadStdLib();
   static QByteArray GmicStdlib;
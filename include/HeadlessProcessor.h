@@ -32,6 +32,7 @@
 #include "gmic_qt.h"
 
 class FilterThread;
+class ResidentClient;
 
 namespace cimg_library {
 template<typename T> struct CImgList;
@@ -70,18 +71,29 @@ public slots:
   void startProcessing();
   void onTimeout();
   void onProcessingFinished();
+  void onResidentFinished();
+  void onResidentFailed();
   void cancel();
 signals:
   void singleShotTimeout();
   void done(QString errorMessage);
   void progression(float progress, int duration, unsigned long memory);
 private:
+  void startFilterThread();
+  void endProcessing(const QString & gmicStatus,
+                     const QString & errorMessage,
+                     cimg_library::CImgList<float> & images,
+                     const cimg_library::CImgList<char> & imageNames,
+                     bool outputImages);
   FilterThread * _filterThread;
+  ResidentClient * _residentClient;
   cimg_library::CImgList<float> * _gmicImages;
+  cimg_library::CImgList<char> * _gmicImageNames;
   QTimer _timer;
   QString _filterName;
   QString _lastCommand;
   QString _lastArguments;
+  QString _lastCommandPrefix;
   GmicQt::OutputMode _outputMode;
   GmicQt::OutputMessageMode _outputMessageMode;
   GmicQt::InputMode _inputMode;
@@ -26,15 +26,18 @@
 #define _GMIC_QT_HTMLTRANSLATOR_H_
 
 #include <QString>
-#include<QTextDocument>
 
 class HtmlTranslator {
 public:
   static QString html2txt(const QString &  str, bool force = false);
   static bool hasHtmlEntities(const QString &  str);
   static QString fromUtf8Escapes(const QString &str);
-private:
-  static QTextDocument _document;
+  /**
+   * @brief Convert the simple markup found in filter names (inline tags
+   *        like <b> or <font>, and common entities) to plain text.
+   * @return false if str contains markup that needs a full HTML parser
+   */
+  static bool stripSimpleHtml(const QString & str, QString & result);
 };
 
 #endif //  _GMIC_QT_HTMLTRANSLATOR_H_
@@ -0,0 +1,59 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file InterpreterState.h
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef _GMIC_QT_INTERPRETERSTATE_H_
+#define _GMIC_QT_INTERPRETERSTATE_H_
+
+#include <QtGlobal>
+
+struct gmic;
+
+namespace cimg_library {
+template<typename T> struct CImgList;
+}
+
+/**
+ * @brief Variables and verbosity of a G'MIC interpreter, saved right after
+ *        its creation so that an interpreter reused for several jobs starts
+ *        each of them afresh (commands parsed from the stdlib are kept).
+ */
+class InterpreterState
+{
+public:
+  InterpreterState();
+  ~InterpreterState();
+  void save(const gmic & interpreter);
+  /**
+   * @brief Restore saved variables and verbosity, and clear the status.
+   */
+  void restore(gmic & interpreter) const;
+
+private:
+  Q_DISABLE_COPY(InterpreterState)
+  cimg_library::CImgList<char> * _variables;
+  cimg_library::CImgList<char> * _variablesNames;
+  int _verbosity;
+};
+
+#endif // _GMIC_QT_INTERPRETERSTATE_H_
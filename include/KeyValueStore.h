@@ -0,0 +1,123 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file KeyValueStore.h
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef _GMIC_QT_KEYVALUESTORE_H_
+#define _GMIC_QT_KEYVALUESTORE_H_
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QScopedPointer>
+#include <QString>
+
+class QLockFile;
+
+/**
+ * @brief Append-only key/value file.
+ *
+ *  Every insertion or removal is a single record appended (and flushed)
+ *  at the end of the file, so that a crash loses at most the record being
+ *  written. Opening the store memory-maps the file and only scans the
+ *  record headers to build the index; values are read on demand.
+ *  Outdated records are discarded by compact().
+ *
+ *  Several processes may share the file: writes and compaction hold a
+ *  lock file (filename + ".lock"), first index the records appended by
+ *  the other processes, and reopen the file if it was compacted meanwhile.
+ *
+ *  File layout: 8 bytes magic, then records made of
+ *  key size (quint32), value size (quint32, RemovedRecord for a removal),
+ *  checksum (quint32), key bytes, value bytes. Integers are little endian.
+ *  A record with an empty key holds the records of a transaction (see write()),
+ *  which are therefore all applied or all dropped.
+ */
+class KeyValueStore
+{
+public:
+  KeyValueStore();
+  ~KeyValueStore();
+
+  /**
+   * @brief Open (or create) a store file.
+   *  An incomplete last record (interrupted write) is dropped,
+   *  a record with a bad checksum is skipped.
+   */
+  bool open(const QString & filename);
+  void close();
+  bool isOpen() const;
+  QString filename() const;
+
+  bool contains(const QByteArray & key) const;
+  QByteArray value(const QByteArray & key) const;
+  QList<QByteArray> keys() const;
+  bool insert(const QByteArray & key, const QByteArray & value);
+  bool remove(const QByteArray & key);
+
+  /**
+   * @brief Apply several insertions and removals at once.
+   *  The changes are written as a single record: after a crash, either
+   *  all of them or none are found in the file.
+   */
+  bool write(const QHash<QByteArray,QByteArray> & inserts,
+             const QList<QByteArray> & removals = QList<QByteArray>());
+
+  /**
+   * @brief True if outdated records take more room than live ones
+   */
+  bool needsCompaction() const;
+
+  /**
+   * @brief Rewrite the file with live records only (atomically replaced)
+   */
+  bool compact();
+
+  static const quint32 RemovedRecord = 0xFFFFFFFF;
+
+private:
+  struct Entry {
+    qint64 offset;
+    quint32 size;
+  };
+  bool openFile(const QString & filename);
+  bool map();
+  void unmap();
+  bool isReplaced() const;
+  bool sync();
+  bool scan(qint64 from);
+  qint64 indexRecord(qint64 position, qint64 limit, bool & corrupted);
+  void updateIndex(const QByteArray & key, qint64 offset, quint32 valueSize);
+  bool append(const QByteArray & data);
+  static QByteArray record(const QByteArray & key, const QByteArray & value, bool removed);
+  static quint32 checksum(const QByteArray & key, const QByteArray & value, quint32 valueSize);
+  mutable QFile _file;
+  QScopedPointer<QLockFile> _lock;
+  uchar * _map;
+  qint64 _mapSize;
+  qint64 _end;
+  qint64 _liveBytes;
+  QHash<QByteArray,Entry> _index;
+};
+
+#endif // _GMIC_QT_KEYVALUESTORE_H_
@@ -31,8 +31,15 @@
 #include <QModelIndex>
 #include <QList>
 #include <QString>
+#include <QSet>
 #include <QTimer>
+#include <QImage>
 #include "StoredFave.h"
+#include "FilterChain.h"
+#include "FiltersSearchIndex.h"
+#include "FiltersSearchProxyModel.h"
+#include "FiltersRegistry.h"
+#include "StartupPipeline.h"
 #include "Common.h"
 #include "gmic_qt.h"
 
@@ -63,6 +70,12 @@ public:
   ~MainWindow();
   void updateFiltersFromSources(int ageLimit, bool useNetwork);
 
+  /**
+   * @brief Show the window right away and populate the filters tree
+   *        as soon as the startup pipeline is done.
+   */
+  void startup(int ageLimit, bool useNetwork);
+
   void setDarkTheme();
 
 public slots:
@@ -86,10 +99,12 @@ public slots:
   void onRemoveFave();
   void onRenameFave();
   void onRenameFaveFinished(QWidget * editor);
+  void onAddToChain();
+  void onClearChain();
   void onOutputMessageModeChanged(GmicQt::OutputMessageMode);
   void onToggleFullScreen(bool on);
   void onSettingsClicked();
-  void startupUpdateFinished(bool);
+  void onStartupFinished(bool downloadsOk);
   void onZoomIn();
   void onZoomOut();
   void showZoomWarningIfNeeded();
@@ -119,6 +134,7 @@ protected:
 private slots:
 
   void onFiltersTreeItemChanged(QStandardItem *);
+  void onFiltersTreeBuilderFinished();
 
 private:
 
@@ -127,10 +143,8 @@ private:
   void showMessage(QString text, int ms = 2000);
   void setIcons();
   bool confirmAbortProcessingOnCloseRequest();
-  enum ModelType { FullModel, SelectionModel };
-  FiltersTreeFolderItem * faveFolder( ModelType modelType );
-  FiltersTreeFaveItem * findFave( const QString & hash, ModelType modelType );
-  FiltersTreeFilterItem * findFilter( const QString & hash, ModelType modelType );
+  FiltersTreeFolderItem * faveFolder();
+  FiltersTreeFaveItem * findFave( const QString & hash );
   FiltersTreeFilterItem * findFilter( const QString & hash );
   FiltersTreeAbstractFilterItem * currentTreeIndexToAbstractFilter( QModelIndex index );
   void addFaveFolder();
@@ -138,7 +152,16 @@ private:
   void loadFaves(bool withVisibility);
   bool importFaves();
   void saveFaves();
-  void buildFiltersTree();
+  void buildFiltersTreeInBackground(const QByteArray & stdlib);
+  void installFiltersTree(QStandardItem * root, int filtersCount, bool withVisibility);
+  void finishStartup();
+  void rebuildSearchIndex();
+  /**
+   * @brief Index in the filters view (search results or tree) of a tree model index
+   */
+  QModelIndex viewIndex(const QModelIndex & treeIndex) const;
+  QModelIndex treeIndex(const QModelIndex & viewIndex) const;
+  void updateFiltersCountHeader(int count);
 
   void backupExpandedFoldersPaths();
   void expandedFolderPaths(QStandardItem * item, QStringList & list);
@@ -155,8 +178,10 @@ private:
 
   Ui::MainWindow *ui;
   QStandardItemModel _filtersTreeModel;
-  QStandardItemModel _filtersTreeModelSelection;
-  QStandardItemModel * _currentFiltersTreeModel;
+  FiltersSearchIndex _filtersSearchIndex;
+  FiltersSearchProxyModel _searchResultsModel;
+  FiltersRegistry _filtersRegistry;
+  bool _searchActive;
   FiltersTreeAbstractFilterItem * _selectedAbstractFilterItem;
   cimg_library::CImgList<float> * _gmicImages;
   FilterThread * _filterThread;
@@ -168,12 +193,22 @@ private:
   ProcessingAction _processingAction;
   PreviewPosition _previewPosition = PreviewOnRight;
   bool _okButtonShouldApply = false;
+  QString _pendingPreviewKey;
+  QString _lastPreviewKey;
+  QImage _lastPreviewImage;
 
   QString _lastAppliedCommand;
   QString _lastAppliedCommandArguments;
+  QString _lastAppliedCommandPrefix;
   QString _lastFilterName;
   GmicQt::OutputMessageMode _lastAppliedCommandOutputMessageMode;
 
+  FilterChain _filterChain;
+  StartupPipeline _startupPipeline;
+  bool _startupFinished;
+  bool _startupDownloadsOk;
+  int _filtersTreeGeneration;
+
   QList<StoredFave> _importedFaves;
   QList<FiltersTreeFaveItem*> _hiddenFaves;
 
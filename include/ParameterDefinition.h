@@ -0,0 +1,65 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file ParameterDefinition.h
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef _GMIC_QT_PARAMETERDEFINITION_H_
+#define _GMIC_QT_PARAMETERDEFINITION_H_
+
+#include <QString>
+#include <QVector>
+#include <QHash>
+
+/**
+ * @brief One parameter of a filter, as declared in its #@gui line,
+ *        e.g. "Radius = _float(3,0,20)".
+ */
+struct ParameterDefinition {
+  ParameterDefinition() : update(true) { }
+  QString name;   // "Radius"
+  QString type;   // "float" (lowercase)
+  QString values; // "3,0,20" (text between brackets, trimmed)
+  bool update;    // false if the type is prefixed by '_'
+
+  /**
+   * @brief Split the parameters text of a filter in a single pass
+   * @return false (and an error message) if the text could not be parsed
+   */
+  static bool parse(const QString & text, QVector<ParameterDefinition> & definitions, QString & error);
+
+  /**
+   * @brief Same as parse(), with results kept per filter hash so that
+   *        selecting a filter again does not parse its parameters again.
+   */
+  static QVector<ParameterDefinition> cachedParse(const QString & hash, const QString & text, QString & error);
+  static void clearCache();
+
+private:
+  struct CacheEntry {
+    QString text;
+    QVector<ParameterDefinition> definitions;
+    QString error;
+  };
+  static QHash<QString,CacheEntry> _cache;
+};
+
+#endif // _GMIC_QT_PARAMETERDEFINITION_H_
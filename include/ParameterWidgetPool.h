@@ -0,0 +1,73 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file ParameterWidgetPool.h
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef _GMIC_QT_PARAMETERWIDGETPOOL_H_
+#define _GMIC_QT_PARAMETERWIDGETPOOL_H_
+
+#include <QHash>
+#include <QList>
+#include <QPointer>
+#include <QWidget>
+
+/**
+ * @brief Widgets given back by deleted parameters, reused by the parameters
+ *        of the next selected filter instead of being created again.
+ *
+ *  Pooled widgets stay children of the parameters widget, hidden, and
+ *  are deleted with it.
+ */
+class ParameterWidgetPool
+{
+public:
+  template<typename T> static T * take(QWidget * parent);
+
+  /**
+   * @brief Give back a widget, disconnecting it from its owner
+   *        (deleted if the pool is full or the widget is null).
+   */
+  static void recycle(QWidget * widget, QObject * owner);
+
+private:
+  static const int MaxWidgetsPerType = 64;
+  static QHash<const QMetaObject*,QList<QPointer<QWidget>>> _widgets;
+};
+
+template<typename T>
+T * ParameterWidgetPool::take(QWidget * parent)
+{
+  QList<QPointer<QWidget>> & list = _widgets[&T::staticMetaObject];
+  while ( ! list.isEmpty() ) {
+    QWidget * widget = list.takeLast();
+    if ( widget ) {
+      if ( widget->parentWidget() != parent ) {
+        widget->setParent(parent);
+      }
+      widget->show();
+      return static_cast<T*>(widget);
+    }
+  }
+  return new T(parent);
+}
+
+#endif // _GMIC_QT_PARAMETERWIDGETPOOL_H_
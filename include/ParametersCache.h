@@ -25,15 +25,29 @@
 #ifndef _GMIC_QT_PARAMETERSCACHE_H
 #define _GMIC_QT_PARAMETERSCACHE_H
 
+#include <QByteArray>
 #include <QHash>
 #include <QString>
 #include <QList>
+#include <QMutex>
 #include "InOutPanel.h"
 
+/**
+ * @brief Last parameters and Input/Output states of the filters.
+ *
+ *  Stored in the UserCatalog: every change is written immediately,
+ *  and the catalog is only opened on first access.
+ *  All methods are thread safe.
+ */
 class ParametersCache {
 public:
   static void load(bool loadFiltersParameters);
-  static void save();
+
+  /**
+   * @brief Open the catalog ahead of first access (e.g. from a worker
+   *        thread). An access meanwhile waits for it to be done.
+   */
+  static void preload();
   static void setValues(const QString & hash, const QList<QString> & values );
   static QList<QString> getValues(const QString & hash );
   static void remove( const QString & hash );
@@ -43,9 +57,21 @@ public:
 
   static void cleanup(const QSet<QString> & hashesToKeep);
 
+  /**
+   * @brief Catalog records equivalent to the previous parameters files
+   */
+  static void importLegacyFiles(QHash<QByteArray,QByteArray> & records);
+
 private:
+  static bool openCatalog();
+  static void importLegacyFile(const QString & filename, QHash<QByteArray,QByteArray> & records);
   static QHash<QString,QList<QString>> _parametersCache;
   static QHash<QString,InOutPanel::State> _inOutPanelStates;
+  static bool _catalogOpened;
+  static bool _loadFiltersParameters;
+  // Recursive: cleanup() calls remove(). Not taken by importLegacyFiles(),
+  // which is called with the UserCatalog lock held.
+  static QMutex _mutex;
 };
 
 #endif // _GMIC_QT_PARAMETERSCACHE_H
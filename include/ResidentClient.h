@@ -0,0 +1,108 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file ResidentClient.h
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef _GMIC_QT_RESIDENTCLIENT_H_
+#define _GMIC_QT_RESIDENTCLIENT_H_
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QScopedPointer>
+#include <QTime>
+#include <QTimer>
+#include "gmic_qt.h"
+
+class QLocalSocket;
+class QSharedMemory;
+
+namespace cimg_library {
+template<typename T> struct CImgList;
+}
+
+class ResidentClient : public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit ResidentClient(QObject * parent = 0);
+  ~ResidentClient();
+
+  /**
+   * @brief Send a job to a resident server, if one is listening.
+   *
+   * On success, images and imageNames are replaced by the output images
+   * before finished() is emitted, so they must outlive the job.
+   *
+   * @return false if no server could take the job, in which case the
+   *         caller should run the command in-process.
+   */
+  bool start(const QString & command,
+             const QString & commandPrefix,
+             const QString & arguments,
+             const QString & environment,
+             GmicQt::OutputMessageMode messageMode,
+             cimg_library::CImgList<float> & images,
+             cimg_library::CImgList<char> & imageNames);
+
+  QString gmicStatus() const;
+  /**
+   * @brief Error message of the G'MIC interpreter, or a timeout (empty on success)
+   */
+  QString errorMessage() const;
+  bool aborted() const;
+  int duration() const;
+
+public slots:
+  void cancel();
+
+signals:
+  /**
+   * @brief The server answered, or the job was canceled or timed out.
+   */
+  void finished();
+  /**
+   * @brief The server went away before answering: the job should run in-process.
+   */
+  void failed();
+
+private slots:
+  void onReadyRead();
+  void onDisconnected();
+  void onTimeout();
+
+private:
+  void stop();
+  QLocalSocket * _socket;
+  QScopedPointer<QSharedMemory> _input;
+  QByteArray _buffer;
+  QTimer _timer;
+  QTime _startTime;
+  cimg_library::CImgList<float> * _images;
+  cimg_library::CImgList<char> * _imageNames;
+  QString _gmicStatus;
+  QString _errorMessage;
+  bool _aborted;
+};
+
+#endif // _GMIC_QT_RESIDENTCLIENT_H_
@@ -0,0 +1,130 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file ResidentServer.h
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef _GMIC_QT_RESIDENTSERVER_H_
+#define _GMIC_QT_RESIDENTSERVER_H_
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include "gmic_qt.h"
+#include "InterpreterState.h"
+
+class QLocalServer;
+class QLocalSocket;
+class QSharedMemory;
+class FilterThread;
+struct gmic;
+
+namespace cimg_library {
+template<typename T> struct CImgList;
+}
+
+/*
+ * Messages exchanged between a ResidentClient and a ResidentServer are
+ * length-prefixed QDataStream blocks. Pixels never travel through the socket:
+ * they are stored in a shared memory segment whose key and layout
+ * (width, height, depth, spectrum and name of each image) are sent instead.
+ *
+ * Request  : magic, version, host, command, command prefix, arguments,
+ *            environment, message mode, input segment key, layout
+ * Response : magic, version, error message, gmic status,
+ *            output segment key, layout
+ */
+namespace ResidentProtocol {
+const quint32 Magic = 0x474d5152; // "GMQR"
+const quint32 Version = 1;
+const int JobTimeout = 30 * 60 * 1000; // ms without an answer before a client gives up
+QString serverName();
+bool writeMessage(QLocalSocket & socket, const QByteArray & message);
+/**
+ * @brief Extract the first complete message from data received so far.
+ * @return false if the buffer does not hold a complete message yet.
+ */
+bool takeMessage(QByteArray & buffer, QByteArray & message);
+/**
+ * @brief Copy images to a new shared memory segment (none if there are no pixels).
+ * @return false if the segment could not be created.
+ */
+bool storeImages(const cimg_library::CImgList<float> & images,
+                 const cimg_library::CImgList<char> & imageNames,
+                 QByteArray & layout,
+                 QSharedMemory * & memory);
+bool loadImages(const QString & key,
+                const QByteArray & layout,
+                cimg_library::CImgList<float> & images,
+                cimg_library::CImgList<char> & imageNames);
+}
+
+class ResidentServer : public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit ResidentServer(QObject * parent = 0);
+  ~ResidentServer();
+
+  /**
+   * @brief Load the stdlib and start listening for jobs.
+   *
+   * Jobs are queued and run one at a time in a FilterThread, always in the
+   * same interpreter so that the stdlib is parsed once. Variables and
+   * verbosity are reset between jobs, and a job is aborted when its
+   * client disconnects. The stdlib is assembled again whenever the
+   * StdlibCache stamp shows that its sources changed.
+   *
+   * @return false if another server is already running or if
+   *         the local socket could not be created.
+   */
+  bool start();
+
+public slots:
+  void onNewConnection();
+  void onReadyRead();
+  void onDisconnected();
+  void onJobFinished();
+
+private:
+  void startNextJob();
+  void sendResponse(QLocalSocket * socket,
+                    const QString & error,
+                    const QString & status,
+                    const cimg_library::CImgList<float> & images,
+                    const cimg_library::CImgList<char> & imageNames);
+  void loadStdlib();
+  QLocalServer * _server;
+  QString _stdlibStamp;
+  gmic * _interpreter;
+  InterpreterState _interpreterState;
+  FilterThread * _job;
+  QLocalSocket * _jobSocket;
+  QList<QPair<QLocalSocket*,QByteArray> > _queue;
+  QHash<QLocalSocket*,QByteArray> _buffers;
+  QHash<QLocalSocket*,QSharedMemory*> _outputs;
+};
+
+#endif // _GMIC_QT_RESIDENTSERVER_H_
@@ -0,0 +1,60 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file SharedMemoryPool.h
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef _GMIC_QT_SHAREDMEMORYPOOL_H_
+#define _GMIC_QT_SHAREDMEMORYPOOL_H_
+
+#include <QList>
+#include <QtGlobal>
+class QSharedMemory;
+
+/**
+ * @brief Segments holding the output images sent to the host (Krita).
+ *        They are kept after the host has read them and reused by the
+ *        next outputs, instead of creating new ones each time.
+ */
+class SharedMemoryPool
+{
+public:
+  ~SharedMemoryPool();
+
+  /**
+   * @brief A segment of at least size bytes, created if no free one fits
+   * @return 0 if the segment could not be created
+   */
+  QSharedMemory * acquire(qint64 size);
+
+  /**
+   * @brief Make all the acquired segments free again (the host has read them)
+   */
+  void recycle();
+  void clear();
+
+private:
+  static qint64 sizeClass(qint64 size);
+  QList<QSharedMemory *> _free;
+  QList<QSharedMemory *> _used;
+};
+
+#endif // _GMIC_QT_SHAREDMEMORYPOOL_H_
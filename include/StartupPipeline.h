@@ -0,0 +1,124 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file StartupPipeline.h
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef _GMIC_QT_STARTUPPIPELINE_H_
+#define _GMIC_QT_STARTUPPIPELINE_H_
+
+#include <QObject>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QSet>
+#include <QString>
+#include <QThreadPool>
+#include "StoredFave.h"
+
+/**
+ * @brief Runs the independent startup steps concurrently.
+ *
+ *  Listing the filter sources, reading the faves, the filters visibility
+ *  and the parameters store run in worker threads while the window is
+ *  shown and the host is queried from the GUI thread. Once the network
+ *  downloads are over, the stdlib is assembled in a worker as well.
+ *  Workers only produce plain data (see takeStdlib() and takeFaves()):
+ *  the Updater is only used from the GUI thread.
+ *  finished() is emitted when all steps, including the ones held by
+ *  the GUI thread (see hold() and release()), are done.
+ *
+ *  Every step is recorded in a timeline, see timeline().
+ */
+class StartupPipeline : public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit StartupPipeline(QObject * parent = 0);
+  ~StartupPipeline();
+
+  void start(int ageLimit, int timeout, bool useNetwork);
+  bool isRunning() const;
+  void waitForDone();
+
+  /**
+   * @brief Keep the pipeline from finishing until release() is called
+   *        with the same step name. GUI thread only.
+   */
+  void hold(const QString & step);
+  void release(const QString & step);
+
+  /**
+   * @brief Record a step in the timeline (thread safe)
+   */
+  void mark(const QString & step);
+  QString timeline() const;
+
+  bool hasFaves() const;
+  QList<StoredFave> takeFaves();
+
+  /**
+   * @brief The assembled stdlib, once finished() has been emitted
+   */
+  QByteArray takeStdlib();
+
+signals:
+  void finished(bool downloadsOk);
+
+private slots:
+  void onTaskFinished(int task);
+  void onDownloadsFinished(bool ok);
+
+private:
+  enum Task { SourcesTask, FavesTask, VisibilityTask, ParametersTask, StdlibTask };
+  class Job;
+  static QString taskName(int task);
+  void run(Task task);
+  void execute(Task task);
+  void checkFinished();
+
+  struct TimelineEntry {
+    qint64 ms;
+    QString step;
+    bool mainThread;
+  };
+
+  QThreadPool _pool;
+  QSet<QString> _pending;
+  bool _running;
+  bool _downloadsOk;
+  int _ageLimit;
+  int _timeout;
+  bool _useNetwork;
+  QList<StoredFave> _faves;
+  bool _hasFaves;
+  QList<QString> _sources;
+  QMap<QString,bool> _sourceIsStdlib;
+  QByteArray _stdlib;
+  QElapsedTimer _clock;
+  mutable QMutex _timelineMutex;
+  QList<TimelineEntry> _timeline;
+};
+
+#endif // _GMIC_QT_STARTUPPIPELINE_H_
@@ -0,0 +1,68 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file StdlibCache.h
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef _GMIC_QT_STDLIBCACHE_H_
+#define _GMIC_QT_STDLIBCACHE_H_
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QString>
+
+/**
+ * @brief Keeps the filter sources list and the assembled stdlib across launches.
+ *
+ *  Both are stored in path_rc along with a manifest holding the G'MIC version
+ *  and the modification time and size of the files they were built from.
+ *  They are reused as long as none of these files changed.
+ */
+class StdlibCache
+{
+public:
+  static bool readSources(bool useNetwork, QList<QString> & sources, QMap<QString,bool> & isStdlib);
+  static void writeSources(bool useNetwork, const QList<QString> & sources, const QMap<QString,bool> & isStdlib);
+
+  /**
+   * @brief Cached stdlib assembled from the given local files.
+   * @return A null array if the cache is missing or outdated.
+   */
+  static QByteArray readStdlib(const QList<QString> & files);
+  static void writeStdlib(const QList<QString> & files, const QByteArray & stdlib);
+
+  /**
+   * @brief Modification stamp of the manifest and of the user file.
+   *        It changes whenever a previously built stdlib may be outdated.
+   */
+  static QString manifestStamp();
+
+private:
+  static QString stamp(const QString & filename);
+  static QJsonObject readManifest();
+  static void writeManifest(const QJsonObject & manifest);
+  static QMutex _mutex;
+};
+
+#endif // _GMIC_QT_STDLIBCACHE_H_
@@ -26,6 +26,8 @@
 #define _GMIC_QT_STOREDFAVE_H_
 
 #include <QString>
+#include <QByteArray>
+#include <QHash>
 #include <QList>
 #include <QStringList>
 #include <QTextStream>
@@ -55,11 +57,18 @@ public:
 
   static QList<StoredFave> importFaves();
   static QList<StoredFave> readFaves();
+  static bool writeFaves(const QList<StoredFave> & faves);
+
+  /**
+   * @brief Catalog records equivalent to the previous faves files
+   */
+  static void importLegacyFiles(QHash<QByteArray,QByteArray> & records);
 
   QJsonObject toJSONObject() const;
   static StoredFave fromJSONObject(const QJsonObject & object);
 
 private:
+  static QList<StoredFave> readLegacyFaves();
   QString _name;
   QString _originalName;
   QString _command;
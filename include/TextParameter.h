@@ -45,7 +45,7 @@ public:
   QString unquotedTextValue() const;
   void setValue(const QString & value);
   void reset();
-  void initFromText(const char * text, int & textLength);
+  void initFromDefinition(const ParameterDefinition & definition);
 
 signals:
   void valueChanged();
@@ -30,6 +30,7 @@
 #include <QList>
 #include <QSet>
 #include <QMap>
+#include <QHash>
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QSettings>
@@ -58,39 +59,82 @@ public:
    *        older than the given age limit (in hours). To force download
    *        of all the sources, set the age limit to zero.
    *
+   *        Requests are conditional (ETag / Last-Modified of the previous
+   *        download), interrupted downloads are resumed, at most
+   *        INTERNET_MAX_DOWNLOADS_KEY are run at once, and files are fetched
+   *        from INTERNET_MIRROR_KEY instead of their own URL if it is set.
+   *
    * @param ageLimit Delay bewteen 2 network updates in hours
    * @param timeout in seconds before aborting dowloads
    * @param useNetwork Enable internet access
    */
   void startUpdate(int ageLimit, int timeout, bool useNetwork);
 
+  /**
+   * @brief Same as startUpdate(), for sources that have already been
+   *        listed by updateSources() or given to setSources().
+   */
+  void startDownloads(int ageLimit, int timeout, bool useNetwork);
+
   QList<QString> errorMessages();
   QList<QString> remotesThatNeedUpdate(int ageLimit) const;
   bool someUpdatesNeeded(int ageLimit) const;
   bool allDownloadsOk() const;
   QList<QString> sources() const;
+
+  /**
+   * @brief Concatenation of all the sources, reused from the previous
+   *        launch when none of the source files changed (see StdlibCache).
+   */
   QByteArray buildFullStdlib() const;
 
+  /**
+   * @brief Same as above for a given list of sources. Does not use the
+   *        instance, hence may be called from a worker thread.
+   */
+  static QByteArray buildFullStdlib(const QList<QString> & sources, const QMap<QString,bool> & sourceIsStdlib);
+
   bool someNetworkUpdateAchieved() const;
 
 
-  void updateSources(bool useNetwork);
+  /**
+   * @brief List the filter sources (the list of the previous launch is
+   *        reused if useCache is true and nothing changed since).
+   */
+  void updateSources(bool useNetwork, bool useCache = true);
+
+  /**
+   * @brief What updateSources() does, into the given containers rather
+   *        than the instance, hence callable from a worker thread.
+   *        See setSources().
+   */
+  static void listSources(bool useNetwork, bool useCache,
+                          QList<QString> & sources, QMap<QString,bool> & sourceIsStdlib);
+  void setSources(const QList<QString> & sources, const QMap<QString,bool> & sourceIsStdlib);
 
 signals:
   void downloadsFinished(bool ok);
 
 public slots:
   void onNetworkReplyFinished(QNetworkReply*);
+  void onNetworkReplyReadyRead();
   void notifyAllDowloadsOK();
   void onDownloadsTimeout();
 
 protected:
   void processReply(QNetworkReply *reply);
+  void savePartialDownload(QNetworkReply * reply);
 
 private:
 
   static QString localFilename(QString url);
   bool isStdlib( const QString & source ) const;
+  static bool isStdlib(const QString & source, const QMap<QString,bool> & sourceIsStdlib);
+  static QByteArray assembleStdlib(const QList<QString> & sources, const QMap<QString,bool> & sourceIsStdlib);
+  void startQueuedDownloads();
+  QNetworkRequest buildRequest(const QString & source) const;
+  QDateTime lastCheck(const QString & source) const;
+  static QString validatorKey(const QString & source, const char * name);
 
   explicit Updater(QObject * parent);
   static QByteArray cimgzDecompress(QByteArray array);
@@ -103,6 +147,10 @@ private:
   QList<QString> _sources;
   QMap<QString,bool> _sourceIsStdLib;
   QSet<QNetworkReply*> _pendingReplies;
+  QHash<QNetworkReply*,QByteArray> _receivedData;
+  QList<QString> _queuedSources;
+  QString _mirror;
+  int _maxConcurrentDownloads;
   QList<QString> _errorMessages;
   bool _someNetworkUpdatesAchieved;
 };
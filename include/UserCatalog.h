@@ -0,0 +1,84 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file UserCatalog.h
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef _GMIC_QT_USERCATALOG_H_
+#define _GMIC_QT_USERCATALOG_H_
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include "KeyValueStore.h"
+
+/**
+ * @brief The single file holding user data about filters.
+ *
+ *  Keys are indexed by filter hash:
+ *    "p/<hash>" last parameters (see ParametersCache)
+ *    "s/<hash>" Input/Output state (see ParametersCache)
+ *    "v/<hash>" hidden filter (see FiltersVisibilityMap)
+ *  and "faves" holds the list of faves (see StoredFave).
+ *
+ *  The catalog replaces the previous visibility, faves and parameters
+ *  files, which are imported once when the catalog is first created.
+ *  All methods are thread safe.
+ */
+class UserCatalog
+{
+public:
+  static const int Version = 1;
+
+  /**
+   * @brief Open the catalog, creating it from the previous files if needed.
+   * @return false if the catalog cannot be used (e.g. unwritable directory)
+   */
+  static bool open();
+
+  /**
+   * @brief Close the catalog, reclaiming the space of outdated records.
+   */
+  static void close();
+
+  static bool contains(const QByteArray & key);
+  static QByteArray value(const QByteArray & key);
+  static QList<QByteArray> keys(const QByteArray & prefix);
+  static bool insert(const QByteArray & key, const QByteArray & value);
+  static bool remove(const QByteArray & key);
+
+  /**
+   * @brief Apply several changes at once (see KeyValueStore::write())
+   */
+  static bool write(const QHash<QByteArray,QByteArray> & inserts,
+                    const QList<QByteArray> & removals = QList<QByteArray>());
+
+private:
+  static bool openStore();
+  static void importLegacyFiles();
+  static KeyValueStore _store;
+  static bool _opened;
+  static QMutex _mutex;
+  UserCatalog() = delete;
+};
+
+#endif // _GMIC_QT_USERCATALOG_H_
@@ -93,4 +93,6 @@ int launchPluginHeadlessUsingLastParameters();
 
 int launchPluginHeadless(const char * command, GmicQt::InputMode input, GmicQt::OutputMode output);
 
+int launchPluginServer();
+
 #endif // _GMIC_QT_GMIC_QT_H_
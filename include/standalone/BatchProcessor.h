@@ -0,0 +1,147 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file BatchProcessor.h
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef _GMIC_QT_BATCHPROCESSOR_H_
+#define _GMIC_QT_BATCHPROCESSOR_H_
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QDir>
+#include <QMutex>
+#include <QSet>
+#include "gmic_qt.h"
+
+struct BatchItem;
+
+/**
+ * @brief Non-interactive processing of a set of image files with a
+ *        single filter, used by the standalone host (--batch).
+ *
+ *  Files go through a pipeline of stages (decode, convert, filter, encode)
+ *  connected by bounded queues, so that I/O and computations overlap while
+ *  the number of images held in memory stays bounded. Each filter thread
+ *  keeps its own G'MIC interpreter, whose variables and verbosity are reset
+ *  before each file.
+ *
+ *  Parameters are still read through parameter widgets, hence the
+ *  QApplication. Unless QT_QPA_PLATFORM says otherwise, it runs on the
+ *  offscreen platform, so that no display is needed.
+ */
+class BatchProcessor : public QObject
+{
+  Q_OBJECT
+
+public:
+  enum Stage {
+    Decode,
+    Convert,
+    Filter,
+    Encode,
+    StageCount
+  };
+
+  explicit BatchProcessor(QObject * parent = 0);
+  ~BatchProcessor();
+
+  /**
+   * @brief Parse the command line and run a whole batch.
+   * @return The process exit status
+   */
+  static int launch(int argc, char * argv[]);
+
+  /**
+   * @brief Add a filter (or a fave) given its name, its command or its hash.
+   *        Successive filters are chained in a single interpreter pass.
+   * @param filter
+   * @param arguments Used instead of the filter's last/default parameters if not null
+   * @param errorMessage
+   * @return true if the filter was found
+   */
+  bool addFilter(const QString & filter, const QString & arguments, QString & errorMessage);
+
+  /**
+   * @brief Use a raw G'MIC pipeline (e.g. "blur 3 sharpen 100") instead of a filter.
+   */
+  void setCommand(const QString & command);
+
+  /**
+   * @brief Add input files from a directory, a single file or a wildcard pattern
+   * @return The number of files added
+   */
+  int addInput(const QString & input);
+
+  bool setOutputDirectory(const QString & path, QString & errorMessage);
+  void setJobs(int jobs);
+  int jobs() const;
+  int fileCount() const;
+
+  /**
+   * @brief Process all input files (blocking)
+   * @return The number of files that could not be processed
+   */
+  int run();
+
+  /**
+   * @brief Run one stage of the pipeline on an item. Called from stage threads.
+   */
+  void process(Stage stage, BatchItem * item);
+
+  /**
+   * @brief Report and release an item that went through the whole pipeline.
+   */
+  void finish(BatchItem * item);
+
+  static const char * stageName(Stage stage);
+
+private:
+  int stageThreadCount(Stage stage) const;
+  /**
+   * @brief Reserve the output name of an input file, unique among the files
+   *        written by this run and never the name of an existing file.
+   *        Called in input order before the pipeline starts.
+   */
+  QString reserveOutputFilename(const QString & inputFilename);
+  /**
+   * @brief Name of the output file of one image, derived from a reserved name
+   *        when a file produces several images.
+   */
+  QString outputFilename(const QString & reservedFilename, int imageIndex, int imageCount);
+  void report(const QString & text);
+  QString _filterName;
+  QString _command;
+  QString _arguments;
+  QString _commandPrefix;
+  QString _environment;
+  QStringList _files;
+  QSet<QString> _outputFiles;
+  QDir _outputDirectory;
+  int _jobs;
+  QMutex _mutex;
+  int _failures;
+  qint64 _pixels;
+  qint64 _busyTime[StageCount];
+};
+
+#endif // _GMIC_QT_BATCHPROCESSOR_H_
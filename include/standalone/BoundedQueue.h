@@ -0,0 +1,171 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file BoundedQueue.h
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef _GMIC_QT_BOUNDEDQUEUE_H_
+#define _GMIC_QT_BOUNDEDQUEUE_H_
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWaitCondition>
+#include <QQueue>
+#include <QElapsedTimer>
+
+/**
+ * @brief A blocking FIFO with a maximum size, used between the stages
+ *        of the batch pipeline. A full queue blocks its producers
+ *        (back-pressure), an empty one blocks its consumers until
+ *        something is pushed or the queue is closed.
+ *
+ *  Waiting times and the mean queue length are recorded so that the
+ *  bottleneck of a pipeline can be identified.
+ */
+template<typename T>
+class BoundedQueue
+{
+public:
+  explicit BoundedQueue(int capacity);
+
+  /**
+   * @return false if the queue has been closed
+   */
+  bool push(const T & value);
+
+  /**
+   * @return false if the queue is closed and empty
+   */
+  bool pop(T & value);
+
+  /**
+   * @brief No more values will be pushed. Wakes up all waiting threads.
+   */
+  void close();
+
+  int capacity() const;
+  qint64 pushWaitTime() const;
+  qint64 popWaitTime() const;
+  double meanSize() const;
+
+private:
+  mutable QMutex _mutex;
+  QWaitCondition _notEmpty;
+  QWaitCondition _notFull;
+  QQueue<T> _queue;
+  const int _capacity;
+  bool _closed;
+  qint64 _pushWaitTime;
+  qint64 _popWaitTime;
+  qint64 _sizeSum;
+  qint64 _pushCount;
+};
+
+template<typename T>
+BoundedQueue<T>::BoundedQueue(int capacity)
+  : _capacity(capacity > 0 ? capacity : 1),
+    _closed(false),
+    _pushWaitTime(0),
+    _popWaitTime(0),
+    _sizeSum(0),
+    _pushCount(0)
+{
+}
+
+template<typename T>
+bool BoundedQueue<T>::push(const T & value)
+{
+  QMutexLocker locker(&_mutex);
+  if ( _queue.size() >= _capacity && !_closed ) {
+    QElapsedTimer timer;
+    timer.start();
+    while ( _queue.size() >= _capacity && !_closed ) {
+      _notFull.wait(&_mutex);
+    }
+    _pushWaitTime += timer.elapsed();
+  }
+  if ( _closed ) {
+    return false;
+  }
+  _queue.enqueue(value);
+  _sizeSum += _queue.size();
+  ++_pushCount;
+  _notEmpty.wakeOne();
+  return true;
+}
+
+template<typename T>
+bool BoundedQueue<T>::pop(T & value)
+{
+  QMutexLocker locker(&_mutex);
+  if ( _queue.isEmpty() && !_closed ) {
+    QElapsedTimer timer;
+    timer.start();
+    while ( _queue.isEmpty() && !_closed ) {
+      _notEmpty.wait(&_mutex);
+    }
+    _popWaitTime += timer.elapsed();
+  }
+  if ( _queue.isEmpty() ) {
+    return false;
+  }
+  value = _queue.dequeue();
+  _notFull.wakeOne();
+  return true;
+}
+
+template<typename T>
+void BoundedQueue<T>::close()
+{
+  QMutexLocker locker(&_mutex);
+  _closed = true;
+  _notEmpty.wakeAll();
+  _notFull.wakeAll();
+}
+
+template<typename T>
+int BoundedQueue<T>::capacity() const
+{
+  return _capacity;
+}
+
+template<typename T>
+qint64 BoundedQueue<T>::pushWaitTime() const
+{
+  QMutexLocker locker(&_mutex);
+  return _pushWaitTime;
+}
+
+template<typename T>
+qint64 BoundedQueue<T>::popWaitTime() const
+{
+  QMutexLocker locker(&_mutex);
+  return _popWaitTime;
+}
+
+template<typename T>
+double BoundedQueue<T>::meanSize() const
+{
+  QMutexLocker locker(&_mutex);
+  return _pushCount ? (_sizeSum / static_cast<double>(_pushCount)) : 0.0;
+}
+
+#endif // _GMIC_QT_BOUNDEDQUEUE_H_
@@ -22,10 +22,10 @@
  *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
  *
  */
-#include <cstring>
 #include "Common.h"
 #include <QDebug>
 #include "AbstractParameter.h"
+#include "ParameterDefinition.h"
 #include "IntParameter.h"
 #include "FloatParameter.h"
 #include "BoolParameter.h"
@@ -75,87 +75,48 @@ AbstractParameter::clear()
 }
 
 AbstractParameter *
-AbstractParameter::createFromText(const char *text, int & length, QString & error, QObject * parent)
+AbstractParameter::createFromDefinition(const ParameterDefinition & definition, QObject * parent)
 {
   AbstractParameter * result = 0;
-  QString line = text;
-  error.clear();
-
-#define PREFIX "^[^=]*\\s*=\\s*_?"
-  if ( QRegExp( PREFIX "int", Qt::CaseInsensitive).indexIn(line) == 0 ) {
+  const QString & type = definition.type;
+  if ( type == "int" ) {
     result = new IntParameter(parent);
-  } else if ( QRegExp(PREFIX "float", Qt::CaseInsensitive).indexIn(line) == 0 ) {
+  } else if ( type == "float" ) {
     result = new FloatParameter(parent);
-  } else if ( QRegExp(PREFIX "bool", Qt::CaseInsensitive).indexIn(line) == 0 ) {
+  } else if ( type == "bool" ) {
     result = new BoolParameter(parent);
-  } else if ( QRegExp(PREFIX "choice", Qt::CaseInsensitive).indexIn(line) == 0 ) {
+  } else if ( type == "choice" ) {
     result = new ChoiceParameter(parent);
-  } else if ( QRegExp(PREFIX "color", Qt::CaseInsensitive).indexIn(line) == 0 ) {
+  } else if ( type == "color" ) {
     result = new ColorParameter(parent);
-  } else if ( QRegExp(PREFIX "separator", Qt::CaseInsensitive).indexIn(line) == 0 ) {
+  } else if ( type == "separator" ) {
     result = new SeparatorParameter(parent);
-  } else if ( QRegExp(PREFIX "note", Qt::CaseInsensitive).indexIn(line) == 0 ) {
+  } else if ( type == "note" ) {
     result = new NoteParameter(parent);
-  } else if ( QRegExp(PREFIX "file", Qt::CaseInsensitive).indexIn(line) == 0
-              || QRegExp(PREFIX "filein", Qt::CaseInsensitive).indexIn(line) == 0
-              || QRegExp(PREFIX "fileout", Qt::CaseInsensitive).indexIn(line) == 0 ) {
+  } else if ( type == "file" || type == "filein" || type == "fileout" ) {
     result = new FileParameter(parent);
-  } else if ( QRegExp(PREFIX "folder", Qt::CaseInsensitive).indexIn(line) == 0 ) {
+  } else if ( type == "folder" ) {
     result = new FolderParameter(parent);
-  } else if ( QRegExp(PREFIX "text", Qt::CaseInsensitive).indexIn(line) == 0 ) {
+  } else if ( type == "text" ) {
     result = new TextParameter(parent);
-  } else if ( QRegExp(PREFIX "link", Qt::CaseInsensitive).indexIn(line) == 0 ) {
+  } else if ( type == "link" ) {
     result = new LinkParameter(parent);
-  } else if ( QRegExp(PREFIX "value", Qt::CaseInsensitive).indexIn(line) == 0 ) {
+  } else if ( type == "value" ) {
     result = new ConstParameter(parent);
-  } else if ( QRegExp(PREFIX "button", Qt::CaseInsensitive).indexIn(line) == 0 ) {
+  } else if ( type == "button" ) {
     result = new ButtonParameter(parent);
   }
   if ( result ) {
-    result->initFromText(text,length);
-  } else {
-    if ( !line.isEmpty() ) {
-      error = QString("AbstractParameter::createFromtext(): Parse error: %1").arg(line);
-    }
+    result->initFromDefinition(definition);
   }
   return result;
 }
 
 QStringList
-AbstractParameter::parseText(const QString & type, const char * text, int & length)
+AbstractParameter::parseDefinition(const ParameterDefinition & definition)
 {
+  _update = definition.update;
   QStringList result;
-  QString str = text;
-  result << str.left(str.indexOf("=")).trimmed();
-
-  QRegExp re( QString("^[^=]*\\s*=\\s*(_?)%1\\s*(.)").arg(type), Qt::CaseInsensitive );
-  re.indexIn(str);
-  int prefixLength = re.matchedLength();
-
-  if ( re.cap(1) == "_" ) {
-    _update = false;
-  }
-
-  QString open = re.cap(2);
-  const char * end = 0;
-  if ( open == "(" ) {
-    end = strstr(text + prefixLength,")");
-  } else if ( open == "{") {
-    end = strstr(text + prefixLength,"}");
-  } else if ( open == "[") {
-    end = strstr(text + prefixLength,"]");
-  }
-  QString values = str.mid(prefixLength,-1).left(end-(text+prefixLength)).trimmed();
-  length = 1 + end - text;
-  while ( text[length] && (text[length] == ',' || str[length].isSpace() ) ) {
-    ++length;
-  }
-  result << values;
+  result << definition.name << definition.values;
   return result;
 }
-
-bool AbstractParameter::matchType(const QString & type, const char * text) const
-{
-  return QString(text).contains(QRegExp(QString("^[^=]*\\s*=\\s*_?%1\\s*.").arg(type),
-                                        Qt::CaseInsensitive));
-}
@@ -31,6 +31,7 @@
 #include <QPalette>
 #include "DialogSettings.h"
 #include "HtmlTranslator.h"
+#include "ParameterWidgetPool.h"
 
 BoolParameter::BoolParameter(QObject *parent)
   : AbstractParameter(parent,true),
@@ -43,7 +44,7 @@ BoolParameter::BoolParameter(QObject *parent)
 
 BoolParameter::~BoolParameter()
 {
-  delete _checkBox;
+  ParameterWidgetPool::recycle(_checkBox,this);
   delete _label;
 }
 
@@ -52,9 +53,10 @@ BoolParameter::addTo(QWidget * widget, int row)
 {
   QGridLayout * grid = dynamic_cast<QGridLayout*>(widget->layout());
   if (! grid) return;
-  delete _checkBox;
+  ParameterWidgetPool::recycle(_checkBox,this);
   delete _label;
-  _checkBox = new QCheckBox(_name,widget);
+  _checkBox = ParameterWidgetPool::take<QCheckBox>(widget);
+  _checkBox->setText(_name);
   _checkBox->setChecked(_value);
   if ( DialogSettings::darkThemeEnabled() ) {
     QPalette p = _checkBox->palette();
@@ -97,9 +99,9 @@ BoolParameter::onCheckBoxChanged(bool on)
 }
 
 void
-BoolParameter::initFromText(const char *text, int & textLength)
+BoolParameter::initFromDefinition(const ParameterDefinition & definition)
 {
-  QList<QString> list = parseText("bool",text,textLength);
+  QList<QString> list = parseDefinition(definition);
   _name = HtmlTranslator::html2txt(list[0]);
   _value = _default = ( list[1].startsWith("true") || list[1].startsWith("1") );
 }
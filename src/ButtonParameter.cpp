@@ -87,9 +87,9 @@ ButtonParameter::onPushButtonClicked(bool )
 }
 
 void
-ButtonParameter::initFromText(const char *text, int & textLength)
+ButtonParameter::initFromDefinition(const ParameterDefinition & definition)
 {
-  QList<QString> list = parseText("button",text,textLength);
+  QList<QString> list = parseDefinition(definition);
   _text = HtmlTranslator::html2txt(list[0]);
   QString & alignment = list[1];
   if ( alignment.isEmpty() ) {
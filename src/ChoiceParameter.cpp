@@ -29,6 +29,7 @@
 #include <QComboBox>
 #include <QLabel>
 #include "HtmlTranslator.h"
+#include "ParameterWidgetPool.h"
 
 ChoiceParameter::ChoiceParameter(QObject * parent)
   : AbstractParameter(parent,true),
@@ -41,8 +42,8 @@ ChoiceParameter::ChoiceParameter(QObject * parent)
 
 ChoiceParameter::~ChoiceParameter()
 {
-  delete _comboBox;
-  delete _label;
+  ParameterWidgetPool::recycle(_comboBox,this);
+  ParameterWidgetPool::recycle(_label,this);
 }
 
 void
@@ -50,14 +51,16 @@ ChoiceParameter::addTo(QWidget * widget, int row)
 {
   QGridLayout * grid = dynamic_cast<QGridLayout*>(widget->layout());
   if (! grid) return;
-  delete _comboBox;
-  delete _label;
+  ParameterWidgetPool::recycle(_comboBox,this);
+  ParameterWidgetPool::recycle(_label,this);
 
-  _comboBox = new QComboBox(widget);
+  _comboBox = ParameterWidgetPool::take<QComboBox>(widget);
   _comboBox->addItems(_choices);
   _comboBox->setCurrentIndex(_value);
 
-  grid->addWidget(_label = new QLabel(_name,widget),row,0,1,1);
+  _label = ParameterWidgetPool::take<QLabel>(widget);
+  _label->setText(_name);
+  grid->addWidget(_label,row,0,1,1);
   grid->addWidget(_comboBox,row,1,1,2);
   connect(_comboBox, SIGNAL(currentIndexChanged(int)),
           this, SLOT(onComboBoxIndexChanged(int)));
@@ -85,9 +88,9 @@ ChoiceParameter::reset()
   _value = _default;
 }
 
-void ChoiceParameter::initFromText(const char * text, int & textLength)
+void ChoiceParameter::initFromDefinition(const ParameterDefinition & definition)
 {
-  QStringList list = parseText("choice",text,textLength);
+  QStringList list = parseDefinition(definition);
   _name = HtmlTranslator::html2txt(list[0]);
   _choices = list[1].split(QChar(','));
   bool ok;
@@ -0,0 +1,143 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file CimgzDecoder.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "CimgzDecoder.h"
+#include <QList>
+#include <QVector>
+#include <cstring>
+#include <limits>
+#include <zlib.h>
+
+namespace {
+
+bool nextLine(const char * & p, const char * end, QByteArray & line)
+{
+  const char * eol = static_cast<const char*>(std::memchr(p,'\n',end - p));
+  if ( !eol ) {
+    return false;
+  }
+  line = QByteArray(p,static_cast<int>(eol - p));
+  p = eol + 1;
+  return true;
+}
+
+struct CImgBlock {
+  const char * data;
+  quint64 size;           // Uncompressed size
+  quint64 compressedSize; // 0 if not compressed
+};
+
+}
+
+QByteArray CimgzDecoder::decode(const char * data, qint64 size, bool & supported)
+{
+  supported = false;
+  const char * p = data;
+  const char * const end = data + size;
+  QByteArray line;
+  do {
+    if ( !nextLine(p,end,line) ) {
+      return QByteArray();
+    }
+  } while ( line.startsWith('#') );
+  QList<QByteArray> header = line.simplified().split(' ');
+  bool ok = false;
+  const unsigned int count = header.isEmpty() ? 0 : header[0].toUInt(&ok);
+  if ( !ok || header.size() < 2 ) {
+    return QByteArray();
+  }
+  const QByteArray & type = header[1];
+  if ( type != "unsigned_char" && type != "uchar" && type != "char" && type != "bool" ) {
+    return QByteArray();
+  }
+
+  QVector<CImgBlock> blocks;
+  quint64 total = 0;
+  int width = -1, height = -1, spectrum = -1;
+  for ( unsigned int i = 0; i < count; ++i ) {
+    if ( !nextLine(p,end,line) ) {
+      return QByteArray();
+    }
+    QList<QByteArray> fields = line.simplified().split(' ');
+    if ( fields.size() < 4 ) {
+      return QByteArray();
+    }
+    quint64 dims[4];
+    for ( int d = 0; d < 4; ++d ) {
+      dims[d] = fields[d].toULongLong(&ok);
+      if ( !ok ) {
+        return QByteArray();
+      }
+    }
+    CImgBlock block;
+    block.data = p;
+    block.size = dims[0] * dims[1] * dims[2] * dims[3];
+    block.compressedSize = 0;
+    if ( !block.size ) {
+      continue;
+    }
+    if ( fields.size() > 4 && fields[4].startsWith('#') ) {
+      block.compressedSize = fields[4].mid(1).toULongLong(&ok);
+      if ( !ok ) {
+        return QByteArray();
+      }
+    }
+    const quint64 stored = block.compressedSize ? block.compressedSize : block.size;
+    if ( stored > static_cast<quint64>(end - p) ) {
+      return QByteArray();
+    }
+    p += stored;
+    if ( width == -1 ) {
+      width = dims[0];
+      height = dims[1];
+      spectrum = dims[3];
+    } else if ( int(dims[0]) != width || int(dims[1]) != height || dims[3] != 1 || spectrum != 1 ) {
+      // Appending along z would not be a mere concatenation
+      return QByteArray();
+    }
+    total += block.size;
+    blocks.push_back(block);
+  }
+  if ( total > static_cast<quint64>(std::numeric_limits<int>::max()) ) {
+    return QByteArray();
+  }
+  supported = true;
+
+  QByteArray result(static_cast<int>(total),Qt::Uninitialized);
+  char * out = result.data();
+  for ( const CImgBlock & block : blocks ) {
+    if ( block.compressedSize ) {
+      uLongf length = static_cast<uLongf>(block.size);
+      if ( uncompress(reinterpret_cast<Bytef*>(out),&length,
+                      reinterpret_cast<const Bytef*>(block.data),static_cast<uLong>(block.compressedSize)) != Z_OK
+           || length != block.size ) {
+        return QByteArray();
+      }
+    } else {
+      std::memcpy(out,block.data,block.size);
+    }
+    out += block.size;
+  }
+  return result;
+}
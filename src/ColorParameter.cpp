@@ -118,9 +118,9 @@ ColorParameter::reset()
   updateButtonColor();
 }
 
-void ColorParameter::initFromText(const char *text, int & textLength)
+void ColorParameter::initFromDefinition(const ParameterDefinition & definition)
 {
-  QList<QString> list = parseText("color",text,textLength);
+  QList<QString> list = parseDefinition(definition);
   _name = HtmlTranslator::html2txt(list[0]);
   QList<QString> channels = list[1].split(",");
   const int n = channels.size();
@@ -66,9 +66,9 @@ ConstParameter::reset()
   _value = _default;
 }
 
-void ConstParameter::initFromText(const char * text, int & textLength)
+void ConstParameter::initFromDefinition(const ParameterDefinition & definition)
 {
-  QStringList list = parseText("value",text,textLength);
+  QStringList list = parseDefinition(definition);
   _name = HtmlTranslator::html2txt(list[0]);
   _value = _default = list[1];
 }
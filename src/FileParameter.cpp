@@ -35,6 +35,7 @@
 #include <QApplication>
 #include "DialogSettings.h"
 #include "HtmlTranslator.h"
+#include "ParameterDefinition.h"
 
 FileParameter::FileParameter(QObject *parent)
   : AbstractParameter(parent,true),
@@ -107,17 +108,14 @@ FileParameter::reset()
   setValue(_default);
 }
 
-void FileParameter::initFromText(const char * text, int & textLength)
+void FileParameter::initFromDefinition(const ParameterDefinition & definition)
 {
-  QList<QString> list;
-  if ( matchType("filein",text) ) {
-    list = parseText("filein",text,textLength);
+  QList<QString> list = parseDefinition(definition);
+  if ( definition.type == "filein" ) {
     _dialogMode = InputMode;
-  } else if ( matchType("fileout",text) ) {
-    list = parseText("fileout",text,textLength);
+  } else if ( definition.type == "fileout" ) {
     _dialogMode = OutputMode;
   } else {
-    list = parseText("file",text,textLength);
     _dialogMode = InputOutputMode;
   }
   _name = HtmlTranslator::html2txt(list[0]);
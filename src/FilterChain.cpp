@@ -0,0 +1,89 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file FilterChain.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "FilterChain.h"
+#include <QStringList>
+
+FilterChain::FilterChain()
+{
+}
+
+void FilterChain::append(const QString & name,
+                         const QString & command,
+                         const QString & previewCommand,
+                         const QString & arguments)
+{
+  Entry entry;
+  entry.name = name;
+  entry.command = command;
+  entry.previewCommand = previewCommand;
+  entry.arguments = arguments;
+  _entries.push_back(entry);
+}
+
+void FilterChain::clear()
+{
+  _entries.clear();
+}
+
+bool FilterChain::isEmpty() const
+{
+  return _entries.isEmpty();
+}
+
+int FilterChain::size() const
+{
+  return _entries.size();
+}
+
+const FilterChain::Entry & FilterChain::at(int index) const
+{
+  return _entries.at(index);
+}
+
+QString FilterChain::names() const
+{
+  QStringList list;
+  for ( const Entry & entry : _entries ) {
+    list.push_back(entry.name);
+  }
+  return list.join(" > ");
+}
+
+QString FilterChain::commandLine(bool preview) const
+{
+  QStringList list;
+  for ( const Entry & entry : _entries ) {
+    QString command = entry.command;
+    if ( preview && !entry.previewCommand.isEmpty() && entry.previewCommand != "_none_" ) {
+      // Filters without a preview command are previewed with their full command
+      command = entry.previewCommand;
+    }
+    if ( command.isEmpty() || command == "_none_" ) {
+      continue;
+    }
+    list.push_back(QString("-%1 %2").arg(command).arg(entry.arguments));
+  }
+  return list.join(" ");
+}
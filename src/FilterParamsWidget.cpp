@@ -25,7 +25,9 @@
 #include "Common.h"
 #include "FilterParamsWidget.h"
 #include "AbstractParameter.h"
+#include "ParameterDefinition.h"
 #include <QGridLayout>
+#include <QHash>
 #include <QLabel>
 #include <QVBoxLayout>
 #include <QDebug>
@@ -36,6 +38,7 @@
 FilterParamsWidget::FilterParamsWidget(QWidget * parent)
   : QWidget(parent),
     _valueString(""),
+    _valueFingerprint(0),
     _labelNoParams(0),
     _paddingWidget(0)
 {
@@ -57,9 +60,7 @@ FilterParamsWidget::build(const FiltersTreeAbstractFilterItem *item, const QList
   _previewCommand = item->previewCommand();
   _filterHash = item->hash();
   clear();
-  delete layout();
-  QGridLayout * grid = new QGridLayout(this);
-  grid->setRowStretch(1,2);
+  QGridLayout * grid = resetLayout();
 
   QList<QString> savedValues;
 
@@ -75,24 +76,20 @@ FilterParamsWidget::build(const FiltersTreeAbstractFilterItem *item, const QList
     savedValues = values;
   }
 
-  AbstractParameter * parameter;
-  QByteArray rawText = item->parameters().toLatin1();
-  const char * cstr = rawText.constData();
-  int length;
+  QString error;
+  const QVector<ParameterDefinition> definitions = ParameterDefinition::cachedParse(item->hash(),item->parameters(),error);
 
   // Build parameters and count actual ones
   _actualParametersCount = 0;
-  QString error;
-  do {
-    parameter = AbstractParameter::createFromText(cstr,length,error,this);
+  for ( int i = 0; i < definitions.size() && error.isEmpty(); ++i ) {
+    AbstractParameter * parameter = AbstractParameter::createFromDefinition(definitions[i],this);
     if (parameter) {
       _presetParameters.push_back(parameter);
       if ( parameter->isActualParameter()) {
         _actualParametersCount += 1;
       }
     }
-    cstr += length;
-  } while (parameter && error.isEmpty());
+  }
 
   if ( !error.isEmpty() ) {
     for ( AbstractParameter * p : _presetParameters) {
@@ -125,7 +122,7 @@ FilterParamsWidget::build(const FiltersTreeAbstractFilterItem *item, const QList
       grid->setRowStretch(row-1,0);
     }
     connect( *it, SIGNAL(valueChanged()),
-             this, SLOT(updateValueString()));
+             this, SLOT(onParameterValueChanged()));
     ++it;
   }
 
@@ -160,20 +157,38 @@ FilterParamsWidget::build(const FiltersTreeAbstractFilterItem *item, const QList
 void FilterParamsWidget::setNoFilter()
 {
   clear();
-  delete layout();
-  QGridLayout * grid = new QGridLayout(this);
-  grid->setRowStretch(1,2);
+  QGridLayout * grid = resetLayout();
 
   _labelNoParams = new QLabel(tr("<i>Select a filter</i>"),this);
   _labelNoParams->setAlignment(Qt::AlignHCenter|Qt::AlignCenter);
   grid->addWidget(_labelNoParams,0,0,4,3);
 
   _valueString.clear();
+  _valueFingerprint = 0;
   _command.clear();
   _previewCommand.clear();
   _filterHash.clear();
 }
 
+QGridLayout * FilterParamsWidget::resetLayout()
+{
+  // The grid is emptied and reused rather than rebuilt
+  QGridLayout * grid = dynamic_cast<QGridLayout*>(layout());
+  if ( ! grid ) {
+    delete layout();
+    grid = new QGridLayout(this);
+  }
+  QLayoutItem * item;
+  while ( (item = grid->takeAt(0)) ) {
+    delete item;
+  }
+  for ( int row = 0; row < grid->rowCount(); ++row ) {
+    grid->setRowStretch(row,0);
+  }
+  grid->setRowStretch(1,2);
+  return grid;
+}
+
 FilterParamsWidget::~FilterParamsWidget()
 {
   clear();
@@ -185,6 +200,11 @@ FilterParamsWidget::valueString() const
   return _valueString;
 }
 
+uint FilterParamsWidget::valueFingerprint() const
+{
+  return _valueFingerprint;
+}
+
 QStringList
 FilterParamsWidget::valueStringList() const
 {
@@ -252,25 +272,63 @@ QString FilterParamsWidget::filterHash() const
 void
 FilterParamsWidget::updateValueString(bool notify)
 {
-  _valueString.clear();
-  bool firstParameter = true;
+  _serializedValues.resize(_presetParameters.size());
+  _serializedValuesHashes.resize(_presetParameters.size());
   for (int i = 0; i < _presetParameters.size(); ++i) {
-    if ( _presetParameters[i]->isActualParameter() ) {
-      QString str = _presetParameters[i]->textValue();
-      if (!str.isNull()) {
-        if (!firstParameter) {
-          _valueString += ",";
-        }
-        _valueString += str;
-        firstParameter = false;
-      }
-    }
+    serializeValue(i);
   }
+  assembleValueString();
   if (notify) {
     emit valueChanged();
   }
 }
 
+void
+FilterParamsWidget::onParameterValueChanged()
+{
+  // Only the parameter which has changed is serialized again
+  const int index = _presetParameters.indexOf(qobject_cast<AbstractParameter*>(sender()));
+  if ( index == -1 || _serializedValues.size() != _presetParameters.size() ) {
+    updateValueString();
+    return;
+  }
+  serializeValue(index);
+  assembleValueString();
+  emit valueChanged();
+}
+
+void
+FilterParamsWidget::serializeValue(int index)
+{
+  AbstractParameter * parameter = _presetParameters[index];
+  _serializedValues[index] = parameter->isActualParameter() ? parameter->textValue() : QString();
+  _serializedValuesHashes[index] = qHash(_serializedValues[index]);
+}
+
+void
+FilterParamsWidget::assembleValueString()
+{
+  int size = 0;
+  for ( const QString & str : _serializedValues ) {
+    size += str.size() + 1;
+  }
+  _valueString.clear();
+  _valueString.reserve(size);
+  _valueFingerprint = 0;
+  bool firstParameter = true;
+  for (int i = 0; i < _serializedValues.size(); ++i) {
+    const QString & str = _serializedValues[i];
+    if (!str.isNull()) {
+      if (!firstParameter) {
+        _valueString += ",";
+      }
+      _valueString += str;
+      _valueFingerprint = 31 * _valueFingerprint + _serializedValuesHashes[i];
+      firstParameter = false;
+    }
+  }
+}
+
 void
 FilterParamsWidget::clear()
 {
@@ -280,6 +338,8 @@ FilterParamsWidget::clear()
     ++it;
   }
   _presetParameters.clear();
+  _serializedValues.clear();
+  _serializedValuesHashes.clear();
   _actualParametersCount = 0;
 
   delete _labelNoParams;
@@ -42,6 +42,7 @@ FilterThread::FilterThread(QObject *parent,
     _environment(environment),
     _images(new cimg_library::CImgList<float>),
     _imageNames(new cimg_library::CImgList<char>),
+    _interpreter(0),
     _name(name),
     _messageMode(mode)
 {
@@ -64,6 +65,18 @@ FilterThread::setArguments(const QString & str)
   _arguments = str;
 }
 
+void
+FilterThread::setCommandPrefix(const QString & prefix)
+{
+  _commandPrefix = prefix;
+}
+
+void
+FilterThread::setInterpreter(gmic * interpreter)
+{
+  _interpreter = interpreter;
+}
+
 void
 FilterThread::setInputImages(const cimg_library::CImgList<float> & list,
                              const cimg_library::CImgList<char> & imageNames)
@@ -120,7 +133,30 @@ QString FilterThread::name() const
 
 QString FilterThread::fullCommand() const
 {
-  return QString("-%1 %2").arg(_command).arg(_arguments);
+  QString command = QString("-%1 %2").arg(_command).arg(_arguments);
+  return _commandPrefix.isEmpty() ? command : QString("%1 %2").arg(_commandPrefix).arg(command);
+}
+
+QString FilterThread::buildCommandLine(const QString & command,
+                                       const QString & arguments,
+                                       GmicQt::OutputMessageMode mode,
+                                       const QString & commandPrefix)
+{
+  QString commandLine;
+  if ( mode == GmicQt::Quiet ) {
+    commandLine = QString("-v -");
+  } else if ( mode >= GmicQt::VerboseLayerName && mode <= GmicQt::VerboseLogFile ) {
+    commandLine = QString("-v -99");
+  } else if ( mode == GmicQt::VeryVerboseConsole || mode == GmicQt::VeryVerboseLogFile  ) {
+    commandLine = QString("-v 0");
+  } else if ( mode == GmicQt::DebugConsole || mode == GmicQt::DebugLogFile  ) {
+    commandLine = QString("-debug") ;
+  }
+  if ( ! commandPrefix.isEmpty() ) {
+    commandLine += QString(" %1").arg(commandPrefix);
+  }
+  commandLine += QString(" -%1 %2").arg(command).arg(arguments);
+  return commandLine;
 }
 
 void
@@ -141,16 +177,7 @@ FilterThread::run()
   }
   QString fullCommandLine;
   try {
-    if ( _messageMode == GmicQt::Quiet ) {
-      fullCommandLine = QString("-v -");
-    } else if ( _messageMode >= GmicQt::VerboseLayerName && _messageMode <= GmicQt::VerboseLogFile ) {
-      fullCommandLine = QString("-v -99");
-    } else if ( _messageMode == GmicQt::VeryVerboseConsole || _messageMode == GmicQt::VeryVerboseLogFile  ) {
-      fullCommandLine = QString("-v 0");
-    } else if ( _messageMode == GmicQt::DebugConsole || _messageMode == GmicQt::DebugLogFile  ) {
-      fullCommandLine = QString("-debug") ;
-    }
-    fullCommandLine += QString(" -%1 %2").arg(_command).arg(_arguments);
+    fullCommandLine = buildCommandLine(_command,_arguments,_messageMode,_commandPrefix);
     _gmicAbort = false;
     _gmicProgress = -1;
     if (_messageMode > GmicQt::Quiet) {
@@ -158,15 +185,27 @@ FilterThread::run()
       std::fflush(cimg::output());
     }
 
-    gmic gmicInstance(_environment.isEmpty() ? 0 : QString("-v - %1").arg(_environment).toLocal8Bit().constData(),
-                      GmicStdLibParser::GmicStdlib.constData(),true);
-    gmicInstance.set_variable("_host",GmicQt::HostApplicationShortname,'=');
-    gmicInstance.run(fullCommandLine.toLocal8Bit().constData(),
-                     *_images,
-                     *_imageNames,
-                     &_gmicProgress,
-                     &_gmicAbort);
-    _gmicStatus = gmicInstance.status;
+    if ( _interpreter ) {
+      if ( ! _environment.isEmpty() ) {
+        _interpreter->run(QString("-v - %1").arg(_environment).toLocal8Bit().constData(),*_images,*_imageNames);
+      }
+      _interpreter->run(fullCommandLine.toLocal8Bit().constData(),
+                        *_images,
+                        *_imageNames,
+                        &_gmicProgress,
+                        &_gmicAbort);
+      _gmicStatus = _interpreter->status;
+    } else {
+      gmic gmicInstance(_environment.isEmpty() ? 0 : QString("-v - %1").arg(_environment).toLocal8Bit().constData(),
+                        GmicStdLibParser::GmicStdlib.constData(),true);
+      gmicInstance.set_variable("_host",GmicQt::HostApplicationShortname,'=');
+      gmicInstance.run(fullCommandLine.toLocal8Bit().constData(),
+                       *_images,
+                       *_imageNames,
+                       &_gmicProgress,
+                       &_gmicAbort);
+      _gmicStatus = gmicInstance.status;
+    }
   } catch (gmic_exception & e) {
     _images->assign();
     _imageNames->assign();
@@ -0,0 +1,87 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file FiltersRegistry.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "FiltersRegistry.h"
+#include <QStandardItem>
+#include "FiltersTreeAbstractItem.h"
+#include "FiltersTreeFilterItem.h"
+#include "FiltersTreeFaveItem.h"
+
+FiltersRegistry::FiltersRegistry()
+{
+}
+
+void FiltersRegistry::clear()
+{
+  _filters.clear();
+  _faves.clear();
+}
+
+void FiltersRegistry::addItems(QStandardItem * folder)
+{
+  const int rows = folder->rowCount();
+  for ( int row = 0; row < rows; ++row ) {
+    QStandardItem * child = folder->child(row);
+    FiltersTreeAbstractFilterItem * item = FiltersTreeAbstractItem::toAbstractFilter(child);
+    if ( item ) {
+      add(item);
+    } else if ( FiltersTreeAbstractItem::isFolder(child) ) {
+      addItems(child);
+    }
+  }
+}
+
+void FiltersRegistry::add(FiltersTreeAbstractFilterItem * item)
+{
+  if ( FiltersTreeAbstractItem::isFave(item) ) {
+    _faves[item->hash()] = static_cast<FiltersTreeFaveItem*>(item);
+  } else if ( FiltersTreeAbstractItem::isFilter(item) ) {
+    _filters[item->hash()] = static_cast<FiltersTreeFilterItem*>(item);
+  }
+}
+
+void FiltersRegistry::remove(FiltersTreeAbstractFilterItem * item)
+{
+  if ( FiltersTreeAbstractItem::isFave(item) ) {
+    _faves.remove(item->hash());
+  } else {
+    _filters.remove(item->hash());
+  }
+}
+
+void FiltersRegistry::rehash(const QString & previousHash, FiltersTreeFaveItem * fave)
+{
+  _faves.remove(previousHash);
+  _faves[fave->hash()] = fave;
+}
+
+FiltersTreeFilterItem * FiltersRegistry::filter(const QString & hash) const
+{
+  return _filters.value(hash,0);
+}
+
+FiltersTreeFaveItem * FiltersRegistry::fave(const QString & hash) const
+{
+  return _faves.value(hash,0);
+}
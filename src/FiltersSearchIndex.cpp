@@ -0,0 +1,335 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file FiltersSearchIndex.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "FiltersSearchIndex.h"
+#include <QStandardItem>
+#include <QSettings>
+#include <QSet>
+#include <QPair>
+#include <algorithm>
+#include <cmath>
+#include "FiltersTreeAbstractFilterItem.h"
+#include "ParameterDefinition.h"
+
+namespace {
+const float FieldWeights[] = { 3.0f, 2.0f, 1.0f };
+const int MaxCachedWords = 64;
+}
+
+FiltersSearchIndex::FiltersSearchIndex()
+  : _usageLoaded(false)
+{
+}
+
+void FiltersSearchIndex::clear()
+{
+  _items.clear();
+  _hashes.clear();
+  _words.clear();
+  _wordIds.clear();
+  _postings.clear();
+  _prefixes.clear();
+  _trigrams.clear();
+  _matchesCache.clear();
+  _result.clear();
+}
+
+int FiltersSearchIndex::size() const
+{
+  return _items.size();
+}
+
+void FiltersSearchIndex::build(QStandardItem * root)
+{
+  clear();
+  if ( ! _usageLoaded ) {
+    loadUsage();
+  }
+  addItems(root);
+  for ( int id = 0; id < _words.size(); ++id ) {
+    const QString & word = _words[id];
+    for ( int length = 1; length <= word.length(); ++length ) {
+      // Ids are increasing, so lists remain sorted
+      _prefixes[word.left(length)].push_back(id);
+    }
+    for ( int i = 0; i + 3 <= word.length(); ++i ) {
+      QVector<int> & list = _trigrams[word.mid(i,3)];
+      if ( list.isEmpty() || list.back() != id ) {
+        list.push_back(id);
+      }
+    }
+  }
+}
+
+void FiltersSearchIndex::addItems(QStandardItem * folder)
+{
+  const int rows = folder->rowCount();
+  for ( int row = 0; row < rows; ++row ) {
+    QStandardItem * child = folder->child(row);
+    FiltersTreeAbstractFilterItem * filter = FiltersTreeAbstractItem::toAbstractFilter(child);
+    if ( ! filter ) {
+      addItems(child);
+      continue;
+    }
+    const int id = _items.size();
+    _items.push_back(filter);
+    _hashes.push_back(filter->hash());
+    QStringList path = filter->path();
+    path.removeLast();
+    addWords(id,words(filter->plainText()),NameField);
+    addWords(id,words(path.join(" ")),PathField);
+    addWords(id,words(parameterLabels(filter->parameters()).join(" ")),ParameterField);
+  }
+}
+
+void FiltersSearchIndex::addWords(int item, const QStringList & words, Field field)
+{
+  for ( const QString & word : words ) {
+    int id = _wordIds.value(word,-1);
+    if ( id == -1 ) {
+      id = _words.size();
+      _wordIds[word] = id;
+      _words.push_back(word);
+      _postings.push_back(QVector<Posting>());
+    }
+    QVector<Posting> & postings = _postings[id];
+    if ( postings.isEmpty() || postings.back().item != item ) {
+      postings.push_back(Posting{item,field});
+    } else if ( field < postings.back().field ) {
+      postings.back().field = field;
+    }
+  }
+}
+
+const QVector<FiltersTreeAbstractFilterItem*> & FiltersSearchIndex::search(const QString & query)
+{
+  _result.clear();
+  const QStringList queryWords = words(query);
+  if ( queryWords.isEmpty() ) {
+    return _result;
+  }
+  QHash<int,float> scores = matches(queryWords.front());
+  for ( int i = 1; i < queryWords.size() && !scores.isEmpty(); ++i ) {
+    const QHash<int,float> & wordScores = matches(queryWords[i]);
+    QHash<int,float>::iterator it = scores.begin();
+    while ( it != scores.end() ) {
+      QHash<int,float>::const_iterator match = wordScores.find(it.key());
+      if ( match == wordScores.end() ) {
+        it = scores.erase(it);
+      } else {
+        it.value() += match.value();
+        ++it;
+      }
+    }
+  }
+
+  QVector<QPair<float,int>> ranking;
+  ranking.reserve(scores.size());
+  const QDateTime now = QDateTime::currentDateTime();
+  for ( QHash<int,float>::const_iterator it = scores.constBegin(); it != scores.constEnd(); ++it ) {
+    ranking.push_back(qMakePair(-it.value() * usageBoost(it.key(),now),it.key()));
+  }
+  std::sort(ranking.begin(),ranking.end());
+  _result.reserve(ranking.size());
+  for ( const QPair<float,int> & entry : ranking ) {
+    _result.push_back(_items[entry.second]);
+  }
+  return _result;
+}
+
+const QHash<int,float> & FiltersSearchIndex::matches(const QString & word)
+{
+  QHash<QString,QHash<int,float>>::const_iterator cached = _matchesCache.find(word);
+  if ( cached != _matchesCache.end() ) {
+    return cached.value();
+  }
+  if ( _matchesCache.size() > MaxCachedWords ) {
+    _matchesCache.clear();
+  }
+
+  // Quality of each matching word of the vocabulary
+  QHash<int,float> wordQuality;
+  for ( int id : _prefixes.value(word) ) {
+    const float ratio = float(word.length()) / _words[id].length();
+    wordQuality[id] = 0.75f + 0.25f * ratio;
+  }
+  if ( word.length() >= 3 ) {
+    const int maxDistance = (word.length() <= 4) ? 1 : 2;
+    for ( int id : fuzzyCandidates(word,maxDistance) ) {
+      if ( wordQuality.contains(id) ) {
+        continue;
+      }
+      const int distance = prefixDistance(word,_words[id],maxDistance);
+      if ( distance <= maxDistance ) {
+        wordQuality[id] = 0.6f - 0.2f * distance;
+      }
+    }
+  }
+
+  QHash<int,float> & result = _matchesCache[word];
+  for ( QHash<int,float>::const_iterator it = wordQuality.constBegin(); it != wordQuality.constEnd(); ++it ) {
+    for ( const Posting & posting : _postings[it.key()] ) {
+      const float score = FieldWeights[posting.field] * it.value();
+      float & best = result[posting.item];
+      best = std::max(best,score);
+    }
+  }
+  return result;
+}
+
+QVector<int> FiltersSearchIndex::fuzzyCandidates(const QString & word, int maxDistance) const
+{
+  // Each edit destroys at most 3 trigrams of the word
+  const int trigramCount = word.length() - 2;
+  const int threshold = std::max(1,trigramCount - 3 * maxDistance);
+  QHash<int,int> shared;
+  QSet<QString> seen;
+  for ( int i = 0; i < trigramCount; ++i ) {
+    const QString trigram = word.mid(i,3);
+    if ( seen.contains(trigram) ) {
+      continue;
+    }
+    seen.insert(trigram);
+    for ( int id : _trigrams.value(trigram) ) {
+      ++shared[id];
+    }
+  }
+  QVector<int> candidates;
+  for ( QHash<int,int>::const_iterator it = shared.constBegin(); it != shared.constEnd(); ++it ) {
+    if ( it.value() >= threshold && _words[it.key()].length() >= word.length() - maxDistance ) {
+      candidates.push_back(it.key());
+    }
+  }
+  return candidates;
+}
+
+int FiltersSearchIndex::prefixDistance(const QString & word, const QString & text, int maxDistance)
+{
+  // Levenshtein distance between word and the closest prefix of text,
+  // abandoned as soon as it exceeds maxDistance.
+  const int n = text.length();
+  QVector<int> previous(n + 1);
+  QVector<int> current(n + 1);
+  for ( int j = 0; j <= n; ++j ) {
+    previous[j] = j;
+  }
+  for ( int i = 1; i <= word.length(); ++i ) {
+    current[0] = i;
+    int rowMin = i;
+    for ( int j = 1; j <= n; ++j ) {
+      const int cost = (word[i - 1] == text[j - 1]) ? 0 : 1;
+      current[j] = std::min(std::min(previous[j] + 1,current[j - 1] + 1),previous[j - 1] + cost);
+      rowMin = std::min(rowMin,current[j]);
+    }
+    if ( rowMin > maxDistance ) {
+      return rowMin;
+    }
+    previous.swap(current);
+  }
+  return *std::min_element(previous.constBegin(),previous.constEnd());
+}
+
+float FiltersSearchIndex::usageBoost(int item, const QDateTime & now) const
+{
+  QHash<QString,Usage>::const_iterator it = _usage.find(_hashes[item]);
+  if ( it == _usage.end() ) {
+    return 1.0f;
+  }
+  const qint64 days = it.value().last.daysTo(now);
+  return 1.0f + 0.2f * std::log(1.0f + it.value().count) + 0.3f * std::exp(-days / 30.0f);
+}
+
+void FiltersSearchIndex::recordUsage(const QString & hash)
+{
+  if ( ! _usageLoaded ) {
+    loadUsage();
+  }
+  Usage & usage = _usage[hash];
+  usage.count += 1;
+  usage.last = QDateTime::currentDateTime();
+  QSettings settings;
+  settings.setValue(QString("FiltersUsage/%1").arg(hash),
+                    QString("%1 %2").arg(usage.count).arg(usage.last.toString(Qt::ISODate)));
+}
+
+void FiltersSearchIndex::loadUsage()
+{
+  _usage.clear();
+  QSettings settings;
+  settings.beginGroup("FiltersUsage");
+  for ( const QString & hash : settings.childKeys() ) {
+    const QStringList fields = settings.value(hash).toString().split(QChar(' '));
+    if ( fields.size() == 2 ) {
+      Usage usage;
+      usage.count = fields[0].toInt();
+      usage.last = QDateTime::fromString(fields[1],Qt::ISODate);
+      _usage[hash] = usage;
+    }
+  }
+  settings.endGroup();
+  _usageLoaded = true;
+}
+
+QStringList FiltersSearchIndex::parameterLabels(const QString & parameters)
+{
+  QVector<ParameterDefinition> definitions;
+  QString error;
+  ParameterDefinition::parse(parameters,definitions,error);
+  QStringList labels;
+  for ( const ParameterDefinition & definition : definitions ) {
+    labels.push_back(definition.name);
+  }
+  return labels;
+}
+
+QString FiltersSearchIndex::normalize(const QString & text)
+{
+  QString decomposed = text.normalized(QString::NormalizationForm_KD);
+  QString result;
+  result.reserve(decomposed.size());
+  for ( const QChar & c : decomposed ) {
+    if ( c.category() != QChar::Mark_NonSpacing ) {
+      result.append(c.toLower());
+    }
+  }
+  return result;
+}
+
+QStringList FiltersSearchIndex::words(const QString & text)
+{
+  QStringList list;
+  QString word;
+  for ( const QChar & c : normalize(text) ) {
+    if ( c.isLetterOrNumber() ) {
+      word.append(c);
+    } else if ( ! word.isEmpty() ) {
+      list.push_back(word);
+      word.clear();
+    }
+  }
+  if ( ! word.isEmpty() ) {
+    list.push_back(word);
+  }
+  return list;
+}
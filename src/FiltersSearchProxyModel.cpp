@@ -0,0 +1,135 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file FiltersSearchProxyModel.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "FiltersSearchProxyModel.h"
+#include <QStandardItemModel>
+#include "FiltersTreeAbstractFilterItem.h"
+
+FiltersSearchProxyModel::FiltersSearchProxyModel(QObject * parent)
+  : QAbstractProxyModel(parent),
+    _model(0)
+{
+}
+
+void FiltersSearchProxyModel::setSourceModel(QStandardItemModel * model)
+{
+  beginResetModel();
+  if ( _model ) {
+    _model->disconnect(this);
+  }
+  _model = model;
+  _results.clear();
+  _rows.clear();
+  QAbstractProxyModel::setSourceModel(model);
+  // Results point to items of the model: drop them before any item goes away
+  connect(model,SIGNAL(rowsAboutToBeRemoved(QModelIndex,int,int)),
+          this,SLOT(clear()));
+  connect(model,SIGNAL(modelAboutToBeReset()),
+          this,SLOT(clear()));
+  connect(model,SIGNAL(dataChanged(QModelIndex,QModelIndex)),
+          this,SLOT(onSourceDataChanged(QModelIndex,QModelIndex)));
+  connect(model,SIGNAL(headerDataChanged(Qt::Orientation,int,int)),
+          this,SIGNAL(headerDataChanged(Qt::Orientation,int,int)));
+  endResetModel();
+}
+
+void FiltersSearchProxyModel::setResults(const QVector<FiltersTreeAbstractFilterItem*> & results)
+{
+  beginResetModel();
+  _results.clear();
+  _rows.clear();
+  _results.reserve(results.size());
+  for ( FiltersTreeAbstractFilterItem * item : results ) {
+    _rows.insert(item,_results.size());
+    _results.push_back(item);
+  }
+  endResetModel();
+}
+
+void FiltersSearchProxyModel::clear()
+{
+  if ( _results.isEmpty() ) {
+    return;
+  }
+  setResults(QVector<FiltersTreeAbstractFilterItem*>());
+}
+
+QModelIndex FiltersSearchProxyModel::index(int row, int column, const QModelIndex & parent) const
+{
+  if ( parent.isValid() || row < 0 || row >= _results.size() || column < 0 || column >= columnCount() ) {
+    return QModelIndex();
+  }
+  return createIndex(row,column);
+}
+
+QModelIndex FiltersSearchProxyModel::parent(const QModelIndex &) const
+{
+  return QModelIndex();
+}
+
+int FiltersSearchProxyModel::rowCount(const QModelIndex & parent) const
+{
+  return parent.isValid() ? 0 : _results.size();
+}
+
+int FiltersSearchProxyModel::columnCount(const QModelIndex & parent) const
+{
+  return ( parent.isValid() || !_model ) ? 0 : _model->columnCount();
+}
+
+QModelIndex FiltersSearchProxyModel::mapToSource(const QModelIndex & proxyIndex) const
+{
+  if ( !proxyIndex.isValid() || proxyIndex.row() >= _results.size() ) {
+    return QModelIndex();
+  }
+  const QModelIndex index = _results[proxyIndex.row()]->index();
+  return index.sibling(index.row(),proxyIndex.column());
+}
+
+QModelIndex FiltersSearchProxyModel::mapFromSource(const QModelIndex & sourceIndex) const
+{
+  if ( !sourceIndex.isValid() || !_model ) {
+    return QModelIndex();
+  }
+  // Items of other columns are found through the item of the first one
+  const QStandardItem * item = _model->itemFromIndex(sourceIndex.sibling(sourceIndex.row(),0));
+  const int row = _rows.value(item,-1);
+  return (row == -1) ? QModelIndex() : createIndex(row,sourceIndex.column());
+}
+
+QVariant FiltersSearchProxyModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+  // The default implementation maps sections through the first row, which may not exist
+  return _model ? _model->headerData(section,orientation,role) : QVariant();
+}
+
+void FiltersSearchProxyModel::onSourceDataChanged(const QModelIndex & topLeft, const QModelIndex & bottomRight)
+{
+  for ( int row = topLeft.row(); row <= bottomRight.row(); ++row ) {
+    const QModelIndex first = mapFromSource(topLeft.sibling(row,topLeft.column()));
+    if ( first.isValid() ) {
+      emit dataChanged(first,index(first.row(),bottomRight.column()));
+    }
+  }
+}
@@ -77,10 +77,10 @@ QStringList FiltersTreeAbstractItem::path() const
 {
   QStringList result;
   result.push_back(plainText());
-  const FiltersTreeFolderItem * folder = dynamic_cast<FiltersTreeFolderItem*>(parent());
+  const FiltersTreeFolderItem * folder = toFolder(parent());
   while ( folder ) {
     result.push_front(folder->plainText());
-    folder = dynamic_cast<FiltersTreeFolderItem*>(folder->parent());
+    folder = toFolder(folder->parent());
   }
   return result;
 }
@@ -106,17 +106,62 @@ void FiltersTreeAbstractItem::setVisibility(bool visibility)
   }
 }
 
+bool FiltersTreeAbstractItem::isFolder(const QStandardItem * item)
+{
+  return item && item->type() == FolderItemType;
+}
+
+bool FiltersTreeAbstractItem::isFilter(const QStandardItem * item)
+{
+  return item && item->type() == FilterItemType;
+}
+
+bool FiltersTreeAbstractItem::isFave(const QStandardItem * item)
+{
+  return item && item->type() == FaveItemType;
+}
+
+bool FiltersTreeAbstractItem::isAbstractFilter(const QStandardItem * item)
+{
+  return item && (item->type() == FilterItemType || item->type() == FaveItemType);
+}
+
+FiltersTreeFolderItem * FiltersTreeAbstractItem::toFolder(QStandardItem * item)
+{
+  return isFolder(item) ? static_cast<FiltersTreeFolderItem*>(item) : 0;
+}
+
+FiltersTreeFilterItem * FiltersTreeAbstractItem::toFilter(QStandardItem * item)
+{
+  return isFilter(item) ? static_cast<FiltersTreeFilterItem*>(item) : 0;
+}
+
+FiltersTreeFaveItem * FiltersTreeAbstractItem::toFave(QStandardItem * item)
+{
+  return isFave(item) ? static_cast<FiltersTreeFaveItem*>(item) : 0;
+}
+
+FiltersTreeAbstractFilterItem * FiltersTreeAbstractItem::toAbstractFilter(QStandardItem * item)
+{
+  return isAbstractFilter(item) ? static_cast<FiltersTreeAbstractFilterItem*>(item) : 0;
+}
+
+FiltersTreeAbstractItem * FiltersTreeAbstractItem::toAbstractItem(QStandardItem * item)
+{
+  return ( isFolder(item) || isAbstractFilter(item) ) ? static_cast<FiltersTreeAbstractItem*>(item) : 0;
+}
+
 int FiltersTreeAbstractItem::countLeaves(QStandardItem *item)
 {
-  if ( dynamic_cast<FiltersTreeFaveItem*>(item) ) {
+  if ( isFave(item) ) {
     return 0;
   }
-  if ( dynamic_cast<FiltersTreeFilterItem*>(item) ) {
+  if ( isFilter(item) ) {
     return 1;
   }
-  FiltersTreeFolderItem * folder = dynamic_cast<FiltersTreeFolderItem*>(item);
-  if ( folder && folder->plainText() == QString("Testing") ) {
-    return 0;
+  FiltersTreeFolderItem * folder = toFolder(item);
+  if ( folder ) {
+    return folder->leafCount();
   }
   int c = 0;
   int rows = item->rowCount();
@@ -131,7 +176,7 @@ FiltersTreeAbstractItem::findFave(QStandardItem * folder, QString hash)
 {
   int count = folder->rowCount();
   for (int row = 0; row < count; ++row) {
-    FiltersTreeFaveItem * item = dynamic_cast<FiltersTreeFaveItem*>(folder->child(row));
+    FiltersTreeFaveItem * item = toFave(folder->child(row));
     if ( item && item->hash() == hash ) {
       return item;
     }
@@ -145,8 +190,8 @@ FiltersTreeAbstractItem::findFilter(QStandardItem * folder, QString hash)
   int rows = folder->rowCount();
   for (int row = 0; row < rows; ++row ) {
     QStandardItem * item = folder->child(row);
-    FiltersTreeFilterItem * filter = static_cast<FiltersTreeFilterItem*>(item);
-    FiltersTreeFolderItem * subFolder = static_cast<FiltersTreeFolderItem*>(item);
+    FiltersTreeFilterItem * filter = toFilter(item);
+    FiltersTreeFolderItem * subFolder = toFolder(item);
     if ( filter && filter->hash() == hash ) {
       return filter;
     } else if ( subFolder ) {
@@ -161,9 +206,12 @@ FiltersTreeAbstractItem::findFilter(QStandardItem * folder, QString hash)
 
 bool FiltersTreeAbstractItem::operator<(const QStandardItem & other) const
 {
-  const FiltersTreeAbstractItem & o = dynamic_cast<const FiltersTreeAbstractItem &>(other);
-  const FiltersTreeFolderItem * folder = dynamic_cast<const FiltersTreeFolderItem *>(this);
-  const FiltersTreeFolderItem * other_folder = dynamic_cast<const FiltersTreeFolderItem *>(&other);
+  if ( !isFolder(&other) && !isAbstractFilter(&other) ) {
+    return QStandardItem::operator<(other);
+  }
+  const FiltersTreeAbstractItem & o = static_cast<const FiltersTreeAbstractItem &>(other);
+  const FiltersTreeFolderItem * folder = isFolder(this) ? static_cast<const FiltersTreeFolderItem *>(this) : 0;
+  const FiltersTreeFolderItem * other_folder = isFolder(&other) ? static_cast<const FiltersTreeFolderItem *>(&other) : 0;
   const bool fave_folder = folder && folder->isFaveFolder();
   const bool other_fave_folder = other_folder && other_folder->isFaveFolder();
 
@@ -192,21 +240,11 @@ bool FiltersTreeAbstractItem::operator<(const QStandardItem & other) const
   return plainText().localeAwareCompare(o.plainText()) < 0;
 }
 
-bool FiltersTreeAbstractItem::matchWordList(const QStringList & words, const QString & str)
-{
-  for ( const QString & word : words ) {
-    if (!str.contains(word,Qt::CaseInsensitive)) {
-      return false;
-    }
-  }
-  return true;
-}
-
 bool FiltersTreeAbstractItem::cleanupFolders(QStandardItem * item)
 {
   int rows = item->rowCount();
   for (int row = 0; row < rows; ++row) {
-    FiltersTreeFolderItem * subFolder = dynamic_cast<FiltersTreeFolderItem*>(item->child(row));
+    FiltersTreeFolderItem * subFolder = toFolder(item->child(row));
     if ( subFolder ) {
       while ( cleanupFolders(subFolder) ) { }
       if ( subFolder->rowCount() == 0 ) {
@@ -218,18 +256,27 @@ bool FiltersTreeAbstractItem::cleanupFolders(QStandardItem * item)
   return false;
 }
 
-void FiltersTreeAbstractItem::uncheckFullyUncheckedFolders(QStandardItem *folder)
+bool FiltersTreeAbstractItem::uncheckFullyUncheckedFolders(QStandardItem *folder)
 {
+  bool someVisible = false;
   int rows = folder->rowCount();
   for (int row = 0; row < rows; ++row) {
-    FiltersTreeFolderItem * subFolder = dynamic_cast<FiltersTreeFolderItem*>(folder->child(row));
+    QStandardItem * child = folder->child(row);
+    FiltersTreeFolderItem * subFolder = toFolder(child);
     if ( subFolder ) {
-      uncheckFullyUncheckedFolders(subFolder);
-      if ( subFolder->isFullyUnchecked() ) {
+      if ( uncheckFullyUncheckedFolders(subFolder) ) {
+        someVisible = true;
+      } else {
         subFolder->setVisibility(false);
       }
+    } else {
+      FiltersTreeAbstractFilterItem * filter = toAbstractFilter(child);
+      if ( filter && filter->isVisible() ) {
+        someVisible = true;
+      }
     }
   }
+  return someVisible;
 }
 
 void FiltersTreeAbstractItem::buildHashesList(QStandardItem * item, QSet<QString> & hashes)
@@ -237,8 +284,8 @@ void FiltersTreeAbstractItem::buildHashesList(QStandardItem * item, QSet<QString
   int rows = item->rowCount();
   for (int row = 0; row < rows; ++row) {
     QStandardItem * child = item->child(row);
-    FiltersTreeFolderItem * subFolder = dynamic_cast<FiltersTreeFolderItem*>(child);
-    FiltersTreeAbstractFilterItem * filter = dynamic_cast<FiltersTreeAbstractFilterItem*>(child);
+    FiltersTreeFolderItem * subFolder = toFolder(child);
+    FiltersTreeAbstractFilterItem * filter = toAbstractFilter(child);
     if ( subFolder ) {
       buildHashesList(subFolder,hashes);
     }
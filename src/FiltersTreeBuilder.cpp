@@ -0,0 +1,92 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file FiltersTreeBuilder.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "FiltersTreeBuilder.h"
+#include <QStandardItem>
+#include "FiltersTreeAbstractItem.h"
+#include "GmicStdlibParser.h"
+
+FiltersTreeBuilder::FiltersTreeBuilder(QObject * parent, const QByteArray & stdlib, bool withVisibility, int generation)
+  : QThread(parent),
+    _stdlib(stdlib),
+    _withVisibility(withVisibility),
+    _generation(generation),
+    _root(0),
+    _filtersCount(0)
+{
+}
+
+FiltersTreeBuilder::~FiltersTreeBuilder()
+{
+  delete _root;
+}
+
+void FiltersTreeBuilder::run()
+{
+  build();
+}
+
+void FiltersTreeBuilder::build()
+{
+  delete _root;
+  _root = new QStandardItem;
+  GmicStdLibParser::buildFiltersTree(_root,_stdlib,_withVisibility);
+  _filtersCount = FiltersTreeAbstractItem::countLeaves(_root);
+  if ( _withVisibility ) {
+    FiltersTreeAbstractItem::uncheckFullyUncheckedFolders(_root);
+  } else {
+    // Remove empty folders
+    do {
+      // Nothing
+    } while (FiltersTreeAbstractItem::cleanupFolders(_root));
+  }
+  _root->sortChildren(0);
+}
+
+QStandardItem * FiltersTreeBuilder::takeRoot()
+{
+  QStandardItem * root = _root;
+  _root = 0;
+  return root;
+}
+
+const QByteArray & FiltersTreeBuilder::stdlib() const
+{
+  return _stdlib;
+}
+
+bool FiltersTreeBuilder::withVisibility() const
+{
+  return _withVisibility;
+}
+
+int FiltersTreeBuilder::filtersCount() const
+{
+  return _filtersCount;
+}
+
+int FiltersTreeBuilder::generation() const
+{
+  return _generation;
+}
@@ -43,7 +43,7 @@ FiltersTreeFaveItem::FiltersTreeFaveItem(const FiltersTreeAbstractFilterItem * f
     _defaultValues(defaultValues)
 {
   setParameters(filter->parameters());
-  const FiltersTreeFaveItem * fave = dynamic_cast<const FiltersTreeFaveItem*>( filter );
+  const FiltersTreeFaveItem * fave = isFave(filter) ? static_cast<const FiltersTreeFaveItem*>(filter) : 0;
   // Fave from a fave -> get the original name
   if ( fave ) {
     _originalName = fave->originalFilterName();
@@ -60,25 +60,15 @@ FiltersTreeFaveItem::~FiltersTreeFaveItem()
 {
 }
 
-void FiltersTreeFaveItem::rename(const QString & name)
-{
-  setName(name);
-  updateHash();
-}
-
-FiltersTreeAbstractItem * FiltersTreeFaveItem::deepClone(const QStringList & selection) const
+int FiltersTreeFaveItem::type() const
 {
-  if ( matchWordList(selection,text()) ) {
-    return deepClone();
-  }
-  return 0;
+  return FaveItemType;
 }
 
-FiltersTreeAbstractItem * FiltersTreeFaveItem::deepClone() const
+void FiltersTreeFaveItem::rename(const QString & name)
 {
-  FiltersTreeFaveItem * item = new FiltersTreeFaveItem(this,text(),_defaultValues);
-  item->setParameters(_parameters);
-  return item;
+  setName(name);
+  updateHash();
 }
 
 QString FiltersTreeFaveItem::originalFilterHash() const
@@ -54,6 +54,11 @@ FiltersTreeFilterItem::~FiltersTreeFilterItem()
 {
 }
 
+int FiltersTreeFilterItem::type() const
+{
+  return FilterItemType;
+}
+
 void FiltersTreeFilterItem::setWarningFlag(bool on)
 {
   _isWarning = on;
@@ -64,25 +69,6 @@ bool FiltersTreeFilterItem::isWarning() const
   return _isWarning;
 }
 
-FiltersTreeAbstractItem * FiltersTreeFilterItem::deepClone(const QStringList & words) const
-{
-  if ( matchWordList(words,text()) ) {
-    return deepClone();
-  }
-  return 0;
-}
-
-FiltersTreeAbstractItem * FiltersTreeFilterItem::deepClone() const
-{
-  FiltersTreeFilterItem * item = new FiltersTreeFilterItem(text(),
-                                                           command(),
-                                                           previewCommand(),
-                                                           previewFactor(),
-                                                           isAccurateIfZoomed());
-  item->setParameters(_parameters);
-  return item;
-}
-
 void FiltersTreeFilterItem::updateHash()
 {
   _hash = FiltersTreeAbstractFilterItem::computeHash(text(),command(),previewCommand());
@@ -33,7 +33,8 @@
 FiltersTreeFolderItem::FiltersTreeFolderItem(const QString & name, FolderType folderType)
   : FiltersTreeAbstractItem(name),
     _isFaveFolder(folderType == FaveFolder),
-    _isWarning( false )
+    _isWarning( false ),
+    _leafCount(-1)
 {
 }
 
@@ -41,6 +42,11 @@ FiltersTreeFolderItem::~FiltersTreeFolderItem()
 {
 }
 
+int FiltersTreeFolderItem::type() const
+{
+  return FolderItemType;
+}
+
 bool FiltersTreeFolderItem::isFaveFolder() const
 {
   return _isFaveFolder;
@@ -56,75 +62,29 @@ bool FiltersTreeFolderItem::isWarning() const
   return _isWarning;
 }
 
-FiltersTreeAbstractItem * FiltersTreeFolderItem::deepClone(const QStringList & words) const
-{
-  if ( matchWordList(words,plainText()) ) {
-    return deepClone();
-  }
-  int count = rowCount();
-  QList<QStandardItem*> list;
-  for (int row = 0; row < count; ++row ) {
-    QStandardItem * standardItem = child(row);
-    FiltersTreeAbstractItem * item = dynamic_cast<FiltersTreeAbstractItem*>(standardItem);
-    Q_ASSERT(item);
-    FiltersTreeAbstractItem * clone = item->deepClone(words);
-    if (clone) {
-      list.push_back(clone);
-    }
-  }
-  if (!list.isEmpty()) {
-    FiltersTreeFolderItem * clone = new FiltersTreeFolderItem(text(),
-                                                              _isFaveFolder ? FaveFolder : NormalFolder);
-    clone->appendRows(list);
-    return clone;
-  }
-  return 0;
-}
-
-FiltersTreeAbstractItem * FiltersTreeFolderItem::deepClone() const
-{
-  int count = rowCount();
-  QList<QStandardItem*> list;
-  for (int row = 0; row < count; ++row ) {
-    QStandardItem * standardItem = child(row);
-    FiltersTreeAbstractItem * item = dynamic_cast<FiltersTreeAbstractItem*>(standardItem);
-    Q_ASSERT(item);
-    list.push_back(item->deepClone());
-  }
-  if (!list.isEmpty()) {
-    FiltersTreeFolderItem * clone = new FiltersTreeFolderItem(text(),
-                                                              _isFaveFolder ? FaveFolder : NormalFolder);
-    clone->appendRows(list);
-    return clone;
-  }
-  return 0;
-}
-
 void FiltersTreeFolderItem::setItemsVisibility(bool visible)
 {
   int rows = rowCount();
   for ( int row = 0; row < rows; ++row ) {
-    FiltersTreeAbstractItem * item = dynamic_cast<FiltersTreeAbstractItem*>(child(row));
-    if ( item ) {
-      item->setVisibility(visible);
+    QStandardItem * item = child(row);
+    if ( isFolder(item) || isAbstractFilter(item) ) {
+      static_cast<FiltersTreeAbstractItem*>(item)->setVisibility(visible);
     }
   }
 }
 
-bool FiltersTreeFolderItem::isFullyUnchecked()
+int FiltersTreeFolderItem::leafCount() const
 {
-  int count = rowCount();
-  for ( int row = 0; row < count; ++row ) {
-    FiltersTreeAbstractFilterItem * item = dynamic_cast<FiltersTreeAbstractFilterItem*>(child(row));
-    if ( item && item->isVisible() ) {
-      return false;
-    }
-    FiltersTreeFolderItem * folder = dynamic_cast<FiltersTreeFolderItem*>(child(row));
-    if ( folder && !folder->isFullyUnchecked() ) {
-      return false;
+  if ( _leafCount == -1 ) {
+    _leafCount = 0;
+    if ( plainText() != QString("Testing") ) {
+      const int rows = rowCount();
+      for ( int row = 0; row < rows; ++row ) {
+        _leafCount += countLeaves(child(row));
+      }
     }
   }
-  return true;
+  return _leafCount;
 }
 
 void FiltersTreeFolderItem::applyVisibilityStatusToFolderContents()
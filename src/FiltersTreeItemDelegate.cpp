@@ -25,6 +25,7 @@
 #include "FiltersTreeItemDelegate.h"
 #include "FiltersTreeAbstractFilterItem.h"
 #include "DialogSettings.h"
+#include <QAbstractProxyModel>
 #include <QTextDocument>
 #include <QColor>
 #include <QPalette>
@@ -32,35 +33,56 @@
 #include <QDebug>
 
 FiltersTreeItemDelegate::FiltersTreeItemDelegate(QObject *parent)
-  : QStyledItemDelegate(parent)
+  : QStyledItemDelegate(parent),
+    _documents(DocumentCacheSize)
 {
 }
 
+QTextDocument * FiltersTreeItemDelegate::document(const QString & html, qreal textWidth) const
+{
+  // The key holds everything the layout depends on (the html includes the
+  // text color), so that a renamed item, a resized column or a theme change
+  // simply leads to another entry.
+  const QString key = QString("%1|%2").arg(textWidth).arg(html);
+  QTextDocument * doc = _documents.object(key);
+  if ( ! doc ) {
+    doc = new QTextDocument;
+    doc->setHtml(html);
+    doc->setTextWidth(textWidth);
+    _documents.insert(key,doc);
+  }
+  return doc;
+}
+
 void FiltersTreeItemDelegate::paint(QPainter* painter, const QStyleOptionViewItem & option, const QModelIndex & index) const
 {
   QStyleOptionViewItem options = option;
   initStyleOption(&options, index);
   painter->save();
 
-  const QStandardItemModel * model = dynamic_cast<const QStandardItemModel*>(index.model());
+  // Search results are shown through a proxy of the tree model
+  const QAbstractProxyModel * proxy = qobject_cast<const QAbstractProxyModel*>(index.model());
+  const QModelIndex itemIndex = proxy ? proxy->mapToSource(index) : index;
+  const QStandardItemModel * model = qobject_cast<const QStandardItemModel*>(itemIndex.model());
   Q_ASSERT_X(model,"FiltersTreeItemDelegate::paint()","No model");
-  const QStandardItem * item = model->itemFromIndex(index);
+  const QStandardItem * item = model->itemFromIndex(itemIndex);
   Q_ASSERT_X(item,"FiltersTreeItemDelegate::paint()","No item");
-  const FiltersTreeAbstractFilterItem * filter = dynamic_cast<const FiltersTreeAbstractFilterItem*>(item);
+  const FiltersTreeAbstractFilterItem * filter = FiltersTreeAbstractItem::isAbstractFilter(item) ? static_cast<const FiltersTreeAbstractFilterItem*>(item) : 0;
 
-  QTextDocument doc;
+  QString html;
   if ( !item->isCheckable() && filter && !filter->isVisible() ) {
     QColor textColor;
     textColor = DialogSettings::UnselectedFilterTextColor;
-    doc.setHtml(QString("<span style=\"color:%1\">%2</span>").arg(textColor.name()).arg(options.text));
+    html = QString("<span style=\"color:%1\">%2</span>").arg(textColor.name()).arg(options.text);
   } else {
-    doc.setHtml(options.text);
+    html = options.text;
   }
+  QTextDocument * doc = document(html,-1);
   options.text = "";
   options.widget->style()->drawControl(QStyle::CE_ItemViewItem, &options, painter);
   painter->translate(options.rect.left(), options.rect.top());
   QRect clip(0, 0, options.rect.width(), options.rect.height());
-  doc.drawContents(painter, clip);
+  doc->drawContents(painter, clip);
   painter->restore();
 }
 
@@ -68,10 +90,6 @@ QSize FiltersTreeItemDelegate::sizeHint( const QStyleOptionViewItem & option, co
 {
   QStyleOptionViewItem options = option;
   initStyleOption(&options, index);
-
-
-  QTextDocument doc;
-  doc.setHtml(options.text);
-  doc.setTextWidth(options.rect.width());
-  return QSize(doc.idealWidth(), doc.size().height());
+  QTextDocument * doc = document(options.text,options.rect.width());
+  return QSize(doc->idealWidth(), doc->size().height());
 }
@@ -28,18 +28,22 @@
 #include <QDataStream>
 #include <QFile>
 #include <QDebug>
+#include <QMutexLocker>
 #include "Common.h"
-#include "gmic.h"
+#include "UserCatalog.h"
 
 QSet<QString> FiltersVisibilityMap::_hiddenFilters;
+QMutex FiltersVisibilityMap::_mutex;
 
 bool FiltersVisibilityMap::filterIsVisible(const QString & hash)
 {
+  QMutexLocker locker(&_mutex);
   return ! _hiddenFilters.contains(hash);
 }
 
 void FiltersVisibilityMap::setVisibility(const QString & hash, bool visible)
 {
+  QMutexLocker locker(&_mutex);
   if ( visible ) {
     _hiddenFilters.remove(hash);
   } else {
@@ -47,52 +51,88 @@ void FiltersVisibilityMap::setVisibility(const QString & hash, bool visible)
   }
 }
 
+namespace {
+// Hidden filters are stored as empty "v/<hash>" records
+const QByteArray KeyPrefix("v/");
+}
+
 void FiltersVisibilityMap::load()
 {
-  QString path = QString("%1%2").arg( GmicQt::path_rc(false), FILTERS_VISIBILITY_FILENAME );
-  QFile file(path);
-  if ( file.open(QFile::ReadOnly) ) {
-    QString line;
-    do {
-      line = file.readLine();
-    } while ( file.bytesAvailable() && line != QString("[Hidden filters list (compressed)]\n") );
-    QByteArray data = qUncompress(file.readAll());
-    QBuffer buffer(&data);
-    buffer.open(QIODevice::ReadOnly);
+  QSet<QString> hiddenFilters;
+  if ( UserCatalog::open() ) {
+    for ( const QByteArray & key : UserCatalog::keys(KeyPrefix) ) {
+      hiddenFilters.insert(QString::fromLatin1(key.mid(KeyPrefix.size())));
+    }
+  } else {
+    readLegacyFile(hiddenFilters);
+  }
+  QMutexLocker locker(&_mutex);
+  _hiddenFilters.unite(hiddenFilters);
+}
+
+void FiltersVisibilityMap::save()
+{
+  QMutexLocker locker(&_mutex);
+  const QSet<QString> hiddenFilters = _hiddenFilters;
+  locker.unlock();
 
-    bool ok;
-    qint32 count = buffer.readLine().trimmed().toInt(&ok);
-    if (ok) {
-      QString hash;
-      while ( count-- ) {
-        hash = buffer.readLine().trimmed();
-        _hiddenFilters.insert(hash);
-      }
+  // Only the records of filters whose visibility changed are written
+  QHash<QByteArray,QByteArray> inserts;
+  QList<QByteArray> removals;
+  QSet<QString> stored;
+  for ( const QByteArray & key : UserCatalog::keys(KeyPrefix) ) {
+    const QString hash = QString::fromLatin1(key.mid(KeyPrefix.size()));
+    if ( hiddenFilters.contains(hash) ) {
+      stored.insert(hash);
     } else {
-      qWarning() << "[gmic-qt] Error: reading" << file.fileName();
+      removals.push_back(key);
+    }
+  }
+  for ( const QString & hash : hiddenFilters ) {
+    if ( ! stored.contains(hash) ) {
+      inserts.insert(KeyPrefix + hash.toLatin1(),QByteArray(""));
     }
   }
+  if ( ! UserCatalog::write(inserts,removals) ) {
+    qWarning() << "[gmic-qt] Error: Cannot save filters visibility";
+  }
 }
 
-void FiltersVisibilityMap::save()
+void FiltersVisibilityMap::importLegacyFile(QHash<QByteArray,QByteArray> & records)
 {
-  QByteArray data;
-  QBuffer buffer(&data);
-  buffer.open(QIODevice::WriteOnly);
-  qint32 count = _hiddenFilters.size();
-  buffer.write(QString("%1\n").arg(count).toLatin1());
-  for ( const QString & str : _hiddenFilters ) {
-    buffer.write((str+QChar('\n')).toLatin1());
+  QSet<QString> hiddenFilters;
+  if ( readLegacyFile(hiddenFilters) ) {
+    for ( const QString & hash : hiddenFilters ) {
+      records.insert(KeyPrefix + hash.toLatin1(),QByteArray(""));
+    }
   }
+}
 
-  QString path = QString("%1%2").arg( GmicQt::path_rc(true), FILTERS_VISIBILITY_FILENAME );
+bool FiltersVisibilityMap::readLegacyFile(QSet<QString> & hiddenFilters)
+{
+  QString path = QString("%1%2").arg( GmicQt::path_rc(false), FILTERS_VISIBILITY_FILENAME );
   QFile file(path);
-  if ( file.open(QFile::WriteOnly) ) {
-    file.write(QString("Version=%1.%2.%3\n").arg(gmic_version/100).arg((gmic_version/10)%10).arg(gmic_version%10).toLocal8Bit());
-    file.write(QString("[Hidden filters list (compressed)]\n").toLocal8Bit());
-    file.write(qCompress(data));
-    file.close();
-  } else {
-    qWarning() << "[gmic-qt] Error: Cannot write" << path;
+  if ( ! file.open(QFile::ReadOnly) ) {
+    return false;
+  }
+  QString line;
+  do {
+    line = file.readLine();
+  } while ( file.bytesAvailable() && line != QString("[Hidden filters list (compressed)]\n") );
+  QByteArray data = qUncompress(file.readAll());
+  QBuffer buffer(&data);
+  buffer.open(QIODevice::ReadOnly);
+
+  bool ok;
+  qint32 count = buffer.readLine().trimmed().toInt(&ok);
+  if ( ! ok ) {
+    qWarning() << "[gmic-qt] Error: reading" << file.fileName();
+    return false;
+  }
+  QString hash;
+  while ( count-- ) {
+    hash = buffer.readLine().trimmed();
+    hiddenFilters.insert(hash);
   }
+  return true;
 }
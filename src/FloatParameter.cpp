@@ -35,6 +35,7 @@
 #include <QPalette>
 #include "DialogSettings.h"
 #include "HtmlTranslator.h"
+#include "ParameterWidgetPool.h"
 #include <QDebug>
 
 FloatParameter::FloatParameter(QObject *parent)
@@ -53,9 +54,9 @@ FloatParameter::FloatParameter(QObject *parent)
 
 FloatParameter::~FloatParameter()
 {
-  delete _spinBox;
-  delete _slider;
-  delete _label;
+  ParameterWidgetPool::recycle(_spinBox,this);
+  ParameterWidgetPool::recycle(_slider,this);
+  ParameterWidgetPool::recycle(_label,this);
 }
 
 void
@@ -63,10 +64,11 @@ FloatParameter::addTo(QWidget * widget, int row)
 {
   QGridLayout * grid = dynamic_cast<QGridLayout*>(widget->layout());
   if (! grid) return;
-  delete _spinBox;
-  delete _slider;
-  delete _label;
-  _slider = new QSlider(Qt::Horizontal,widget);
+  ParameterWidgetPool::recycle(_spinBox,this);
+  ParameterWidgetPool::recycle(_slider,this);
+  ParameterWidgetPool::recycle(_label,this);
+  _slider = ParameterWidgetPool::take<QSlider>(widget);
+  _slider->setOrientation(Qt::Horizontal);
   _slider->setMinimumWidth(SLIDER_MIN_WIDTH);
   _slider->setRange(0,1000);
   _slider->setValue(static_cast<int>(1000*(_value-_min)/(_max-_min)));
@@ -76,12 +78,14 @@ FloatParameter::addTo(QWidget * widget, int row)
     p.setColor(QPalette::Highlight, QColor(130,130,130));
     _slider->setPalette(p);
   }
-  _spinBox = new QDoubleSpinBox(widget);
+  _spinBox = ParameterWidgetPool::take<QDoubleSpinBox>(widget);
+  _spinBox->setDecimals(2);
   _spinBox->setRange(_min,_max);
   _spinBox->setValue(_value);
-  _spinBox->setDecimals(2);
   _spinBox->setSingleStep((_max-_min)/100.0);
-  grid->addWidget(_label = new QLabel(_name,widget),row,0,1,1);
+  _label = ParameterWidgetPool::take<QLabel>(widget);
+  _label->setText(_name);
+  grid->addWidget(_label,row,0,1,1);
   grid->addWidget(_slider,row,1,1,1);
   grid->addWidget(_spinBox,row,2,1,1);
   connectSliderSpinBox();
@@ -121,10 +125,9 @@ FloatParameter::reset()
 }
 
 void
-FloatParameter::initFromText(const char * text, int & textLength)
+FloatParameter::initFromDefinition(const ParameterDefinition & definition)
 {
-  textLength = 0;
-  QList<QString> list = parseText("float",text,textLength);
+  QList<QString> list = parseDefinition(definition);
 
   _name = HtmlTranslator::html2txt(list[0]);
   QList<QString> values = list[1].split(QChar(','));
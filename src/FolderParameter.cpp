@@ -102,9 +102,9 @@ FolderParameter::reset()
   setValue(_default);
 }
 
-void FolderParameter::initFromText(const char * text, int & textLength)
+void FolderParameter::initFromDefinition(const ParameterDefinition & definition)
 {
-  QList<QString> list = parseText("folder",text,textLength);
+  QList<QString> list = parseDefinition(definition);
   _name = HtmlTranslator::html2txt(list[0]);
   QRegExp re("^\".*\"$");
   if ( re.exactMatch(list[1]) ) {
@@ -32,7 +32,6 @@
 #include <QList>
 #include <QString>
 #include <QRegExp>
-#include <QBuffer>
 #include <QTreeView>
 #include <QStandardItem>
 #include "FiltersTreeAbstractItem.h"
@@ -40,6 +39,7 @@
 #include "FiltersTreeFilterItem.h"
 #include "FiltersVisibilityMap.h"
 #include "gmic.h"
+#include <cstring>
 
 QByteArray GmicStdLibParser::GmicStdlib;
 
@@ -47,21 +47,78 @@ GmicStdLibParser::GmicStdLibParser()
 {
 }
 
-void GmicStdLibParser::buildFiltersTree(QStandardItemModel & model, bool withVisibility)
+namespace {
+
+enum GuiLineKind { OtherLine, FolderLine, FilterLine };
+
+inline bool isSpace(char c)
+{
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+inline const char * endOfLine(const char * begin, const char * end)
 {
-  if ( GmicStdlib.isEmpty() ) {
-    loadStdLib();
+  const char * eol = static_cast<const char*>(std::memchr(begin,'\n',end - begin));
+  return eol ? (eol + 1) : end;
+}
+
+inline void trim(const char * & begin, const char * & end)
+{
+  while ( begin < end && isSpace(*begin) ) {
+    ++begin;
   }
-  QBuffer stdlib(&GmicStdlib);
-  stdlib.open(QBuffer::ReadOnly);
-  QList<QStandardItem*> treeFoldersStack;
-  QList<QString> filterPath;
+  while ( end > begin && isSpace(end[-1]) ) {
+    --end;
+  }
+}
+
+inline bool startsWith(const char * begin, const char * end, const QByteArray & prefix)
+{
+  return (end - begin) >= prefix.size() && !std::memcmp(begin,prefix.constData(),prefix.size());
+}
 
-  model.setHorizontalHeaderItem(0,new QStandardItem(QObject::tr("Available filters")));
-  if ( withVisibility ) {
-    model.setHorizontalHeaderItem(1,new QStandardItem(QObject::tr("Visible")));
+/*
+ * Recognizes "#@gui[_<language>] <name>" (folder) and
+ * "#@gui[_<language>] <name> : <commands>" (filter) lines.
+ * On success, text points after the space following the "#@gui" token
+ * and colon to the first ':' of a filter line.
+ */
+GuiLineKind guiLineKind(const char * begin, const char * end, const QByteArray & language,
+                        const char * & text, const char * & colon)
+{
+  if ( end - begin < 6 || std::memcmp(begin,"#@gui",5) ) {
+    return OtherLine;
   }
-  treeFoldersStack.push_back(model.invisibleRootItem());
+  const char * p = begin + 5;
+  if ( *p == '_' ) {
+    ++p;
+    if ( !startsWith(p,end,language) ) {
+      return OtherLine;
+    }
+    p += language.size();
+  }
+  if ( p >= end || *p != ' ' ) {
+    return OtherLine;
+  }
+  ++p;
+  if ( p >= end ) {
+    return OtherLine;
+  }
+  text = p;
+  colon = static_cast<const char*>(std::memchr(p,':',end - p));
+  if ( !colon ) {
+    return FolderLine;
+  }
+  return (colon > p) ? FilterLine : OtherLine;
+}
+
+}
+
+void GmicStdLibParser::buildFiltersTree(QStandardItem * root, const QByteArray & stdlib, bool withVisibility)
+{
+  QList<QStandardItem*> treeFoldersStack;
+  QList<QString> filterPath;
+  treeFoldersStack.push_back(root);
 
   QString language;
   QList<QString> languages = QLocale().uiLanguages();
@@ -70,172 +127,199 @@ void GmicStdLibParser::buildFiltersTree(QStandardItemModel & model, bool withVis
   } else {
     language = "void";
   }
-  if ( ! GmicStdlib.contains(QString("#@gui_%1").arg(language).toLocal8Bit()) ) {
+  if ( ! stdlib.contains(QString("#@gui_%1").arg(language).toLocal8Bit()) ) {
+    // Use _en locale if not localization for the language is found.
     language = "en";
   }
+  const QByteArray languageBytes = language.toLatin1();
 
-  // Use _en locale if not localization for the language is found.
-
-  QString buffer = stdlib.readLine(4096);
-  QString line;
-
-  QRegExp folderRegexpNoLanguage("^..gui[ ][^:]+$");
-  QRegExp folderRegexpLanguage( QString("^..gui_%1[ ][^:]+$").arg(language));
-
-  QRegExp filterRegexpNoLanguage("^..gui[ ][^:]+[ ]*:.*");
-  QRegExp filterRegexpLanguage( QString("^..gui_%1[ ][^:]+[ ]*:.*").arg(language));
+  // The stdlib is scanned in place, QStrings are only built for kept fields
+  const char * const data = stdlib.constData();
+  const char * const dataEnd = data + stdlib.size();
+  const char * lineBegin = data;
 
   int maxDepth = 1;
   const QChar WarningPrefix('!');
-  do {
-    line = buffer.trimmed();
-    if ( line.startsWith("#@gui") ) {
-      if ( folderRegexpNoLanguage.exactMatch(line) || folderRegexpLanguage.exactMatch(line) ) {
-        //
-        // A folder
-        //
-        QString folderName = line;
-        folderName.replace(QRegExp("^..gui[_a-zA-Z]{0,3}[ ]"), "" );
-
-        while ( folderName.startsWith("_") && (treeFoldersStack.size() > 1) ) {
-          folderName.remove(0,1);
-          treeFoldersStack.pop_back();
-          filterPath.pop_back();
-        }
-        while ( folderName.startsWith("_") ) {
-          folderName.remove(0,1);
-        }
-        const bool warning = folderName.startsWith(WarningPrefix);
-        if ( warning ) {
-          folderName.remove(0,1);
-        }
-        if ( ! folderName.isEmpty() ) {
-          // Does this folder already exists
-          FiltersTreeFolderItem * folderItem = 0;
-          {
-            QStandardItem * parentFolder = treeFoldersStack.last();
-            int n = parentFolder->rowCount();
-            for (int i = 0; i < n && !folderItem; ++i) {
-              FiltersTreeFolderItem * folder  = dynamic_cast<FiltersTreeFolderItem*>(parentFolder->child(i));
-              if (folder && folder->name() == folderName) {
-                folderItem = folder;
-              }
-            }
-          }
-          if ( ! folderItem ) {
-            // Not found, so create and append it
-            folderItem = new FiltersTreeFolderItem(folderName,FiltersTreeFolderItem::NormalFolder);
-            folderItem->setWarningFlag(warning);
+  while ( lineBegin < dataEnd ) {
+    const char * const lineEnd = endOfLine(lineBegin,dataEnd);
+    const char * begin = lineBegin;
+    const char * end = lineEnd;
+    trim(begin,end);
+    const char * text = 0;
+    const char * colon = 0;
+    const GuiLineKind kind = guiLineKind(begin,end,languageBytes,text,colon);
+    if ( kind == FolderLine ) {
+      //
+      // A folder
+      //
+      QString folderName = QString::fromUtf8(text,end - text);
 
-            // Add visibility checkbox, if needed
-            if ( withVisibility && folderItem->plainText() != QString("About") ) {
-              addStandardItemWithCheckBox(treeFoldersStack.back(),folderItem,true);
-            } else {
-              // Invisible and empty folders will be removed later
-              treeFoldersStack.last()->appendRow(folderItem);
+      while ( folderName.startsWith("_") && (treeFoldersStack.size() > 1) ) {
+        folderName.remove(0,1);
+        treeFoldersStack.pop_back();
+        filterPath.pop_back();
+      }
+      while ( folderName.startsWith("_") ) {
+        folderName.remove(0,1);
+      }
+      const bool warning = folderName.startsWith(WarningPrefix);
+      if ( warning ) {
+        folderName.remove(0,1);
+      }
+      if ( ! folderName.isEmpty() ) {
+        // Does this folder already exists
+        FiltersTreeFolderItem * folderItem = 0;
+        {
+          QStandardItem * parentFolder = treeFoldersStack.last();
+          int n = parentFolder->rowCount();
+          for (int i = 0; i < n && !folderItem; ++i) {
+            FiltersTreeFolderItem * folder  = FiltersTreeAbstractItem::toFolder(parentFolder->child(i));
+            if (folder && folder->name() == folderName) {
+              folderItem = folder;
             }
           }
-          treeFoldersStack.push_back(folderItem);
-          filterPath.push_back(folderName);
         }
-        maxDepth = std::max( maxDepth, treeFoldersStack.size() );
-        buffer = stdlib.readLine(4096);
-      } else if ( filterRegexpNoLanguage.exactMatch(line) || filterRegexpLanguage.exactMatch(line) ) {
-        //
-        // A filter
-        //
-        QString filterName = line;
-        filterName.replace( QRegExp("[ ]*:.*$"), "" );
-        filterName.replace( QRegExp("^..gui[_a-zA-Z]{0,3}[ ]"), "" );
+        if ( ! folderItem ) {
+          // Not found, so create and append it
+          folderItem = new FiltersTreeFolderItem(folderName,FiltersTreeFolderItem::NormalFolder);
+          folderItem->setWarningFlag(warning);
 
-        const bool warning = filterName.startsWith(WarningPrefix);
-        if ( warning ) {
-          filterName.remove(0,1);
+          // Add visibility checkbox, if needed
+          if ( withVisibility && folderItem->plainText() != QString("About") ) {
+            addStandardItemWithCheckBox(treeFoldersStack.back(),folderItem,true);
+          } else {
+            // Invisible and empty folders will be removed later
+            treeFoldersStack.last()->appendRow(folderItem);
+          }
         }
+        treeFoldersStack.push_back(folderItem);
+        filterPath.push_back(folderName);
+      }
+      maxDepth = std::max( maxDepth, treeFoldersStack.size() );
+      lineBegin = lineEnd;
+    } else if ( kind == FilterLine ) {
+      //
+      // A filter
+      //
+      const char * nameEnd = colon;
+      while ( nameEnd > text && nameEnd[-1] == ' ' ) {
+        --nameEnd;
+      }
+      QString filterName = QString::fromUtf8(text,nameEnd - text);
 
-        QString filterCommands = line;
-        filterCommands.replace(QRegExp("^..gui[_a-zA-Z]{0,3}[ ][^:]+[ ]*:[ ]*"),"");
+      const bool warning = filterName.startsWith(WarningPrefix);
+      if ( warning ) {
+        filterName.remove(0,1);
+      }
 
-        QList<QString> commands = filterCommands.split(",");
+      // Commands: "command[, preview_command[(factor[+])]]"
+      const char * commands = colon + 1;
+      while ( commands < end && *commands == ' ' ) {
+        ++commands;
+      }
+      const char * comma = static_cast<const char*>(std::memchr(commands,',',end - commands));
+      const char * commandBegin = commands;
+      const char * commandEnd = comma ? comma : end;
+      trim(commandBegin,commandEnd);
+      QString filterCommand = QString::fromUtf8(commandBegin,commandEnd - commandBegin);
 
-        QString filterCommand = commands[0].trimmed();
-        if ( commands.size() == 0) {
-          commands.push_back("_none_");
+      const char * previewBegin = commands;
+      const char * previewEnd = end;
+      if ( comma ) {
+        previewBegin = comma + 1;
+        const char * nextComma = static_cast<const char*>(std::memchr(previewBegin,',',end - previewBegin));
+        if ( nextComma ) {
+          previewEnd = nextComma;
         }
-        if ( commands.size() == 1) {
-          commands.push_back(commands.front());
+      }
+      trim(previewBegin,previewEnd);
+      const char * parenthesis = static_cast<const char*>(std::memchr(previewBegin,'(',previewEnd - previewBegin));
+      float previewFactor = GmicQt::PreviewFactorAny;
+      bool accurateIfZoomed = true;
+      if ( parenthesis ) {
+        const char * factorBegin = parenthesis + 1;
+        const char * factorEnd = static_cast<const char*>(std::memchr(factorBegin,'(',previewEnd - factorBegin));
+        if ( !factorEnd ) {
+          factorEnd = previewEnd;
         }
-        QList<QString> preview = commands[1].trimmed().split("(");
-        float previewFactor = GmicQt::PreviewFactorAny;
-        bool accurateIfZoomed = true;
-        if ( preview.size() >= 2 ) {
-          if (preview[1].endsWith("+")) {
-            accurateIfZoomed = true;
-            preview[1].chop(1);
-          } else {
-            accurateIfZoomed = false;
-          }
-          previewFactor = preview[1].replace(QRegExp("\\).*"),"").toFloat();
+        if ( factorEnd > factorBegin && factorEnd[-1] == '+' ) {
+          accurateIfZoomed = true;
+          --factorEnd;
+        } else {
+          accurateIfZoomed = false;
+        }
+        const char * closing = static_cast<const char*>(std::memchr(factorBegin,')',factorEnd - factorBegin));
+        if ( closing ) {
+          factorEnd = closing;
         }
-        QString filterPreviewCommand = preview[0].trimmed();
-        FiltersTreeFilterItem * filterItem = new FiltersTreeFilterItem(filterName,
-                                                                       filterCommand,
-                                                                       filterPreviewCommand,
-                                                                       previewFactor,
-                                                                       accurateIfZoomed);
-        filterItem->setWarningFlag(warning);
+        previewFactor = QString::fromLatin1(factorBegin,factorEnd - factorBegin).toFloat();
+        previewEnd = parenthesis;
+        trim(previewBegin,previewEnd);
+      }
+      QString filterPreviewCommand = QString::fromUtf8(previewBegin,previewEnd - previewBegin);
+      FiltersTreeFilterItem * filterItem = new FiltersTreeFilterItem(filterName,
+                                                                     filterCommand,
+                                                                     filterPreviewCommand,
+                                                                     previewFactor,
+                                                                     accurateIfZoomed);
+      filterItem->setWarningFlag(warning);
 
-        // Add visibility checkbox, if needed
-        bool filterIsVisible = FiltersVisibilityMap::filterIsVisible(filterItem->hash());
-        FiltersTreeFolderItem * parentFolder = dynamic_cast<FiltersTreeFolderItem*>(treeFoldersStack.back());
-        bool isInAboutFolder = (parentFolder && (parentFolder->plainText() == QString("About")));
-        if ( withVisibility && !isInAboutFolder ) {
-          addStandardItemWithCheckBox(treeFoldersStack.back(),filterItem,filterIsVisible);
-        } else {
-          if ( filterIsVisible ) {
-            treeFoldersStack.back()->appendRow(filterItem);
-          }
+      // Add visibility checkbox, if needed
+      bool filterIsVisible = FiltersVisibilityMap::filterIsVisible(filterItem->hash());
+      FiltersTreeFolderItem * parentFolder = FiltersTreeAbstractItem::toFolder(treeFoldersStack.back());
+      bool isInAboutFolder = (parentFolder && (parentFolder->plainText() == QString("About")));
+      if ( withVisibility && !isInAboutFolder ) {
+        addStandardItemWithCheckBox(treeFoldersStack.back(),filterItem,filterIsVisible);
+      } else {
+        if ( filterIsVisible ) {
+          treeFoldersStack.back()->appendRow(filterItem);
         }
+      }
 
-        QString start = line;
-        start.replace(QRegExp(" .*")," :");
+      // Parameter lines start with the same "#@gui[_xx]" token, followed by " :"
+      const char * token = begin;
+      while ( token < end && *token != ' ' ) {
+        ++token;
+      }
+      const QByteArray start = QByteArray(begin,token - begin) + " :";
 
-        // Read parameters
-        QString parameters;
-        do {
-          buffer = stdlib.readLine(4096);
-          if ( buffer.startsWith(start) ) {
-            QString parameterLine = buffer;
-            parameterLine.replace(QRegExp("^..gui[_a-zA-Z]{0,3}[ ]*:[ ]*"), "");
-            parameters += parameterLine;
+      // Read parameters, skipping comments and blank lines
+      QByteArray parameters;
+      lineBegin = lineEnd;
+      while ( lineBegin < dataEnd ) {
+        const char * const parameterLineEnd = endOfLine(lineBegin,dataEnd);
+        const bool isParameterLine = startsWith(lineBegin,parameterLineEnd,start);
+        bool isBlank = true;
+        for ( const char * c = lineBegin; c < parameterLineEnd && isBlank; ++c ) {
+          isBlank = isSpace(*c);
+        }
+        if ( ! ( isParameterLine || *lineBegin == '#' || (isBlank && parameterLineEnd < dataEnd) )
+             || guiLineKind(lineBegin,parameterLineEnd,languageBytes,text,colon) != OtherLine ) {
+          break;
+        }
+        if ( isParameterLine ) {
+          const char * parameter = lineBegin + start.size();
+          while ( parameter < parameterLineEnd && *parameter == ' ' ) {
+            ++parameter;
           }
-        } while ( (buffer.startsWith(start)
-                   || buffer.startsWith("#")
-                   || (buffer.trimmed().isEmpty() && ! stdlib.atEnd()))
-                  && !folderRegexpNoLanguage.exactMatch(buffer)
-                  && !folderRegexpLanguage.exactMatch(buffer)
-                  && !filterRegexpNoLanguage.exactMatch(buffer)
-                  && !filterRegexpLanguage.exactMatch(buffer));
-        filterItem->setParameters(parameters);
-
-        if ( !withVisibility && !filterIsVisible ) {
-          delete filterItem;
+          parameters.append(parameter,parameterLineEnd - parameter);
         }
-      } else {
-        buffer = stdlib.readLine(4096);
+        lineBegin = parameterLineEnd;
+      }
+      filterItem->setParameters(QString::fromUtf8(parameters));
+
+      if ( !withVisibility && !filterIsVisible ) {
+        delete filterItem;
       }
     } else {
-      buffer = stdlib.readLine(4096);
+      lineBegin = lineEnd;
     }
-  } while ( ! buffer.isEmpty() );
-
-  int count = FiltersTreeAbstractItem::countLeaves(model.invisibleRootItem());
-  model.setHorizontalHeaderItem(0,new QStandardItem(QString(QObject::tr("Available filters (%1)")).arg(count)));
+  }
 }
 
 void GmicStdLibParser::saveFiltersVisibility(QStandardItem * item)
 {
-  FiltersTreeAbstractFilterItem * filter = dynamic_cast<FiltersTreeAbstractFilterItem*>(item);
+  FiltersTreeAbstractFilterItem * filter = FiltersTreeAbstractItem::toAbstractFilter(item);
   if ( filter ) {
     FiltersVisibilityMap::setVisibility(filter->hash(),filter->isVisible());
     return;
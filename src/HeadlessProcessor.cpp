@@ -29,6 +29,7 @@
 #include "Common.h"
 #include "GmicStdlibParser.h"
 #include "FilterThread.h"
+#include "ResidentClient.h"
 #include "gmic.h"
 
 #ifdef _IS_WINDOWS_
@@ -39,11 +40,14 @@
 HeadlessProcessor::HeadlessProcessor(QObject *parent, const char *command, GmicQt::InputMode inputMode, GmicQt::OutputMode outputMode)
   : QObject(parent),
     _filterThread(0),
-    _gmicImages(new cimg_library::CImgList<gmic_pixel_type>)
+    _residentClient(0),
+    _gmicImages(new cimg_library::CImgList<gmic_pixel_type>),
+    _gmicImageNames(new cimg_library::CImgList<char>)
 {
   _filterName = "Custom command";
   _lastCommand = "skip 0";
   _lastArguments = command;
+  _lastCommandPrefix.clear();
   _outputMessageMode = GmicQt::Quiet;
   _inputMode = inputMode;
   _outputMode = outputMode;
@@ -58,12 +62,15 @@ HeadlessProcessor::HeadlessProcessor(QObject *parent, const char *command, GmicQ
 HeadlessProcessor::HeadlessProcessor(QObject *parent)
   : QObject(parent),
     _filterThread(0),
-    _gmicImages(new cimg_library::CImgList<gmic_pixel_type>)
+    _residentClient(0),
+    _gmicImages(new cimg_library::CImgList<gmic_pixel_type>),
+    _gmicImageNames(new cimg_library::CImgList<char>)
 {
   QSettings settings;
   _filterName = settings.value(QString("LastExecution/host_%1/FilterName").arg(GmicQt::HostApplicationShortname)).toString();
   _lastCommand = settings.value(QString("LastExecution/host_%1/Command").arg(GmicQt::HostApplicationShortname)).toString();
   _lastArguments = settings.value(QString("LastExecution/host_%1/Arguments").arg(GmicQt::HostApplicationShortname)).toString();
+  _lastCommandPrefix = settings.value(QString("LastExecution/host_%1/CommandPrefix").arg(GmicQt::HostApplicationShortname)).toString();
   _outputMessageMode = (GmicQt::OutputMessageMode) settings.value(QString("LastExecution/host_%1/OutputMessageMode").arg(GmicQt::HostApplicationShortname),GmicQt::Quiet).toInt();
   _inputMode = (GmicQt::InputMode) settings.value(QString("LastExecution/host_%1/InputMode").arg(GmicQt::HostApplicationShortname),GmicQt::InputMode::Active).toInt();;
   _outputMode = (GmicQt::OutputMode) settings.value(QString("LastExecution/host_%1/OutputMode").arg(GmicQt::HostApplicationShortname),GmicQt::OutputMode::InPlace).toInt();;
@@ -81,26 +88,47 @@ HeadlessProcessor::HeadlessProcessor(QObject *parent)
 HeadlessProcessor::~HeadlessProcessor()
 {
   delete _gmicImages;
+  delete _gmicImageNames;
 }
 
 void HeadlessProcessor::startProcessing()
 {
   _singleShotTimer.start();
-  Updater::getInstance()->updateSources(false);
-  GmicStdLibParser::GmicStdlib = Updater::getInstance()->buildFullStdlib();
   _gmicImages->assign();
-  gmic_list<char> imageNames;
-  gmic_qt_get_cropped_images(*_gmicImages,imageNames,-1,-1,-1,-1,_inputMode);
+  _gmicImageNames->assign();
+  gmic_qt_get_cropped_images(*_gmicImages,*_gmicImageNames,-1,-1,-1,-1,_inputMode);
   if ( !_hasProgressWindow ) {
     gmic_qt_show_message(QString("G'MIC: %1").arg(_lastArguments).toUtf8().constData());
   }
+
+  // A resident server, if any, already has the stdlib loaded and parsed
+  _residentClient = new ResidentClient(this);
+  connect(_residentClient,SIGNAL(finished()),
+          this,SLOT(onResidentFinished()));
+  connect(_residentClient,SIGNAL(failed()),
+          this,SLOT(onResidentFailed()));
+  if ( _residentClient->start(_lastCommand,_lastCommandPrefix,_lastArguments,_lastEnvironment,_outputMessageMode,
+                              *_gmicImages,*_gmicImageNames) ) {
+    _timer.start();
+    return;
+  }
+  delete _residentClient;
+  _residentClient = 0;
+  startFilterThread();
+}
+
+void HeadlessProcessor::startFilterThread()
+{
+  Updater::getInstance()->updateSources(false);
+  GmicStdLibParser::GmicStdlib = Updater::getInstance()->buildFullStdlib();
   _filterThread = new FilterThread(this,
                                    _filterName,
                                    _lastCommand,
                                    _lastArguments,
                                    _lastEnvironment,
                                    _outputMessageMode);
-  _filterThread->setInputImages(*_gmicImages,imageNames);
+  _filterThread->setCommandPrefix(_lastCommandPrefix);
+  _filterThread->setInputImages(*_gmicImages,*_gmicImageNames);
   connect(_filterThread,SIGNAL(finished()),
           this,SLOT(onProcessingFinished()));
   _timer.start();
@@ -124,11 +152,18 @@ void HeadlessProcessor::setProgressWindowFlag(bool value)
 
 void HeadlessProcessor::onTimeout()
 {
-  if ( !_filterThread ) {
+  float progress;
+  int ms;
+  if ( _filterThread ) {
+    progress = _filterThread->progress();
+    ms = _filterThread->duration();
+  } else if ( _residentClient ) {
+    // The server does not report progress while a job runs
+    progress = -1;
+    ms = _residentClient->duration();
+  } else {
     return;
   }
-  float progress = _filterThread->progress();
-  int ms = _filterThread->duration();
   unsigned long memory = 0;
 #if defined(_IS_LINUX_)
   QFile status("/proc/self/status");
@@ -153,32 +188,65 @@ void HeadlessProcessor::onTimeout()
 
 void HeadlessProcessor::onProcessingFinished()
 {
+  _timer.stop();
   QString errorMessage;
+  if ( _filterThread->failed() ) {
+    errorMessage = _filterThread->errorMessage();
+  }
+  gmic_list<gmic_pixel_type> images = _filterThread->images();
+  gmic_list<char> imageNames = _filterThread->imageNames();
+  const bool outputImages = !_filterThread->failed() && !_filterThread->aborted();
+  const QString gmicStatus = _filterThread->gmicStatus();
+  _filterThread->deleteLater();
+  _filterThread = 0;
+  endProcessing(gmicStatus,errorMessage,images,imageNames,outputImages);
+}
+
+void HeadlessProcessor::onResidentFinished()
+{
   _timer.stop();
-  QStringList list = GmicStdLibParser::parseStatus(_filterThread->gmicStatus());
+  const QString gmicStatus = _residentClient->gmicStatus();
+  const QString errorMessage = _residentClient->errorMessage();
+  const bool outputImages = errorMessage.isEmpty() && !_residentClient->aborted();
+  _residentClient->deleteLater();
+  _residentClient = 0;
+  endProcessing(gmicStatus,errorMessage,*_gmicImages,*_gmicImageNames,outputImages);
+}
+
+void HeadlessProcessor::onResidentFailed()
+{
+  _timer.stop();
+  _residentClient->deleteLater();
+  _residentClient = 0;
+  startFilterThread();
+}
+
+void HeadlessProcessor::endProcessing(const QString & gmicStatus,
+                                      const QString & errorMessage,
+                                      cimg_library::CImgList<float> & images,
+                                      const cimg_library::CImgList<char> & imageNames,
+                                      bool outputImages)
+{
+  QStringList list = GmicStdLibParser::parseStatus(gmicStatus);
   if ( ! list.isEmpty() ) {
     QSettings settings;
     QString params = list.join(",");
     settings.setValue(QString("LastExecution/host_%1/Arguments").arg(GmicQt::HostApplicationShortname),params);
   }
-  if ( _filterThread->failed() ) {
-    errorMessage = _filterThread->errorMessage();
-  } else {
-    gmic_list<gmic_pixel_type> images = _filterThread->images();
-    if ( !_filterThread->aborted() ) {
-      gmic_qt_output_images(images,
-                            _filterThread->imageNames(),
-                            _outputMode,
-                            (_outputMessageMode == GmicQt::VerboseLayerName) ?
-                              QString("[G'MIC] %1: %2")
-                              .arg(_filterThread->name())
-                              .arg(_filterThread->fullCommand())
-                              .toLocal8Bit().constData()
-                            : 0);
+  if ( outputImages ) {
+    QByteArray layerName;
+    if ( _outputMessageMode == GmicQt::VerboseLayerName ) {
+      QString command = QString("-%1 %2").arg(_lastCommand).arg(_lastArguments);
+      if ( ! _lastCommandPrefix.isEmpty() ) {
+        command.prepend(_lastCommandPrefix + " ");
+      }
+      layerName = QString("[G'MIC] %1: %2").arg(_filterName).arg(command).toLocal8Bit();
     }
+    gmic_qt_output_images(images,
+                          imageNames,
+                          _outputMode,
+                          layerName.isEmpty() ? 0 : layerName.constData());
   }
-  _filterThread->deleteLater();
-  _filterThread = 0;
   _singleShotTimer.stop();
   emit done(errorMessage);
   if ( !_hasProgressWindow && !errorMessage.isEmpty() ) {
@@ -192,4 +260,7 @@ void HeadlessProcessor::cancel()
   if ( _filterThread ) {
     _filterThread->abortGmic();
   }
+  if ( _residentClient ) {
+    _residentClient->cancel();
+  }
 }
@@ -25,33 +25,167 @@
 
 #include "HtmlTranslator.h"
 #include <QRegularExpression>
+#include <QTextDocument>
 #include <QDebug>
 #include "CImg.h"
 #include "Common.h"
 
-QTextDocument HtmlTranslator::_document;
+namespace {
+
+inline bool isHtmlSpace(QChar c)
+{
+  return c == QChar(' ') || c == QChar('\t') || c == QChar('\n') || c == QChar('\r') || c == QChar('\f');
+}
+
+inline bool isAsciiLetter(QChar c)
+{
+  return (c >= QChar('a') && c <= QChar('z')) || (c >= QChar('A') && c <= QChar('Z'));
+}
+
+inline bool isAsciiAlnum(QChar c)
+{
+  return isAsciiLetter(c) || (c >= QChar('0') && c <= QChar('9'));
+}
+
+/*
+ * Inline formatting tags, which produce no text. Any other tag
+ * (<br>, <p>, <img>, ...) is left to QTextDocument.
+ */
+bool isInlineTag(const QString & name)
+{
+  static const char * tags[] = { "b", "i", "u", "s", "em", "strong", "font", "span",
+                                 "sup", "sub", "small", "big", "tt", "code", 0 };
+  for ( const char ** tag = tags; *tag; ++tag ) {
+    if ( ! name.compare(QLatin1String(*tag),Qt::CaseInsensitive) ) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+ * Decode the entity "&name;" found between positions from and to (excluded)
+ * Returns false for entities which are not handled here.
+ */
+bool decodeEntity(const QString & str, int from, int to, QString & result)
+{
+  const QString name = str.mid(from + 1,to - from - 2);
+  if ( name.startsWith(QChar('#')) ) {
+    bool ok = false;
+    uint code = (name.size() > 1 && (name.at(1) == QChar('x') || name.at(1) == QChar('X')))
+        ? name.mid(2).toUInt(&ok,16)
+        : name.mid(1).toUInt(&ok,10);
+    if ( !ok || !code || code > 0x10FFFF ) {
+      return false;
+    }
+    if ( code == 0xA0 ) {
+      code = ' ';
+    }
+    result.append(QString::fromUcs4(&code,1));
+    return true;
+  }
+  static const char * entities[] = { "amp", "&", "lt", "<", "gt", ">", "quot", "\"",
+                                     "apos", "'", "nbsp", " ", 0 };
+  for ( const char ** entity = entities; *entity; entity += 2 ) {
+    if ( name == QLatin1String(entity[0]) ) {
+      result.append(QLatin1String(entity[1]));
+      return true;
+    }
+  }
+  return false;
+}
+
+}
 
 QString HtmlTranslator::html2txt(const QString & str, bool force)
 {
   if ( force || hasHtmlEntities(str) ) {
-    _document.setHtml(str);
-    return fromUtf8Escapes(_document.toPlainText());
+    QString text;
+    if ( ! stripSimpleHtml(str,text) ) {
+      // Local document: filters trees are also built by worker threads
+      QTextDocument document;
+      document.setHtml(str);
+      text = document.toPlainText();
+    }
+    return fromUtf8Escapes(text);
   } else {
-    return fromUtf8Escapes(str);;
+    return fromUtf8Escapes(str);
   }
 }
 
+bool HtmlTranslator::stripSimpleHtml(const QString & str, QString & result)
+{
+  result.clear();
+  result.reserve(str.size());
+  const int size = str.size();
+  bool pendingSpace = false;
+  int i = 0;
+  while ( i < size ) {
+    const QChar c = str.at(i);
+    if ( isHtmlSpace(c) ) {
+      // Whitespace sequences are collapsed, and removed at both ends
+      pendingSpace = true;
+      ++i;
+      continue;
+    }
+    if ( c == QChar('<') && i + 1 < size && (isAsciiLetter(str.at(i + 1)) || str.at(i + 1) == QChar('/')) ) {
+      const int end = str.indexOf(QChar('>'),i);
+      if ( end == -1 ) {
+        return false;
+      }
+      int nameStart = i + 1 + (str.at(i + 1) == QChar('/'));
+      int nameEnd = nameStart;
+      while ( nameEnd < end && isAsciiAlnum(str.at(nameEnd)) ) {
+        ++nameEnd;
+      }
+      if ( ! isInlineTag(str.mid(nameStart,nameEnd - nameStart)) ) {
+        return false;
+      }
+      i = end + 1;
+      continue;
+    }
+    if ( pendingSpace && !result.isEmpty() ) {
+      result.append(QChar(' '));
+    }
+    pendingSpace = false;
+    if ( c == QChar('&') ) {
+      int end = i + 1;
+      while ( end < size && (isAsciiAlnum(str.at(end)) || (end == i + 1 && str.at(end) == QChar('#'))) ) {
+        ++end;
+      }
+      if ( end < size && end > i + 1 && str.at(end) == QChar(';') ) {
+        if ( ! decodeEntity(str,i,end + 1,result) ) {
+          return false;
+        }
+        i = end + 1;
+        continue;
+      }
+    }
+    result.append(c);
+    ++i;
+  }
+  return true;
+}
+
 bool HtmlTranslator::hasHtmlEntities(const QString & str)
 {
-  return str.contains(QRegularExpression("&[a-zA-Z]+;"))
-      || str.contains(QRegularExpression("&#x?[0-9A-Fa-f]+;"))
-      || str.contains(QRegularExpression("<[a-zA-Z]*>"));
+  static const QRegularExpression namedEntity("&[a-zA-Z]+;");
+  static const QRegularExpression numericEntity("&#x?[0-9A-Fa-f]+;");
+  static const QRegularExpression tag("<[a-zA-Z]*>");
+  if ( !str.contains(QChar('&')) && !str.contains(QChar('<')) ) {
+    return false;
+  }
+  return str.contains(namedEntity)
+      || str.contains(numericEntity)
+      || str.contains(tag);
 }
 
 QString HtmlTranslator::fromUtf8Escapes(const QString & str)
 {
+  if ( ! str.contains(QChar('\\')) ) {
+    return str;
+  }
   QByteArray ba = str.toUtf8();
   cimg_library::cimg::strunescape(ba.data());
   return QString::fromUtf8(ba);
 }
-
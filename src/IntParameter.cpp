@@ -33,6 +33,7 @@
 #include <QPalette>
 #include <DialogSettings.h>
 #include "HtmlTranslator.h"
+#include "ParameterWidgetPool.h"
 
 IntParameter::IntParameter(QObject * parent)
   : AbstractParameter(parent,true),
@@ -50,9 +51,9 @@ IntParameter::IntParameter(QObject * parent)
 
 IntParameter::~IntParameter()
 {
-  delete _spinBox;
-  delete _slider;
-  delete _label;
+  ParameterWidgetPool::recycle(_spinBox,this);
+  ParameterWidgetPool::recycle(_slider,this);
+  ParameterWidgetPool::recycle(_label,this);
 }
 
 void
@@ -60,14 +61,15 @@ IntParameter::addTo(QWidget * widget, int row)
 {
   QGridLayout * grid = dynamic_cast<QGridLayout*>(widget->layout());
   if (! grid) return;
-  delete _spinBox;
-  delete _slider;
-  delete _label;
-  _slider = new QSlider(Qt::Horizontal,widget);
+  ParameterWidgetPool::recycle(_spinBox,this);
+  ParameterWidgetPool::recycle(_slider,this);
+  ParameterWidgetPool::recycle(_label,this);
+  _slider = ParameterWidgetPool::take<QSlider>(widget);
+  _slider->setOrientation(Qt::Horizontal);
   _slider->setMinimumWidth(SLIDER_MIN_WIDTH);
   _slider->setRange(_min,_max);
   _slider->setValue(_value);
-  _spinBox = new QSpinBox(widget);
+  _spinBox = ParameterWidgetPool::take<QSpinBox>(widget);
   _spinBox->setRange(_min,_max);
   _spinBox->setValue(_value);
   if ( DialogSettings::darkThemeEnabled() ) {
@@ -76,7 +78,9 @@ IntParameter::addTo(QWidget * widget, int row)
     p.setColor(QPalette::Highlight, QColor(130,130,130));
     _slider->setPalette(p);
   }
-  grid->addWidget(_label = new QLabel(_name,widget),row,0,1,1);
+  _label = ParameterWidgetPool::take<QLabel>(widget);
+  _label->setText(_name);
+  grid->addWidget(_label,row,0,1,1);
   grid->addWidget(_slider,row,1,1,1);
   grid->addWidget(_spinBox,row,2,1,1);
   connectSliderSpinBox();
@@ -111,9 +115,9 @@ IntParameter::reset()
 }
 
 void
-IntParameter::initFromText(const char * text, int & textLength)
+IntParameter::initFromDefinition(const ParameterDefinition & definition)
 {
-  QList<QString> list = parseText("int",text,textLength);
+  QList<QString> list = parseDefinition(definition);
   _name = HtmlTranslator::html2txt(list[0]);
   QList<QString> values = list[1].split(QChar(','));
   _default = values[0].toInt();
@@ -0,0 +1,58 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file InterpreterState.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "InterpreterState.h"
+#include "gmic.h"
+
+InterpreterState::InterpreterState()
+  : _variables(new gmic_list<char>[gmic_varslots]),
+    _variablesNames(new gmic_list<char>[gmic_varslots]),
+    _verbosity(0)
+{
+}
+
+InterpreterState::~InterpreterState()
+{
+  delete [] _variables;
+  delete [] _variablesNames;
+}
+
+void InterpreterState::save(const gmic & interpreter)
+{
+  for ( unsigned int slot = 0; slot < gmic_varslots; ++slot ) {
+    _variables[slot] = interpreter._variables[slot];
+    _variablesNames[slot] = interpreter._variables_names[slot];
+  }
+  _verbosity = interpreter.verbosity;
+}
+
+void InterpreterState::restore(gmic & interpreter) const
+{
+  for ( unsigned int slot = 0; slot < gmic_varslots; ++slot ) {
+    interpreter._variables[slot] = _variables[slot];
+    interpreter._variables_names[slot] = _variablesNames[slot];
+  }
+  interpreter.verbosity = _verbosity;
+  interpreter.status.assign();
+}
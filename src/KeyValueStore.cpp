@@ -0,0 +1,474 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file KeyValueStore.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "KeyValueStore.h"
+#include <QLockFile>
+#include <QSaveFile>
+#include <QtEndian>
+#include <QDebug>
+#ifndef _IS_WINDOWS_
+#include <sys/stat.h>
+#endif
+
+namespace {
+const char Magic[] = "GMQTKV01";
+const qint64 MagicSize = 8;
+const qint64 HeaderSize = 3 * sizeof(quint32);
+const qint64 CompactionMinimumSize = 64 * 1024;
+const int LockTimeout = 5000; // ms
+
+inline qint64 recordSize(int keySize, quint32 valueSize)
+{
+  return HeaderSize + keySize + ((valueSize == KeyValueStore::RemovedRecord) ? 0 : valueSize);
+}
+
+class StoreLocker {
+public:
+  StoreLocker(QLockFile * lock, const QString & filename)
+    : _lock(lock),
+      _locked(lock && lock->tryLock(LockTimeout))
+  {
+    if ( lock && ! _locked ) {
+      qWarning() << "[gmic-qt] Cannot lock" << filename;
+    }
+  }
+  ~StoreLocker()
+  {
+    if ( _locked ) {
+      _lock->unlock();
+    }
+  }
+  bool isLocked() const { return _locked; }
+private:
+  QLockFile * _lock;
+  bool _locked;
+};
+}
+
+KeyValueStore::KeyValueStore()
+  : _map(0),
+    _mapSize(0),
+    _end(0),
+    _liveBytes(0)
+{
+}
+
+KeyValueStore::~KeyValueStore()
+{
+  close();
+}
+
+bool KeyValueStore::open(const QString & filename)
+{
+  close();
+  _lock.reset(new QLockFile(filename + ".lock"));
+  StoreLocker locker(_lock.data(),filename);
+  if ( ! locker.isLocked() || ! openFile(filename) ) {
+    _lock.reset();
+    return false;
+  }
+  return true;
+}
+
+bool KeyValueStore::openFile(const QString & filename)
+{
+  unmap();
+  if ( _file.isOpen() ) {
+    _file.close();
+  }
+  _index.clear();
+  _end = 0;
+  _liveBytes = 0;
+  _file.setFileName(filename);
+  if ( ! _file.open(QFile::ReadWrite) ) {
+    qWarning() << "[gmic-qt] Cannot open" << filename << _file.errorString();
+    return false;
+  }
+  if ( _file.size() < MagicSize || _file.read(MagicSize) != QByteArray(Magic,MagicSize) ) {
+    if ( _file.size() ) {
+      qWarning() << "[gmic-qt] Not a key/value store, starting anew:" << filename;
+    }
+    if ( ! _file.resize(0) || _file.write(Magic,MagicSize) != MagicSize || ! _file.flush() ) {
+      qWarning() << "[gmic-qt] Cannot write" << filename << _file.errorString();
+      _file.close();
+      return false;
+    }
+  }
+  if ( ! scan(MagicSize) ) {
+    unmap();
+    _file.close();
+    _index.clear();
+    return false;
+  }
+  return true;
+}
+
+void KeyValueStore::close()
+{
+  unmap();
+  if ( _file.isOpen() ) {
+    _file.close();
+  }
+  _lock.reset();
+  _index.clear();
+  _end = 0;
+  _liveBytes = 0;
+}
+
+bool KeyValueStore::isOpen() const
+{
+  return _file.isOpen();
+}
+
+QString KeyValueStore::filename() const
+{
+  return _file.fileName();
+}
+
+bool KeyValueStore::map()
+{
+  unmap();
+  _mapSize = _file.size();
+  _map = _file.map(0,_mapSize);
+  if ( ! _map ) {
+    _mapSize = 0;
+  }
+  return _map;
+}
+
+void KeyValueStore::unmap()
+{
+  if ( _map ) {
+    _file.unmap(_map);
+    _map = 0;
+  }
+  _mapSize = 0;
+}
+
+bool KeyValueStore::isReplaced() const
+{
+#ifdef _IS_WINDOWS_
+  // An open file cannot be replaced here: compact() fails instead
+  return false;
+#else
+  struct stat opened;
+  struct stat current;
+  if ( fstat(_file.handle(),&opened) ) {
+    return false;
+  }
+  if ( stat(QFile::encodeName(_file.fileName()).constData(),&current) ) {
+    return true;
+  }
+  return opened.st_ino != current.st_ino || opened.st_dev != current.st_dev;
+#endif
+}
+
+bool KeyValueStore::sync()
+{
+  if ( ! _file.isOpen() ) {
+    return false;
+  }
+  if ( isReplaced() ) {
+    // Compacted by another process
+    return openFile(_file.fileName());
+  }
+  if ( _file.size() != _end ) {
+    // Records appended by other processes (or an interrupted write)
+    return scan(_end);
+  }
+  return true;
+}
+
+bool KeyValueStore::scan(qint64 from)
+{
+  if ( ! map() ) {
+    qWarning() << "[gmic-qt] Cannot map" << _file.fileName() << _file.errorString();
+    return false;
+  }
+  if ( from <= MagicSize ) {
+    _index.clear();
+    _liveBytes = 0;
+    from = MagicSize;
+  }
+  qint64 position = from;
+  qint64 size;
+  bool corrupted;
+  while ( (size = indexRecord(position,_mapSize,corrupted)) ) {
+    if ( corrupted ) {
+      qWarning() << "[gmic-qt] Skipping a corrupted record at offset" << position << "in" << _file.fileName();
+    }
+    position += size;
+  }
+  _end = position;
+  if ( _end < _mapSize ) {
+    // Incomplete last record (interrupted write): nothing can follow it
+    qWarning() << "[gmic-qt] Dropping" << (_mapSize - _end) << "trailing bytes from" << _file.fileName();
+    unmap();
+    if ( ! _file.resize(_end) ) {
+      return false;
+    }
+    map();
+  }
+  return true;
+}
+
+qint64 KeyValueStore::indexRecord(qint64 position, qint64 limit, bool & corrupted)
+{
+  corrupted = false;
+  if ( position + HeaderSize > limit ) {
+    return 0;
+  }
+  const uchar * header = _map + position;
+  const quint32 keySize = qFromLittleEndian<quint32>(header);
+  const quint32 valueSize = qFromLittleEndian<quint32>(header + sizeof(quint32));
+  const quint32 sum = qFromLittleEndian<quint32>(header + 2 * sizeof(quint32));
+  const bool removed = (valueSize == RemovedRecord);
+  const qint64 size = HeaderSize + qint64(keySize) + (removed ? 0 : qint64(valueSize));
+  if ( position + size > limit ) {
+    return 0;
+  }
+  const char * data = reinterpret_cast<const char*>(header + HeaderSize);
+  QByteArray key(data,keySize);
+  QByteArray value = removed ? QByteArray() : QByteArray::fromRawData(data + keySize,valueSize);
+  if ( checksum(key,value,valueSize) != sum || (key.isEmpty() && removed) ) {
+    // The sizes fit in the file: skip this record only
+    corrupted = true;
+    return size;
+  }
+  if ( key.isEmpty() ) {
+    // Transaction: the checksum above guarantees it was entirely written
+    qint64 nested = position + HeaderSize;
+    const qint64 nestedEnd = nested + valueSize;
+    bool nestedCorrupted;
+    qint64 nestedSize;
+    while ( nested < nestedEnd && (nestedSize = indexRecord(nested,nestedEnd,nestedCorrupted)) && ! nestedCorrupted ) {
+      nested += nestedSize;
+    }
+    corrupted = (nested != nestedEnd);
+    return size;
+  }
+  updateIndex(key,position + HeaderSize + keySize,valueSize);
+  return size;
+}
+
+void KeyValueStore::updateIndex(const QByteArray & key, qint64 offset, quint32 valueSize)
+{
+  QHash<QByteArray,Entry>::iterator it = _index.find(key);
+  if ( it != _index.end() ) {
+    _liveBytes -= recordSize(key.size(),it.value().size);
+    _index.erase(it);
+  }
+  if ( valueSize != RemovedRecord ) {
+    Entry entry;
+    entry.offset = offset;
+    entry.size = valueSize;
+    _index.insert(key,entry);
+    _liveBytes += recordSize(key.size(),valueSize);
+  }
+}
+
+bool KeyValueStore::contains(const QByteArray & key) const
+{
+  return _index.contains(key);
+}
+
+QByteArray KeyValueStore::value(const QByteArray & key) const
+{
+  QHash<QByteArray,Entry>::const_iterator it = _index.find(key);
+  if ( it == _index.end() ) {
+    return QByteArray();
+  }
+  const Entry & entry = it.value();
+  if ( entry.offset + entry.size <= _mapSize ) {
+    return QByteArray(reinterpret_cast<const char*>(_map + entry.offset),entry.size);
+  }
+  // Appended after the file was mapped
+  if ( ! _file.seek(entry.offset) ) {
+    return QByteArray();
+  }
+  return _file.read(entry.size);
+}
+
+QList<QByteArray> KeyValueStore::keys() const
+{
+  return _index.keys();
+}
+
+bool KeyValueStore::insert(const QByteArray & key, const QByteArray & value)
+{
+  if ( key.isEmpty() ) {
+    return false;
+  }
+  StoreLocker locker(_lock.data(),_file.fileName());
+  if ( ! locker.isLocked() || ! sync() || ! append(record(key,value,false)) ) {
+    return false;
+  }
+  updateIndex(key,_end - value.size(),static_cast<quint32>(value.size()));
+  return true;
+}
+
+bool KeyValueStore::remove(const QByteArray & key)
+{
+  StoreLocker locker(_lock.data(),_file.fileName());
+  if ( ! locker.isLocked() || ! sync() ) {
+    return false;
+  }
+  if ( ! _index.contains(key) ) {
+    return true;
+  }
+  if ( ! append(record(key,QByteArray(),true)) ) {
+    return false;
+  }
+  updateIndex(key,0,RemovedRecord);
+  return true;
+}
+
+bool KeyValueStore::write(const QHash<QByteArray,QByteArray> & inserts,
+                          const QList<QByteArray> & removals)
+{
+  struct Change {
+    QByteArray key;
+    qint64 offset;
+    quint32 valueSize;
+  };
+  if ( inserts.contains(QByteArray()) ) {
+    return false;
+  }
+  StoreLocker locker(_lock.data(),_file.fileName());
+  if ( ! locker.isLocked() || ! sync() ) {
+    return false;
+  }
+  QList<Change> changes;
+  QByteArray body;
+  for ( const QByteArray & key : removals ) {
+    if ( _index.contains(key) && ! inserts.contains(key) ) {
+      body.append(record(key,QByteArray(),true));
+      Change change = { key, 0, RemovedRecord };
+      changes.push_back(change);
+    }
+  }
+  QHash<QByteArray,QByteArray>::const_iterator it = inserts.begin();
+  while ( it != inserts.end() ) {
+    body.append(record(it.key(),it.value(),false));
+    Change change = { it.key(), body.size() - it.value().size(), static_cast<quint32>(it.value().size()) };
+    changes.push_back(change);
+    ++it;
+  }
+  if ( changes.isEmpty() ) {
+    return true;
+  }
+  const qint64 bodyOffset = _end + HeaderSize;
+  if ( ! append(record(QByteArray(),body,false)) ) {
+    return false;
+  }
+  for ( const Change & change : changes ) {
+    updateIndex(change.key,bodyOffset + change.offset,change.valueSize);
+  }
+  return true;
+}
+
+bool KeyValueStore::append(const QByteArray & data)
+{
+  // Called with the lock held, after sync(): _end is the end of the file
+  if ( ! _file.isOpen() ) {
+    return false;
+  }
+  if ( ! _file.seek(_end) || _file.write(data) != data.size() || ! _file.flush() ) {
+    qWarning() << "[gmic-qt] Cannot write" << _file.fileName() << _file.errorString();
+    // Do not leave a partial record in the middle of the file
+    _file.resize(_end);
+    return false;
+  }
+  _end += data.size();
+  return true;
+}
+
+bool KeyValueStore::needsCompaction() const
+{
+  return _end > CompactionMinimumSize && (_end - MagicSize) > 2 * _liveBytes;
+}
+
+bool KeyValueStore::compact()
+{
+  if ( ! _file.isOpen() ) {
+    return false;
+  }
+  const QString filename = _file.fileName();
+  StoreLocker locker(_lock.data(),filename);
+  if ( ! locker.isLocked() || ! sync() ) {
+    return false;
+  }
+  QSaveFile file(filename);
+  if ( ! file.open(QFile::WriteOnly) ) {
+    qWarning() << "[gmic-qt] Cannot write" << filename << file.errorString();
+    return false;
+  }
+  file.write(Magic,MagicSize);
+  QHash<QByteArray,Entry>::const_iterator it = _index.begin();
+  while ( it != _index.end() ) {
+    file.write(record(it.key(),value(it.key()),false));
+    ++it;
+  }
+  // The file being replaced must not be mapped (nor opened) on some systems
+  unmap();
+  _file.close();
+  if ( ! file.commit() ) {
+    qWarning() << "[gmic-qt] Cannot write" << filename << file.errorString();
+  }
+  // Other processes see the new file identity in sync() and reopen it
+  return openFile(filename);
+}
+
+QByteArray KeyValueStore::record(const QByteArray & key, const QByteArray & value, bool removed)
+{
+  const quint32 valueSize = removed ? RemovedRecord : static_cast<quint32>(value.size());
+  QByteArray data(HeaderSize,'\0');
+  uchar * header = reinterpret_cast<uchar*>(data.data());
+  qToLittleEndian<quint32>(static_cast<quint32>(key.size()),header);
+  qToLittleEndian<quint32>(valueSize,header + sizeof(quint32));
+  qToLittleEndian<quint32>(checksum(key,value,valueSize),header + 2 * sizeof(quint32));
+  data.append(key);
+  if ( ! removed ) {
+    data.append(value);
+  }
+  return data;
+}
+
+quint32 KeyValueStore::checksum(const QByteArray & key, const QByteArray & value, quint32 valueSize)
+{
+  // FNV-1a over the value size, the key and the value
+  quint32 h = 2166136261u;
+  for ( int i = 0; i < 4; ++i ) {
+    h = (h ^ ((valueSize >> (8 * i)) & 0xFF)) * 16777619u;
+  }
+  const char * p = key.constData();
+  for ( int i = 0; i < key.size(); ++i ) {
+    h = (h ^ static_cast<uchar>(p[i])) * 16777619u;
+  }
+  p = value.constData();
+  for ( int i = 0; i < value.size(); ++i ) {
+    h = (h ^ static_cast<uchar>(p[i])) * 16777619u;
+  }
+  return h;
+}
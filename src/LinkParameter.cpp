@@ -76,9 +76,9 @@ LinkParameter::reset()
 }
 
 void
-LinkParameter::initFromText(const char * text, int & textLength)
+LinkParameter::initFromDefinition(const ParameterDefinition & definition)
 {
-  QList<QString> list = parseText("link",text,textLength);
+  QList<QString> list = parseDefinition(definition);
   QList<QString> values = list[1].split(QChar(','));
 
   if ( values.size() == 3 ) {
@@ -60,10 +60,12 @@
 #include "FiltersTreeFolderItem.h"
 #include "FiltersTreeFaveItem.h"
 #include "FiltersVisibilityMap.h"
+#include "UserCatalog.h"
 #include "Updater.h"
 #include "GmicStdlibParser.h"
 #include "ImageTools.h"
 #include "LayersExtentProxy.h"
+#include "FiltersTreeBuilder.h"
 #include "host.h"
 #include "gmic.h"
 
@@ -128,6 +130,10 @@ MainWindow::MainWindow(QWidget *parent) :
   ui->tbRenameFave->setEnabled(false);
   ui->tbRemoveFave->setToolTip(tr("Remove fave"));
   ui->tbRemoveFave->setEnabled(false);
+  ui->tbAddToChain->setToolTip(tr("Add filter to chain"));
+  ui->tbAddToChain->setEnabled(false);
+  ui->tbClearChain->setToolTip(tr("Clear filter chain"));
+  ui->tbClearChain->setEnabled(false);
   ui->pbFullscreen->setCheckable(true);
   ui->pbCancel->setShortcut(QKeySequence(Qt::Key_Escape));
   ui->tbExpandCollapse->setToolTip(tr("Expand/Collapse all"));
@@ -148,7 +154,10 @@ MainWindow::MainWindow(QWidget *parent) :
 
   ui->cbPreview->setChecked(true);
 
-  _currentFiltersTreeModel = & _filtersTreeModel;
+  _searchActive = false;
+  _startupFinished = false;
+  _startupDownloadsOk = true;
+  _filtersTreeGeneration = 0;
 
   ui->filterName->setTextFormat(Qt::RichText);
   ui->filterName->setVisible(false);
@@ -164,6 +173,8 @@ MainWindow::MainWindow(QWidget *parent) :
 
   _selectedAbstractFilterItem = nullptr;
 
+  _searchResultsModel.setSourceModel(&_filtersTreeModel);
+
   FiltersTreeItemDelegate * delegate = new FiltersTreeItemDelegate(ui->filtersTree);
   ui->filtersTree->setItemDelegate(delegate);
   connect(delegate,SIGNAL(commitData(QWidget*)),
@@ -184,11 +195,9 @@ MainWindow::MainWindow(QWidget *parent) :
   ParametersCache::load(!_newSession);
 
   setIcons();
-
-  LayersExtentProxy::clearCache();
-  QSize layersExtents = LayersExtentProxy::getExtent(ui->inOutSelector->inputMode());
-  ui->previewWidget->setFullImageSize(layersExtents);
   makeConnections();
+  connect(&_startupPipeline,SIGNAL(finished(bool)),
+          this,SLOT(onStartupFinished(bool)));
 }
 
 MainWindow::~MainWindow()
@@ -197,15 +206,22 @@ MainWindow::~MainWindow()
   //  FiltersTreeAbstractItem::buildHashesList(_filtersTreeModel.invisibleRootItem(),hashes);
   //  ParametersCache::cleanup(hashes);
 
-  saveCurrentParameters();
-  saveFaves();
-  ParametersCache::save();
+  // Workers may still be reading the files saved below
+  _startupPipeline.waitForDone();
+  for ( FiltersTreeBuilder * builder : findChildren<FiltersTreeBuilder*>() ) {
+    builder->wait();
+  }
+  if ( _startupFinished ) {
+    saveCurrentParameters();
+    saveFaves();
 
-  // Save visibility
-  if ( filtersSelectionMode() ) {
-    GmicStdLibParser::saveFiltersVisibility(_filtersTreeModel.invisibleRootItem());
+    // Save visibility
+    if ( filtersSelectionMode() ) {
+      GmicStdLibParser::saveFiltersVisibility(_filtersTreeModel.invisibleRootItem());
+    }
+    FiltersVisibilityMap::save();
   }
-  FiltersVisibilityMap::save();
+  UserCatalog::close();
 
   saveSettings();
   if ( _logFile ) {
@@ -232,6 +248,8 @@ void MainWindow::setIcons()
   ui->pbCancel->setIcon(LOAD_ICON("process-stop"));
   ui->tbAddFave->setIcon(LOAD_ICON("bookmark-add"));
   ui->tbRemoveFave->setIcon(LOAD_ICON("bookmark-remove"));
+  ui->tbAddToChain->setIcon(LOAD_ICON("list-add"));
+  ui->tbClearChain->setIcon(LOAD_ICON("edit-clear"));
   ui->tbSelectionMode->setIcon(LOAD_ICON("selection_mode"));
   _expandIcon = LOAD_ICON("draw-arrow-down");
   _collapseIcon = LOAD_ICON("draw-arrow-up");
@@ -306,16 +324,45 @@ void MainWindow::onUpdateDownloadsFinished(bool ok)
     }
   }
 
-  buildFiltersTree();
+  // The stdlib is assembled here (Updater is not thread safe), and parsed by a worker thread
+  buildFiltersTreeInBackground(Updater::getInstance()->buildFullStdlib());
+}
 
-  ui->filtersTree->update();
-  ui->tbUpdateFilters->setEnabled(true);
-  if ( _selectedAbstractFilterItem ) {
-    ui->previewWidget->sendUpdateRequest();
+void MainWindow::buildFiltersTreeInBackground(const QByteArray & stdlib)
+{
+  FiltersTreeBuilder * builder = new FiltersTreeBuilder(this,stdlib,filtersSelectionMode(),++_filtersTreeGeneration);
+  connect(builder,SIGNAL(finished()),
+          this,SLOT(onFiltersTreeBuilderFinished()));
+  builder->start();
+}
+
+void MainWindow::onFiltersTreeBuilderFinished()
+{
+  FiltersTreeBuilder * builder = qobject_cast<FiltersTreeBuilder*>(sender());
+  if ( !builder ) {
+    return;
   }
+  // Results of a superseded build are dropped
+  if ( builder->generation() == _filtersTreeGeneration ) {
+    if ( builder->withVisibility() != filtersSelectionMode() ) {
+      // Selection mode toggled during startup
+      buildFiltersTreeInBackground(builder->stdlib());
+    } else {
+      GmicStdLibParser::GmicStdlib = builder->stdlib();
+      installFiltersTree(builder->takeRoot(),builder->filtersCount(),builder->withVisibility());
+      ui->filtersTree->update();
+      ui->tbUpdateFilters->setEnabled(true);
+      if ( !_startupFinished ) {
+        finishStartup();
+      } else if ( _selectedAbstractFilterItem ) {
+        ui->previewWidget->sendUpdateRequest();
+      }
+    }
+  }
+  builder->deleteLater();
 }
 
-void MainWindow::buildFiltersTree()
+void MainWindow::installFiltersTree(QStandardItem * root, int filtersCount, bool withVisibility)
 {
   // Save current expand/collapse status
   backupExpandedFoldersPaths();
@@ -323,11 +370,24 @@ void MainWindow::buildFiltersTree()
   if ( !currentHash.isEmpty() ) {
     saveCurrentParameters();
   }
-  GmicStdLibParser::GmicStdlib = Updater::getInstance()->buildFullStdlib();
-  _filtersTreeModel.clear();
-  _filtersTreeModelSelection.clear();
-  const bool withVisibility = filtersSelectionMode();
-  GmicStdLibParser::buildFiltersTree(_filtersTreeModel,withVisibility);
+  _selectedAbstractFilterItem = nullptr;
+
+  // Swap the contents of the model in one go, the view being frozen meanwhile
+  ui->filtersTree->setUpdatesEnabled(false);
+  _filtersRegistry.clear();
+  _filtersSearchIndex.clear();
+  _filtersTreeModel.removeRows(0,_filtersTreeModel.rowCount());
+  _filtersTreeModel.setColumnCount(withVisibility ? 2 : 1);
+  updateFiltersCountHeader(filtersCount);
+  if ( withVisibility ) {
+    _filtersTreeModel.setHorizontalHeaderItem(1,new QStandardItem(tr("Visible")));
+  }
+  QStandardItem * modelRoot = _filtersTreeModel.invisibleRootItem();
+  while ( root->rowCount() ) {
+    modelRoot->appendRow(root->takeRow(0));
+  }
+  delete root;
+  _filtersRegistry.addItems(modelRoot);
   ui->filtersTree->setModel(&_filtersTreeModel);
 
   loadFaves(withVisibility);
@@ -353,16 +413,23 @@ void MainWindow::buildFiltersTree()
   restoreExpandedFolders();
 
   // Restore display of search results
+  _filtersSearchIndex.build(_filtersTreeModel.invisibleRootItem());
   QString searchText = ui->searchField->text();
   if ( !searchText.isEmpty() ) {
     search(searchText);
   }
 
-  // Select previously selected filter
-  _selectedAbstractFilterItem = currentHash.isEmpty() ? nullptr : findFilter(currentHash);
+  // Select previously selected filter (or fave)
+  if ( !currentHash.isEmpty() ) {
+    _selectedAbstractFilterItem = findFilter(currentHash);
+    if ( !_selectedAbstractFilterItem ) {
+      _selectedAbstractFilterItem = findFave(currentHash);
+    }
+  }
+  ui->filtersTree->setUpdatesEnabled(true);
   if ( _selectedAbstractFilterItem ) {
-    ui->filtersTree->setCurrentIndex(_selectedAbstractFilterItem->index());
-    ui->filtersTree->scrollTo(_selectedAbstractFilterItem->index(),QAbstractItemView::PositionAtCenter);
+    ui->filtersTree->setCurrentIndex(viewIndex(_selectedAbstractFilterItem->index()));
+    ui->filtersTree->scrollTo(viewIndex(_selectedAbstractFilterItem->index()),QAbstractItemView::PositionAtCenter);
     activateFilter(_selectedAbstractFilterItem->index(),false);
   } else {
     setNoFilter();
@@ -370,17 +437,91 @@ void MainWindow::buildFiltersTree()
   }
 }
 
-void MainWindow::startupUpdateFinished(bool ok)
+void MainWindow::startup(int ageLimit, bool useNetwork)
 {
-  QObject::disconnect(Updater::getInstance(),SIGNAL(downloadsFinished(bool)),
-                      this,SLOT(startupUpdateFinished(bool)));
+  // Files and sources are read by worker threads while the host
+  // is queried (it may not be thread safe) and the window is shown.
+  _startupPipeline.start(ageLimit,4,useNetwork);
+
+  LayersExtentProxy::clearCache();
+  QSize layersExtents = LayersExtentProxy::getExtent(ui->inOutSelector->inputMode());
+  ui->previewWidget->setFullImageSize(layersExtents);
+  _startupPipeline.mark("Layers extent");
+
+  ui->tbUpdateFilters->setEnabled(false);
+  showMessage(tr("Loading filters..."),60000);
   if ( _showMaximized  ) {
     show();
     showMaximized();
   } else {
     show();
   }
-  if ( !ok ) {
+  _startupPipeline.mark("Window shown");
+
+  // Fetched from the host now, while the workers read the filters
+  ui->previewWidget->originalImage();
+  _startupPipeline.mark("Preview original image");
+
+  _startupPipeline.hold("Faves import");
+  importFaves();
+  _startupPipeline.release("Faves import");
+}
+
+void MainWindow::onStartupFinished(bool downloadsOk)
+{
+  _startupDownloadsOk = downloadsOk;
+  // The stdlib is parsed by a worker thread, see finishStartup()
+  buildFiltersTreeInBackground(_startupPipeline.takeStdlib());
+}
+
+void MainWindow::finishStartup()
+{
+  clearMessage();
+  _startupFinished = true;
+  _startupPipeline.mark("Filters tree");
+
+  // Retrieve and select previously selected filter
+  QString hash = QSettings().value("SelectedFilter",QString()).toString();
+  if (_newSession || !_lastExecutionOK) {
+    hash.clear();
+  }
+  FiltersTreeAbstractFilterItem * filterItem = 0;
+  if ( !hash.isEmpty() ) {
+    filterItem = findFilter(hash);
+    if ( !filterItem ) {
+      filterItem = findFave(hash);
+    }
+  }
+  if ( filterItem ) {
+    ui->filtersTree->setCurrentIndex(viewIndex(filterItem->index()));
+    ui->filtersTree->scrollTo(viewIndex(filterItem->index()),QAbstractItemView::PositionAtCenter);
+    activateFilter(filterItem->index(),true);
+    // The window has already been activated, so the preview
+    // widget will not request an update by itself.
+    ui->previewWidget->sendUpdateRequest();
+  } else {
+    if ( hash.isEmpty() ) {
+      // Expand fave folder
+      FiltersTreeFolderItem * faves = faveFolder();
+      if ( faves ) {
+        QModelIndex index = faves->index();
+        ui->filtersTree->expand(index);
+      }
+      ui->previewWidget->setPreviewFactor(GmicQt::PreviewFactorFullImage,true);
+    }
+    ui->filtersTree->setSizeAdjustPolicy(QAbstractScrollArea::AdjustToContents);
+    ui->filtersTree->setSizePolicy(QSizePolicy::Preferred,QSizePolicy::Preferred);
+    ui->filtersTree->adjustSize();
+  }
+  _startupPipeline.mark("Filter selection");
+
+  if ( ui->inOutSelector->outputMessageMode() > GmicQt::VerboseLayerName ) {
+    std::fprintf(cimg_library::cimg::output(),"\n[gmic_qt] Startup timeline:\n%s",
+                 _startupPipeline.timeline().toLocal8Bit().constData());
+    std::fflush(cimg_library::cimg::output());
+  }
+
+  if ( !_startupDownloadsOk ) {
     showUpdateErrors();
   } else if (Updater::getInstance()->someNetworkUpdateAchieved() ) {
     showMessage(tr("Filter definitions have been updated"),4000);
@@ -416,13 +557,17 @@ void MainWindow::updateZoomLabel(double zoom)
 
 void MainWindow::onFiltersSelectionModeToggled(bool on)
 {
+  if ( !_startupFinished ) {
+    // The tree being built is rebuilt on arrival, see onFiltersTreeBuilderFinished()
+    return;
+  }
   if ( on ) {
     ui->searchField->clear();
   }
   if ( ! on ) {
     GmicStdLibParser::saveFiltersVisibility(_filtersTreeModel.invisibleRootItem());
   }
-  buildFiltersTree();
+  buildFiltersTreeInBackground(GmicStdLibParser::GmicStdlib);
 }
 
 void MainWindow::clearMessage()
@@ -513,6 +658,10 @@ void MainWindow::makeConnections()
           this,SLOT(onRemoveFave()));
   connect(ui->tbRenameFave,SIGNAL(clicked(bool)),
           this,SLOT(onRenameFave()));
+  connect(ui->tbAddToChain,SIGNAL(clicked(bool)),
+          this,SLOT(onAddToChain()));
+  connect(ui->tbClearChain,SIGNAL(clicked(bool)),
+          this,SLOT(onClearChain()));
 
   connect(ui->inOutSelector,SIGNAL(inputModeChanged(GmicQt::InputMode)),
           ui->previewWidget,SLOT(sendUpdateRequest()));
@@ -541,7 +690,7 @@ void MainWindow::makeConnections()
 void
 MainWindow::onFilterClicked(QModelIndex index)
 {
-  activateFilter(index,false);
+  activateFilter(treeIndex(index),false);
   ui->previewWidget->sendUpdateRequest();
 }
 
@@ -564,17 +713,44 @@ MainWindow::onPreviewUpdateRequested()
     }
   }
 
-  if ( !_selectedAbstractFilterItem || ui->filterParams->previewCommand().isEmpty() || ui->filterParams->previewCommand() == "_none_" ) {
+  const bool chainOnly = !_selectedAbstractFilterItem && !_filterChain.isEmpty();
+  if ( !chainOnly && ( !_selectedAbstractFilterItem || ui->filterParams->previewCommand().isEmpty() || ui->filterParams->previewCommand() == "_none_" ) ) {
     ui->previewWidget->displayOriginalImage();
   } else {
-    _gmicImages->assign(1);
     double x,y,w,h;
     ui->previewWidget->normalizedVisibleRect(x,y,w,h);
     GmicQt::InputMode inputMode = ui->inOutSelector->inputMode();
+    double zoomFactor = ui->previewWidget->currentZoomFactor();
+    QString env = ui->inOutSelector->gmicEnvString();
+    env += QString(" _preview_width=%1 _preview_height=%2")
+        .arg(ui->previewWidget->width())
+        .arg(ui->previewWidget->height());
+
+    // Parameters are compared through their fingerprint: a preview identical
+    // to the last computed one (e.g. a value set back, the same filter
+    // clicked again) is not computed again.
+    const QString previewKey = QString("%1|%2|%3|%4|%5|%6|%7,%8,%9,%10|%11|%12")
+        .arg(chainOnly ? QString() : _selectedAbstractFilterItem->hash())
+        .arg(chainOnly ? 0u : ui->filterParams->valueFingerprint())
+        .arg(chainOnly ? QString() : ui->filterParams->previewCommand())
+        .arg(_filterChain.commandLine(true))
+        .arg(env)
+        .arg(static_cast<int>(inputMode))
+        .arg(x).arg(y).arg(w).arg(h)
+        .arg(zoomFactor)
+        .arg(static_cast<int>(ui->inOutSelector->outputMessageMode()));
+    if ( previewKey == _lastPreviewKey ) {
+      ui->previewWidget->setPreviewImage(_lastPreviewImage);
+      ui->previewWidget->savePreview();
+      _okButtonShouldApply = true;
+      return;
+    }
+    _pendingPreviewKey = previewKey;
+
+    _gmicImages->assign(1);
     gmic_list<char> imageNames;
     gmic_qt_get_cropped_images(*_gmicImages,imageNames,x,y,w,h,inputMode);
     ui->previewWidget->updateImageNames(imageNames,inputMode);
-    double zoomFactor = ui->previewWidget->currentZoomFactor();
     if ( zoomFactor < 1.0 ) {
       QImage qimage;
       QImage scaled;
@@ -587,17 +763,14 @@ MainWindow::onPreviewUpdateRequested()
         //  image.resize(image.width()*zoomFactor,image.height()*zoomFactor,1,-100,1);
       }
     }
-    QString env = ui->inOutSelector->gmicEnvString();
-    env += QString(" _preview_width=%1 _preview_height=%2")
-        .arg(ui->previewWidget->width())
-        .arg(ui->previewWidget->height());
-    Q_ASSERT_X(_selectedAbstractFilterItem,"MainWindow::onPreviewUpdateRequested()","No filter selected");
+    // Without a selected filter, the chain runs alone as the prefix of a no-op command
     _filterThread = new FilterThread(this,
-                                     _selectedAbstractFilterItem->plainText(),
-                                     ui->filterParams->previewCommand(),
-                                     ui->filterParams->valueString(),
+                                     chainOnly ? _filterChain.names() : _selectedAbstractFilterItem->plainText(),
+                                     chainOnly ? QString("skip") : ui->filterParams->previewCommand(),
+                                     chainOnly ? QString("0") : ui->filterParams->valueString(),
                                      env,
                                      ui->inOutSelector->outputMessageMode());
+    _filterThread->setCommandPrefix(_filterChain.commandLine(true));
     _filterThread->setInputImages(*_gmicImages,imageNames);
     connect(_filterThread,SIGNAL(finished()),
             this,SLOT(onPreviewThreadFinished()));
@@ -629,12 +802,15 @@ void MainWindow::onPreviewThreadFinished()
                      _filterThread->errorMessage());
     painter.end();
     ui->previewWidget->setPreviewImage(image);
+    _lastPreviewKey.clear();
   } else {
     gmic_list<gmic_pixel_type> images = _filterThread->images();
     for (unsigned int i = 0; i < images.size(); ++i) {
       gmic_qt_apply_color_profile(images[i]);
     }
-    ui->previewWidget->setPreviewImage(buildPreviewImage(images));
+    _lastPreviewImage = buildPreviewImage(images);
+    _lastPreviewKey = _pendingPreviewKey;
+    ui->previewWidget->setPreviewImage(_lastPreviewImage);
   }
 
   if ( QApplication::overrideCursor() && QApplication::overrideCursor()->shape() == Qt::WaitCursor ) {
@@ -655,19 +831,22 @@ MainWindow::processImage()
     _filterThread->abortGmic();
     _filterThread = 0;
   }
-  if ( !_selectedAbstractFilterItem || ui->filterParams->command().isEmpty() || ui->filterParams->command() == "_none_" ) {
+  const bool chainOnly = !_selectedAbstractFilterItem && !_filterChain.isEmpty();
+  if ( !chainOnly && ( !_selectedAbstractFilterItem || ui->filterParams->command().isEmpty() || ui->filterParams->command() == "_none_" ) ) {
     return;
   }
+  // The host image is about to change
+  _lastPreviewKey.clear();
   _gmicImages->assign();
   gmic_list<char> imageNames;
   gmic_qt_get_cropped_images(*_gmicImages,imageNames,-1,-1,-1,-1,ui->inOutSelector->inputMode());
-  Q_ASSERT_X(_selectedAbstractFilterItem,"MainWindow::processImage()","No filter selected");
   _filterThread = new FilterThread(this,
-                                   _lastFilterName = _selectedAbstractFilterItem->plainText(),
-                                   _lastAppliedCommand = ui->filterParams->command(),
-                                   _lastAppliedCommandArguments = ui->filterParams->valueString(),
+                                   _lastFilterName = chainOnly ? _filterChain.names() : _selectedAbstractFilterItem->plainText(),
+                                   _lastAppliedCommand = chainOnly ? QString("skip") : ui->filterParams->command(),
+                                   _lastAppliedCommandArguments = chainOnly ? QString("0") : ui->filterParams->valueString(),
                                    ui->inOutSelector->gmicEnvString(),
                                    _lastAppliedCommandOutputMessageMode = ui->inOutSelector->outputMessageMode());
+  _filterThread->setCommandPrefix(_lastAppliedCommandPrefix = _filterChain.commandLine(false));
   _filterThread->setInputImages(*_gmicImages,imageNames);
   connect(_filterThread,SIGNAL(finished()),
           this,SLOT(onApplyThreadFinished()));
@@ -704,6 +883,7 @@ MainWindow::onApplyThreadFinished()
 
   if ( _filterThread->failed() ) {
     _lastAppliedCommand.clear();
+    _lastAppliedCommandPrefix.clear();
     _lastFilterName.clear();
     _lastAppliedCommandArguments.clear();
     _lastAppliedCommandOutputMessageMode = GmicQt::Quiet;
@@ -720,6 +900,11 @@ MainWindow::onApplyThreadFinished()
                               .arg(_filterThread->fullCommand())
                               .toLocal8Bit().constData()
                             : 0);
+      // The chain is now part of the host image
+      onClearChain();
+      if ( _selectedAbstractFilterItem ) {
+        _filtersSearchIndex.recordUsage(_selectedAbstractFilterItem->hash());
+      }
     }
   }
   _filterThread->deleteLater();
@@ -762,27 +947,59 @@ void MainWindow::search(QString text)
     ui->tbSelectionMode->setChecked(false);
   }
   if ( text.length() < MINIMAL_SEARCH_LENGTH ) {
-    ui->filtersTree->setModel(_currentFiltersTreeModel = &_filtersTreeModel);
-    _filtersTreeModelSelection.clear();
+    if ( _searchActive ) {
+      _searchActive = false;
+      ui->filtersTree->setModel(&_filtersTreeModel);
+      ui->filtersTree->setRootIsDecorated(true);
+      _searchResultsModel.clear();
+      updateFiltersCountHeader(FiltersTreeAbstractItem::countLeaves(_filtersTreeModel.invisibleRootItem()));
+      restoreExpandedFolders();
+      if ( _selectedAbstractFilterItem ) {
+        ui->filtersTree->setCurrentIndex(_selectedAbstractFilterItem->index());
+        ui->filtersTree->scrollTo(_selectedAbstractFilterItem->index(),QAbstractItemView::PositionAtCenter);
+      }
+    }
     return;
   }
-  _filtersTreeModelSelection.clear();
-  QStandardItem * root = _filtersTreeModel.invisibleRootItem();
-  Q_ASSERT(root);
-  int rows = root->rowCount();
-  for (int row = 0; row < rows; ++row) {
-    FiltersTreeAbstractItem * item = dynamic_cast<FiltersTreeAbstractItem*>(root->child(row));
-    Q_ASSERT(item);
-    FiltersTreeAbstractItem * clone = item->deepClone(text.split(QChar(' '),QString::SkipEmptyParts));
-    if ( clone ) {
-      _filtersTreeModelSelection.appendRow(clone);
-    }
+  if ( ! _searchActive ) {
+    backupExpandedFoldersPaths();
+    _searchActive = true;
+  }
+  // Results are listed flat, best first
+  const QVector<FiltersTreeAbstractFilterItem*> & ranking = _filtersSearchIndex.search(text);
+  _searchResultsModel.setResults(ranking);
+  if ( ui->filtersTree->model() != &_searchResultsModel ) {
+    ui->filtersTree->setModel(&_searchResultsModel);
+    ui->filtersTree->setRootIsDecorated(false);
+  }
+  updateFiltersCountHeader(ranking.size());
+  if ( _selectedAbstractFilterItem ) {
+    ui->filtersTree->setCurrentIndex(viewIndex(_selectedAbstractFilterItem->index()));
+  }
+  ui->filtersTree->scrollToTop();
+}
+
+QModelIndex MainWindow::viewIndex(const QModelIndex & treeIndex) const
+{
+  return (ui->filtersTree->model() == &_searchResultsModel) ? _searchResultsModel.mapFromSource(treeIndex) : treeIndex;
+}
+
+QModelIndex MainWindow::treeIndex(const QModelIndex & viewIndex) const
+{
+  return (ui->filtersTree->model() == &_searchResultsModel) ? _searchResultsModel.mapToSource(viewIndex) : viewIndex;
+}
+
+void MainWindow::updateFiltersCountHeader(int count)
+{
+  _filtersTreeModel.setHorizontalHeaderItem(0,new QStandardItem(QString(tr("Available filters (%1)")).arg(count)));
+}
+
+void MainWindow::rebuildSearchIndex()
+{
+  _filtersSearchIndex.build(_filtersTreeModel.invisibleRootItem());
+  if ( _searchActive ) {
+    search(ui->searchField->text());
   }
-  _currentFiltersTreeModel = &_filtersTreeModelSelection;
-  int count = FiltersTreeAbstractItem::countLeaves(_currentFiltersTreeModel->invisibleRootItem());
-  _currentFiltersTreeModel->setHorizontalHeaderItem(0,new QStandardItem(QString(tr("Available filters (%1)")).arg(count)));
-  ui->filtersTree->setModel(_currentFiltersTreeModel);
-  ui->filtersTree->expandAll();
 }
 
 void
@@ -795,7 +1012,8 @@ MainWindow::onApplyClicked()
 void
 MainWindow::onOkClicked()
 {
-  if ( !_selectedAbstractFilterItem || ui->filterParams->command().isEmpty() || ui->filterParams->command() == "_none_" ) {
+  const bool chainOnly = !_selectedAbstractFilterItem && !_filterChain.isEmpty();
+  if ( !chainOnly && ( !_selectedAbstractFilterItem || ui->filterParams->command().isEmpty() || ui->filterParams->command() == "_none_" ) ) {
     close();
   }
   if ( _okButtonShouldApply ) {
@@ -831,7 +1049,7 @@ MainWindow::onCancelProcess()
 void
 MainWindow::onReset()
 {
-  FiltersTreeFaveItem * faveItem = _selectedAbstractFilterItem ? dynamic_cast<FiltersTreeFaveItem*>(_selectedAbstractFilterItem) : 0;
+  FiltersTreeFaveItem * faveItem = FiltersTreeAbstractItem::toFave(_selectedAbstractFilterItem);
   if ( faveItem ) {
     ui->filterParams->setValues(faveItem->defaultValues(),true);
     return;
@@ -888,6 +1106,7 @@ MainWindow::saveSettings()
   settings.setValue(QString("LastExecution/host_%1/Command").arg(GmicQt::HostApplicationShortname),_lastAppliedCommand);
   settings.setValue(QString("LastExecution/host_%1/FilterName").arg(GmicQt::HostApplicationShortname),_lastFilterName);
   settings.setValue(QString("LastExecution/host_%1/Arguments").arg(GmicQt::HostApplicationShortname),_lastAppliedCommandArguments);
+  settings.setValue(QString("LastExecution/host_%1/CommandPrefix").arg(GmicQt::HostApplicationShortname),_lastAppliedCommandPrefix);
   settings.setValue(QString("LastExecution/host_%1/OutputMessageMode").arg(GmicQt::HostApplicationShortname),_lastAppliedCommandOutputMessageMode);
   settings.setValue(QString("LastExecution/host_%1/InputMode").arg(GmicQt::HostApplicationShortname),ui->inOutSelector->inputMode());
   settings.setValue(QString("LastExecution/host_%1/OutputMode").arg(GmicQt::HostApplicationShortname),ui->inOutSelector->outputMode());
@@ -906,15 +1125,16 @@ MainWindow::saveSettings()
   }
   settings.setValue(REFRESH_USING_INTERNET_KEY,ui->cbInternetUpdate->isChecked());
 
-  backupExpandedFoldersPaths();
-  settings.setValue("Config/ExpandedFolders",_expandedFoldersPaths);
+  if ( _startupFinished ) {
+    backupExpandedFoldersPaths();
+    settings.setValue("Config/ExpandedFolders",_expandedFoldersPaths);
+  }
 }
 
 void
 MainWindow::loadSettings()
 {
   DialogSettings::loadSettings();
-  FiltersVisibilityMap::load();
   QSettings settings;
   _lastExecutionOK = settings.value("LastExecution/ExitedNormally",true).toBool();
   _newSession = GmicQt::host_app_pid() != settings.value("LastExecution/HostApplicationID",0).toUInt();
@@ -1133,7 +1353,7 @@ void MainWindow::onFiltersTreeItemChanged(QStandardItem * item)
     parentFolder = _filtersTreeModel.invisibleRootItem();
   }
   QStandardItem * leftItem = parentFolder->child(row);
-  FiltersTreeFolderItem * folder = dynamic_cast<FiltersTreeFolderItem*>(leftItem);
+  FiltersTreeFolderItem * folder = FiltersTreeAbstractItem::toFolder(leftItem);
   if ( folder ) {
     folder->applyVisibilityStatusToFolderContents();
   }
@@ -1149,7 +1369,7 @@ bool MainWindow::filtersSelectionMode()
 QString
 MainWindow::faveUniqueName(const QString & name, QStandardItem * toBeIgnored)
 {
-  FiltersTreeFolderItem * folder = faveFolder(FullModel);
+  FiltersTreeFolderItem * folder = faveFolder();
   if ( ! folder ) {
     return name;
   }
@@ -1192,7 +1412,7 @@ MainWindow::activateFilter(QModelIndex index, bool resetZoom, const QList<QStrin
 {
   _selectedAbstractFilterItem = currentTreeIndexToAbstractFilter(index);
   FiltersTreeAbstractFilterItem * & filterItem  = _selectedAbstractFilterItem;
-  FiltersTreeFaveItem * faveItem = filterItem ? dynamic_cast<FiltersTreeFaveItem*>(filterItem) : 0;
+  FiltersTreeFaveItem * faveItem = FiltersTreeAbstractItem::toFave(filterItem);
   saveCurrentParameters();
 
   if ( filterItem ) {
@@ -1202,6 +1422,7 @@ MainWindow::activateFilter(QModelIndex index, bool resetZoom, const QList<QStrin
     ui->inOutSelector->setState(ParametersCache::getInputOutputState(filterItem->hash()),false);
     ui->filterName->setVisible(true);
     ui->tbAddFave->setEnabled(true);
+    ui->tbAddToChain->setEnabled(true);
     ui->previewWidget->setPreviewFactor(filterItem->previewFactor(),resetZoom);
     showZoomWarningIfNeeded();
     _okButtonShouldApply = true;
@@ -1220,6 +1441,7 @@ void MainWindow::setNoFilter()
   ui->inOutSelector->setState(InOutPanel::State::Unspecified,false);
   ui->filterName->setVisible(false);
   ui->tbAddFave->setEnabled(false);
+  ui->tbAddToChain->setEnabled(false);
   ui->tbResetParameters->setVisible(false);
   ui->labelWarning->setPixmap(QPixmap(":/images/no_warning.png"));
   _okButtonShouldApply = false;
@@ -1231,17 +1453,17 @@ void MainWindow::setNoFilter()
 FiltersTreeAbstractFilterItem *
 MainWindow::currentTreeIndexToAbstractFilter(QModelIndex index)
 {
-  QStandardItem * item = _currentFiltersTreeModel->itemFromIndex(index);
+  QStandardItem * item = _filtersTreeModel.itemFromIndex(index);
   if ( item ) {
     int row = index.row();
     QStandardItem * parentFolder = item->parent();
     // parent is 0 for top level items
     if ( !parentFolder ) {
-      parentFolder = _currentFiltersTreeModel->invisibleRootItem();
+      parentFolder = _filtersTreeModel.invisibleRootItem();
     }
     QStandardItem * leftItem = parentFolder->child(row,0);
     if ( leftItem ) {
-      FiltersTreeAbstractFilterItem * filter = dynamic_cast<FiltersTreeAbstractFilterItem*>(leftItem);
+      FiltersTreeAbstractFilterItem * filter = FiltersTreeAbstractItem::toAbstractFilter(leftItem);
       if ( filter ) {
         return filter;
       }
@@ -1254,18 +1476,18 @@ FiltersTreeAbstractFilterItem *
 MainWindow::selectedFilterItem()
 {
   // Get filter item even if it is the checkbox which is actually selected
-  QModelIndex index = ui->filtersTree->currentIndex();
-  QStandardItem * item = _currentFiltersTreeModel->itemFromIndex(index);
+  QModelIndex index = treeIndex(ui->filtersTree->currentIndex());
+  QStandardItem * item = _filtersTreeModel.itemFromIndex(index);
   if ( item ) {
     int row = index.row();
     QStandardItem * parentFolder = item->parent();
     // parent is 0 for top level items
     if ( !parentFolder ) {
-      parentFolder = _currentFiltersTreeModel->invisibleRootItem();
+      parentFolder = _filtersTreeModel.invisibleRootItem();
     }
     QStandardItem * leftItem = parentFolder->child(row,0);
     if ( leftItem ) {
-      FiltersTreeAbstractFilterItem * filter = dynamic_cast<FiltersTreeAbstractFilterItem*>(leftItem);
+      FiltersTreeAbstractFilterItem * filter = FiltersTreeAbstractItem::toAbstractFilter(leftItem);
       if ( filter ) {
         return filter;
       }
@@ -1276,46 +1498,8 @@ MainWindow::selectedFilterItem()
 
 void MainWindow::showEvent(QShowEvent * event)
 {
-  static bool first = true;
   event->accept();
   ui->searchField->setFocus();
-  if ( first ) {
-    first = false;
-    importFaves();
-    buildFiltersTree();
-
-    // Retrieve and select previously selected filter
-    QString hash = QSettings().value("SelectedFilter",QString()).toString();
-    if (_newSession || !_lastExecutionOK) {
-      hash.clear();
-    }
-    if ( !hash.isEmpty() ) {
-      FiltersTreeAbstractFilterItem * filterItem = findFilter(hash,FullModel);
-      if ( !filterItem ) {
-        filterItem = findFave(hash,FullModel);
-      }
-      if ( filterItem ) {
-        ui->filtersTree->setCurrentIndex(filterItem->index());
-        ui->filtersTree->scrollTo(filterItem->index(),QAbstractItemView::PositionAtCenter);
-        activateFilter(filterItem->index(),true);
-        // Preview update is triggered when PreviewWidget receives
-        // the WindowActivate Event (while pendingResize is true
-        // after the very first resize event).
-        return;
-      }
-    } else {
-      // Expand fave folder
-      FiltersTreeFolderItem * faves = faveFolder(FullModel);
-      if ( faves ) {
-        QModelIndex index = faves->index();
-        ui->filtersTree->expand(index);
-      }
-      ui->previewWidget->setPreviewFactor(GmicQt::PreviewFactorFullImage,true);
-    }
-    ui->filtersTree->setSizeAdjustPolicy(QAbstractScrollArea::AdjustToContents);
-    ui->filtersTree->setSizePolicy(QSizePolicy::Preferred,QSizePolicy::Preferred);
-    ui->filtersTree->adjustSize();
-  }
 }
 
 void MainWindow::resizeEvent(QResizeEvent * e)
@@ -1330,13 +1514,12 @@ void MainWindow::resizeEvent(QResizeEvent * e)
 }
 
 FiltersTreeFolderItem  *
-MainWindow::faveFolder(ModelType modelType)
+MainWindow::faveFolder()
 {
-  QStandardItemModel & model = modelType == FullModel ? _filtersTreeModel : _filtersTreeModelSelection;
-  QStandardItem * root = model.invisibleRootItem();
+  QStandardItem * root = _filtersTreeModel.invisibleRootItem();
   int count = root->rowCount();
   for (int i = 0; i < count; ++i) {
-    FiltersTreeFolderItem * item = dynamic_cast<FiltersTreeFolderItem*>( root->child(i) );
+    FiltersTreeFolderItem * item = FiltersTreeAbstractItem::toFolder( root->child(i) );
     if ( item && item->isFaveFolder() ) {
       return item;
     }
@@ -1345,31 +1528,21 @@ MainWindow::faveFolder(ModelType modelType)
 }
 
 FiltersTreeFaveItem *
-MainWindow::findFave(const QString & hash, ModelType modelType)
+MainWindow::findFave(const QString & hash)
 {
-  FiltersTreeFolderItem * folder = faveFolder(modelType);
-  return folder ? FiltersTreeAbstractItem::findFave(folder,hash) : 0;
-}
-
-FiltersTreeFilterItem *
-MainWindow::findFilter(const QString & hash, MainWindow::ModelType modelType)
-{
-  QStandardItemModel & model = modelType == FullModel ? _filtersTreeModel : _filtersTreeModelSelection;
-  FiltersTreeFilterItem * filter = FiltersTreeAbstractItem::findFilter(model.invisibleRootItem(),hash);
-  return filter;
+  return _filtersRegistry.fave(hash);
 }
 
 FiltersTreeFilterItem *
 MainWindow::findFilter(const QString & hash)
 {
-  FiltersTreeFilterItem * filter = FiltersTreeAbstractItem::findFilter(_currentFiltersTreeModel->invisibleRootItem(),hash);
-  return filter;
+  return _filtersRegistry.filter(hash);
 }
 
 void
 MainWindow::addFaveFolder()
 {
-  if ( ! faveFolder(FullModel) ) {
+  if ( ! faveFolder() ) {
     FiltersTreeFolderItem * faveFolder = new FiltersTreeFolderItem(tr(FAVE_FOLDER_TEXT),
                                                                    FiltersTreeFolderItem::FaveFolder);
     if ( filtersSelectionMode() ) {
@@ -1385,7 +1558,7 @@ void
 MainWindow::removeFaveFolder()
 {
   QStandardItem * rootFull = _filtersTreeModel.invisibleRootItem();
-  FiltersTreeFolderItem * faveFolderFull = faveFolder(FullModel);
+  FiltersTreeFolderItem * faveFolderFull = faveFolder();
   for (int row = 0; row < rootFull->rowCount() && faveFolderFull ; ++row ) {
     QStandardItem * item = rootFull->child(row);
     if (item == faveFolderFull) {
@@ -1393,17 +1566,6 @@ MainWindow::removeFaveFolder()
       faveFolderFull = 0;
     }
   }
-
-
-  QStandardItem * rootSelection = _filtersTreeModel.invisibleRootItem();
-  FiltersTreeFolderItem * faveFolderSelection = faveFolder(SelectionModel);
-  for (int row = 0; row < rootSelection->rowCount() && faveFolderSelection; ++row ) {
-    QStandardItem * item = rootSelection->child(row);
-    if (item == faveFolderSelection) {
-      _filtersTreeModel.removeRow(row,item->index().parent());
-      faveFolderSelection = 0;
-    }
-  }
 }
 
 void
@@ -1415,16 +1577,16 @@ MainWindow::loadFaves(bool withVisibility)
     _hiddenFaves.clear();
   }
   bool imported = ! _importedFaves.isEmpty();
-  QList<StoredFave> faves = StoredFave::readFaves();
+  QList<StoredFave> faves = _startupPipeline.hasFaves() ? _startupPipeline.takeFaves() : StoredFave::readFaves();
   if ( faves.isEmpty() && _importedFaves.isEmpty() ) {
     return;
   }
   addFaveFolder();
-  FiltersTreeFolderItem * folder = faveFolder(FullModel);
+  FiltersTreeFolderItem * folder = faveFolder();
   faves.append(_importedFaves);
   for ( StoredFave & importedFave : faves ) {
     QString hash = importedFave.originalFilterHash();
-    FiltersTreeFilterItem * filterItem = findFilter(hash,FullModel);
+    FiltersTreeFilterItem * filterItem = findFilter(hash);
     if ( filterItem ) {
       FiltersTreeFaveItem * faveItem = new FiltersTreeFaveItem(filterItem,
                                                                importedFave.name(),
@@ -1432,16 +1594,18 @@ MainWindow::loadFaves(bool withVisibility)
       bool faveIsVisible = FiltersVisibilityMap::filterIsVisible(faveItem->hash());
       if ( withVisibility ) {
         GmicStdLibParser::addStandardItemWithCheckBox(folder,faveItem,faveIsVisible);
+        _filtersRegistry.add(faveItem);
       } else {
         if ( faveIsVisible ) {
           folder->appendRow(faveItem);
+          _filtersRegistry.add(faveItem);
         } else {
           _hiddenFaves.push_back(faveItem);
         }
       }
     }
   }
-  faveFolder(FullModel)->sortChildren(0);
+  faveFolder()->sortChildren(0);
   if ( imported ) {
     saveFaves();
     QSettings().setValue(FAVES_IMPORT_KEY,true);
@@ -1485,104 +1649,117 @@ MainWindow::importFaves()
 void
 MainWindow::saveFaves()
 {
-  QString jsonFilename(QString("%1%2").arg(GmicQt::path_rc(true)).arg("gmic_qt_faves.json"));
-
-  FiltersTreeFolderItem * folder = faveFolder(FullModel);
-  if ( folder || _hiddenFaves.size() ) {
-
-    // Create JSON array
-    QJsonArray array;
-    if ( folder ) {
-      int count = folder->rowCount();
-      for (int row = 0; row < count; ++row) {
-        FiltersTreeFaveItem * fave = static_cast<FiltersTreeFaveItem*>(folder->child(row));
-        array.append(StoredFave(fave).toJSONObject());
-      }
-    }
-    for ( FiltersTreeFaveItem * fave : _hiddenFaves ) {
-      array.append(StoredFave(fave).toJSONObject());
-    }
-    // Save JSON array
-    QFile jsonFile(jsonFilename);
-    if ( jsonFile.open(QIODevice::WriteOnly|QIODevice::Truncate) ) {
-      QJsonDocument jsonDoc(array);
-      if ( jsonFile.write(jsonDoc.toJson()) != -1 ) {
-        // Cleanup 2.0.0 pre-release files
-        QString obsoleteFilename(QString("%1%2").arg(GmicQt::path_rc(false)).arg("gmic_qt_faves"));
-        QFile::remove(obsoleteFilename);
-        QFile::remove(obsoleteFilename+".bak");
-      }
-    } else {
-      std::cerr << "[gmic_qt] Error: cannot open/create file " << jsonFilename.toStdString() << std::endl;
+  QList<StoredFave> faves;
+  FiltersTreeFolderItem * folder = faveFolder();
+  if ( folder ) {
+    int count = folder->rowCount();
+    for (int row = 0; row < count; ++row) {
+      faves.push_back(StoredFave(static_cast<FiltersTreeFaveItem*>(folder->child(row))));
     }
-  } else {
-    // Backup current file
-    QFile::copy(jsonFilename,jsonFilename + "bak");
-    QFile::remove(jsonFilename);
   }
+  for ( FiltersTreeFaveItem * fave : _hiddenFaves ) {
+    faves.push_back(StoredFave(fave));
+  }
+  StoredFave::writeFaves(faves);
 }
 
 void
 MainWindow::onAddFave()
 {
-  QModelIndex index = ui->filtersTree->currentIndex();
-  FiltersTreeAbstractFilterItem * item = dynamic_cast<FiltersTreeAbstractFilterItem*>( _currentFiltersTreeModel->itemFromIndex(index) );
+  QModelIndex index = treeIndex(ui->filtersTree->currentIndex());
+  FiltersTreeAbstractFilterItem * item = FiltersTreeAbstractItem::toAbstractFilter(_filtersTreeModel.itemFromIndex(index));
   if ( item ) {
     saveCurrentParameters();
 
-    if ( ! faveFolder(FullModel) ) {
+    if ( ! faveFolder() ) {
       addFaveFolder();
     }
     FiltersTreeFaveItem * fave = new FiltersTreeFaveItem(item,
                                                          faveUniqueName(item->text()),
                                                          ui->filterParams->valueStringList());
-    FiltersTreeFolderItem  * folder = faveFolder(FullModel);
+    FiltersTreeFolderItem  * folder = faveFolder();
     if ( filtersSelectionMode() ) {
       GmicStdLibParser::addStandardItemWithCheckBox(folder,fave,true);
     } else {
       folder->appendRow(fave);
     }
+    _filtersRegistry.add(fave);
     folder->sortChildren(0,Qt::AscendingOrder);
+    rebuildSearchIndex();
 
     ParametersCache::setValues(fave->hash(),ui->filterParams->valueStringList());
     ParametersCache::setInputOutputState(fave->hash(), ui->inOutSelector->state());
 
-    ui->filtersTree->setCurrentIndex(fave->index());
-    ui->filtersTree->scrollTo(fave->index(),QAbstractItemView::PositionAtCenter);
+    ui->filtersTree->setCurrentIndex(viewIndex(fave->index()));
+    ui->filtersTree->scrollTo(viewIndex(fave->index()),QAbstractItemView::PositionAtCenter);
     activateFilter(fave->index(),false,QList<QString>());
 
     saveFaves();
   }
 }
 
+void
+MainWindow::onAddToChain()
+{
+  if ( !_selectedAbstractFilterItem || ui->filterParams->command().isEmpty() || ui->filterParams->command() == "_none_" ) {
+    return;
+  }
+  saveCurrentParameters();
+  _filterChain.append(_selectedAbstractFilterItem->plainText(),
+                      ui->filterParams->command(),
+                      ui->filterParams->previewCommand(),
+                      ui->filterParams->valueString());
+  ui->tbClearChain->setEnabled(true);
+  ui->tbClearChain->setToolTip(tr("Clear filter chain (%1)").arg(_filterChain.names()));
+  showMessage(tr("Filter chain: %1").arg(_filterChain.names()),4000);
+  // The added filter is now the end of the chain: deselect it so that it is
+  // not run a second time. The chain alone can then be previewed and applied.
+  ui->filtersTree->clearSelection();
+  ui->filtersTree->setCurrentIndex(QModelIndex());
+  _selectedAbstractFilterItem = nullptr;
+  setNoFilter();
+  _okButtonShouldApply = true;
+  ui->previewWidget->sendUpdateRequest();
+}
+
+void
+MainWindow::onClearChain()
+{
+  if ( _filterChain.isEmpty() ) {
+    return;
+  }
+  _filterChain.clear();
+  ui->tbClearChain->setEnabled(false);
+  ui->tbClearChain->setToolTip(tr("Clear filter chain"));
+  ui->previewWidget->sendUpdateRequest();
+}
+
 void
 MainWindow::onRemoveFave()
 {
-  FiltersTreeFaveItem * fave = _selectedAbstractFilterItem ? dynamic_cast<FiltersTreeFaveItem *>(_selectedAbstractFilterItem) : 0;
+  FiltersTreeFaveItem * fave = FiltersTreeAbstractItem::toFave(_selectedAbstractFilterItem);
   if ( fave ) {
     QString hash = fave->hash();
     ParametersCache::remove(hash);
-    FiltersTreeFaveItem * item = findFave(hash,FullModel);
+    FiltersTreeFaveItem * item = findFave(hash);
+    _filtersRegistry.remove(item);
     _filtersTreeModel.removeRow(item->row(),item->index().parent());
-    item = findFave(hash,SelectionModel);
-    if ( item ) {
-      _filtersTreeModelSelection.removeRow(item->row(),item->index().parent());
-    }
     saveFaves();
   }
-  if ( faveFolder(FullModel)->rowCount() == 0) {
+  if ( faveFolder()->rowCount() == 0) {
     removeFaveFolder();
     ui->tbRemoveFave->setEnabled(false);
     ui->tbRenameFave->setEnabled(false);
   }
+  rebuildSearchIndex();
 }
 
 void
 MainWindow::onRenameFave()
 {
-  FiltersTreeFaveItem * fave = _selectedAbstractFilterItem ? dynamic_cast<FiltersTreeFaveItem *>(_selectedAbstractFilterItem) : 0;
+  FiltersTreeFaveItem * fave = FiltersTreeAbstractItem::toFave(_selectedAbstractFilterItem);
   if ( fave ) {
-    ui->filtersTree->edit(fave->index());
+    ui->filtersTree->edit(viewIndex(fave->index()));
     //    QString newName = QInputDialog::getText(this,
     //                                            tr("Rename a fave"),
     //                                            tr("Enter a new name"),
@@ -1594,13 +1771,13 @@ MainWindow::onRenameFave()
     //    }
     //    QString hash = item->hash();
     //    ParametersCache::remove(hash);
-    //    FiltersTreeFaveItem * item = findFave(hash,FullModel);
+    //    FiltersTreeFaveItem * item = findFave(hash);
     //    item->rename(newName);
     //    ParametersCache::setValue(item->hash(),ui->filterParams->valueStringList());
     //    if ( ( item = findFave(hash,SelectionModel) ) ) {
     //      item->rename(newName);
     //    }
-    //    FiltersTreeFolderItem * folder = faveFolder(FullModel);
+    //    FiltersTreeFolderItem * folder = faveFolder();
     //    if ( folder ) {
     //      folder->sortChildren(0);
     //    }
@@ -1616,13 +1793,13 @@ void MainWindow::onRenameFaveFinished(QWidget * editor)
   QLineEdit * le = dynamic_cast<QLineEdit*>(editor);
   Q_ASSERT_X(le,"Rename Fave","Editor is not a QLineEdit!");
   FiltersTreeAbstractFilterItem * item = selectedFilterItem();
-  FiltersTreeFaveItem * fave = item ? dynamic_cast<FiltersTreeFaveItem *>(item) : 0;
+  FiltersTreeFaveItem * fave = FiltersTreeAbstractItem::toFave(item);
   if ( !fave ) {
     return;
   }
   QString newName = le->text();
   if ( newName.isEmpty() ) {
-    FiltersTreeFilterItem * filter = findFilter(fave->originalFilterHash(),FullModel);
+    FiltersTreeFilterItem * filter = findFilter(fave->originalFilterHash());
     if ( filter ) {
       newName = faveUniqueName(filter->name());
     } else {
@@ -1637,22 +1814,16 @@ void MainWindow::onRenameFaveFinished(QWidget * editor)
   InOutPanel::State inOutState = ParametersCache::getInputOutputState(hash);
   ParametersCache::remove(hash);
   fave->rename(newName);
+  _filtersRegistry.rehash(hash,fave);
   ParametersCache::setValues(fave->hash(),values);
   ParametersCache::setInputOutputState(fave->hash(),inOutState);
 
-  FiltersTreeFaveItem * selectedFave = findFave(hash,SelectionModel);
-  if ( selectedFave ) {
-    selectedFave->rename(newName);
-  }
-  FiltersTreeFolderItem * folder = faveFolder(FullModel);
-  if ( folder ) {
-    folder->sortChildren(0);
-  }
-  folder = faveFolder(SelectionModel);
+  FiltersTreeFolderItem * folder = faveFolder();
   if ( folder ) {
     folder->sortChildren(0);
   }
   saveFaves();
+  rebuildSearchIndex();
 }
 
 void
@@ -1745,7 +1916,7 @@ void MainWindow::backupExpandedFoldersPaths()
 {
   // Do nothing if a search result is displayed
   // or if the filters tree is empty
-  if ( (_currentFiltersTreeModel == &_filtersTreeModelSelection) ||
+  if ( _searchActive ||
        ( _filtersTreeModel.invisibleRootItem()->rowCount() == 0) ) {
     return;
   }
@@ -1757,7 +1928,7 @@ void MainWindow::expandedFolderPaths(QStandardItem * item, QStringList & list)
 {
   int rows = item->rowCount();
   for (int row = 0; row < rows; ++row) {
-    FiltersTreeFolderItem * subFolder = dynamic_cast<FiltersTreeFolderItem*>(item->child(row));
+    FiltersTreeFolderItem * subFolder = FiltersTreeAbstractItem::toFolder(item->child(row));
     if ( subFolder ) {
       if (ui->filtersTree->isExpanded(subFolder->index())) {
         list.push_back(subFolder->path().join(FilterTreePathSeparator));
@@ -1769,7 +1940,7 @@ void MainWindow::expandedFolderPaths(QStandardItem * item, QStringList & list)
 
 void MainWindow::restoreExpandedFolders()
 {
-  if ( _currentFiltersTreeModel == &_filtersTreeModelSelection ) {
+  if ( _searchActive ) {
     return;
   }
   restoreExpandedFolders(_filtersTreeModel.invisibleRootItem());
@@ -1779,7 +1950,7 @@ void MainWindow::restoreExpandedFolders(QStandardItem *item)
 {
   int rows = item->rowCount();
   for (int row = 0; row < rows; ++row) {
-    FiltersTreeFolderItem * subFolder = dynamic_cast<FiltersTreeFolderItem*>(item->child(row));
+    FiltersTreeFolderItem * subFolder = FiltersTreeAbstractItem::toFolder(item->child(row));
     if ( subFolder ) {
       if ( _expandedFoldersPaths.contains(subFolder->path().join(FilterTreePathSeparator)) ) {
         ui->filtersTree->expand(subFolder->index());
@@ -1795,7 +1966,7 @@ QString MainWindow::treeIndexToPath(const QModelIndex index)
 {
   QStandardItem * item = _filtersTreeModel.itemFromIndex(index);
   if ( item ) {
-    FiltersTreeAbstractItem * filter = dynamic_cast<FiltersTreeAbstractItem*>(item);
+    FiltersTreeAbstractItem * filter = FiltersTreeAbstractItem::toAbstractItem(item);
     if ( filter ) {
       return filter->path().join(FilterTreePathSeparator);
     }
@@ -1813,7 +1984,7 @@ QModelIndex MainWindow::treePathToIndex(const QString path, QStandardItem * item
   // Search at current level first
   int rows = item->rowCount();
   for (int row = 0; row < rows; ++row) {
-    FiltersTreeAbstractFilterItem * filter = dynamic_cast<FiltersTreeAbstractFilterItem*>(item->child(row));
+    FiltersTreeAbstractFilterItem * filter = FiltersTreeAbstractItem::toAbstractFilter(item->child(row));
     if ( filter ) {
       if ( filter->path().join(FilterTreePathSeparator) == path ) {
         return filter->index();
@@ -1823,7 +1994,7 @@ QModelIndex MainWindow::treePathToIndex(const QString path, QStandardItem * item
   // Then do a depth-first search
   QModelIndex result;
   for (int row = 0; row < rows; ++row) {
-    FiltersTreeFolderItem * folder = dynamic_cast<FiltersTreeFolderItem*>(item->child(row));
+    FiltersTreeFolderItem * folder = FiltersTreeAbstractItem::toFolder(item->child(row));
     if ( folder ) {
       result = treePathToIndex(path,folder);
       if ( result.isValid() ) {
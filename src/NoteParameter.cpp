@@ -75,9 +75,9 @@ NoteParameter::reset()
 }
 
 void
-NoteParameter::initFromText(const char * text, int & textLength)
+NoteParameter::initFromDefinition(const ParameterDefinition & definition)
 {
-  QList<QString> list = parseText("note",text,textLength);
+  QList<QString> list = parseDefinition(definition);
   _text = list[1].trimmed()
       .remove(QRegExp("^\""))
       .remove(QRegExp("\"$"))
@@ -0,0 +1,121 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file ParameterDefinition.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "ParameterDefinition.h"
+
+QHash<QString,ParameterDefinition::CacheEntry> ParameterDefinition::_cache;
+
+namespace {
+
+bool isKnownType(const QString & type)
+{
+  static const char * types[] = { "int", "float", "bool", "choice", "color", "separator", "note",
+                                  "file", "filein", "fileout", "folder", "text", "link", "value",
+                                  "button", 0 };
+  for ( const char ** t = types; *t; ++t ) {
+    if ( type == QLatin1String(*t) ) {
+      return true;
+    }
+  }
+  return false;
+}
+
+QChar closingBracket(QChar c)
+{
+  if ( c == QChar('(') ) {
+    return QChar(')');
+  } else if ( c == QChar('{') ) {
+    return QChar('}');
+  } else if ( c == QChar('[') ) {
+    return QChar(']');
+  }
+  return QChar();
+}
+
+}
+
+bool ParameterDefinition::parse(const QString & text, QVector<ParameterDefinition> & definitions, QString & error)
+{
+  definitions.clear();
+  error.clear();
+  const int size = text.size();
+  int i = 0;
+  for ( ; ; ) {
+    while ( i < size && (text[i].isSpace() || text[i] == QChar(',')) ) {
+      ++i;
+    }
+    if ( i == size ) {
+      return true;
+    }
+    const int start = i;
+    ParameterDefinition definition;
+    const int equal = text.indexOf(QChar('='),i);
+    int j = equal + 1;
+    while ( j > 0 && j < size && text[j].isSpace() ) {
+      ++j;
+    }
+    if ( j > 0 && j < size && text[j] == QChar('_') ) {
+      definition.update = false;
+      ++j;
+    }
+    const int typeStart = j;
+    while ( j > 0 && j < size && text[j].isLetter() ) {
+      ++j;
+    }
+    definition.type = text.mid(typeStart,j - typeStart).toLower();
+    while ( j > 0 && j < size && text[j].isSpace() ) {
+      ++j;
+    }
+    const QChar close = (j > 0 && j < size) ? closingBracket(text[j]) : QChar();
+    const int end = close.isNull() ? -1 : text.indexOf(close,j + 1);
+    if ( equal == -1 || !isKnownType(definition.type) || end == -1 ) {
+      error = QString("ParameterDefinition::parse(): Parse error: %1").arg(text.mid(start));
+      return false;
+    }
+    definition.name = text.mid(start,equal - start).trimmed();
+    definition.values = text.mid(j + 1,end - j - 1).trimmed();
+    definitions.push_back(definition);
+    i = end + 1;
+  }
+}
+
+QVector<ParameterDefinition> ParameterDefinition::cachedParse(const QString & hash, const QString & text, QString & error)
+{
+  QHash<QString,CacheEntry>::const_iterator it = _cache.find(hash);
+  if ( it != _cache.end() && it.value().text == text ) {
+    error = it.value().error;
+    return it.value().definitions;
+  }
+  CacheEntry entry;
+  entry.text = text;
+  parse(text,entry.definitions,entry.error);
+  _cache[hash] = entry;
+  error = entry.error;
+  return entry.definitions;
+}
+
+void ParameterDefinition::clearCache()
+{
+  _cache.clear();
+}
@@ -0,0 +1,54 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file ParameterWidgetPool.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "ParameterWidgetPool.h"
+#include <QComboBox>
+#include <QPalette>
+
+QHash<const QMetaObject*,QList<QPointer<QWidget>>> ParameterWidgetPool::_widgets;
+
+void ParameterWidgetPool::recycle(QWidget * widget, QObject * owner)
+{
+  if ( ! widget ) {
+    return;
+  }
+  QList<QPointer<QWidget>> & list = _widgets[widget->metaObject()];
+  if ( list.size() >= MaxWidgetsPerType ) {
+    delete widget;
+    return;
+  }
+  widget->disconnect(owner);
+  widget->hide();
+  if ( widget->parentWidget() && widget->parentWidget()->layout() ) {
+    widget->parentWidget()->layout()->removeWidget(widget);
+  }
+  // Reset what parameters may have customized
+  widget->setPalette(QPalette());
+  widget->setToolTip(QString());
+  QComboBox * comboBox = qobject_cast<QComboBox*>(widget);
+  if ( comboBox ) {
+    comboBox->clear();
+  }
+  list.push_back(widget);
+}
@@ -29,196 +29,248 @@
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
+#include <QMutexLocker>
+#include <QSet>
 #include "Common.h"
 #include "ParametersCache.h"
+#include "KeyValueStore.h"
+#include "UserCatalog.h"
 #include "gmic.h"
 
 QHash<QString,QList<QString>> ParametersCache::_parametersCache;
 QHash<QString,InOutPanel::State> ParametersCache::_inOutPanelStates;
+bool ParametersCache::_catalogOpened = false;
+bool ParametersCache::_loadFiltersParameters = true;
+QMutex ParametersCache::_mutex(QMutex::Recursive);
+
+namespace {
+
+// Store keys
+QByteArray parametersKey(const QString & hash)
+{
+  return QByteArray("p/") + hash.toLatin1();
+}
+
+QByteArray stateKey(const QString & hash)
+{
+  return QByteArray("s/") + hash.toLatin1();
+}
+
+QByteArray encodeValues(const QList<QString> & values)
+{
+  QByteArray data;
+  QDataStream stream(&data,QIODevice::WriteOnly);
+  stream.setVersion(QDataStream::Qt_5_2);
+  stream << values;
+  return data;
+}
+
+QList<QString> decodeValues(const QByteArray & data)
+{
+  QList<QString> values;
+  QDataStream stream(data);
+  stream.setVersion(QDataStream::Qt_5_2);
+  stream >> values;
+  if ( stream.status() != QDataStream::Ok ) {
+    return QList<QString>();
+  }
+  return values;
+}
+
+QByteArray encodeState(const InOutPanel::State & state)
+{
+  return QJsonDocument(state.toJSONObject()).toJson(QJsonDocument::Compact);
+}
+
+}
 
 void ParametersCache::load(bool loadFiltersParameters)
 {
-  // Load JSON file
+  QMutexLocker locker(&_mutex);
+  // Nothing is read here, the catalog is opened on first access
   _parametersCache.clear();
   _inOutPanelStates.clear();
+  _catalogOpened = false;
+  _loadFiltersParameters = loadFiltersParameters;
+}
 
-  QString jsonFilename = QString("%1%2").arg( GmicQt::path_rc(true), PARAMETERS_CACHE_FILENAME );
-  QFile jsonFile(jsonFilename);
-  if ( !jsonFile.exists() ) {
-    return;
+void ParametersCache::preload()
+{
+  QMutexLocker locker(&_mutex);
+  openCatalog();
+}
+
+bool ParametersCache::openCatalog()
+{
+  if ( _catalogOpened ) {
+    return UserCatalog::open();
+  }
+  _catalogOpened = true;
+  if ( ! UserCatalog::open() ) {
+    std::cerr << "[gmic-qt] Parameters cannot be saved.\n";
+    return false;
+  }
+  if ( ! _loadFiltersParameters ) {
+    // New session: only the Input/Output states are kept
+    UserCatalog::write(QHash<QByteArray,QByteArray>(),UserCatalog::keys("p/"));
   }
-  if ( jsonFile.open(QFile::ReadOnly) ) {
-    QJsonDocument jsonDoc = QJsonDocument::fromBinaryData(qUncompress(jsonFile.readAll()));
-    if ( jsonDoc.isNull() ) {
-      std::cerr << "[gmic-qt] Warning: cannot parse " << jsonFilename.toStdString() << std::endl;
-      std::cerr << "[gmic-qt] Last filters parameters are lost!\n";
-    } else {
-      if ( !jsonDoc.isObject() ) {
-        std::cerr << "[gmic-qt] Error: JSON file format is not correct ("
-                  << jsonFilename.toStdString()
-                  << ")\n";
-      } else {
-        QJsonObject documentObject = jsonDoc.object();
-        QJsonObject::iterator itFilter = documentObject.begin();
-        while ( itFilter != documentObject.end() ) {
-          QString hash = itFilter.key();
-          QJsonObject filterObject = itFilter.value().toObject();
-          // Retrieve parameters
-          if ( loadFiltersParameters ) {
-            QJsonValue parameters = filterObject.value("parameters");
-            if ( ! parameters.isUndefined() ) {
-              QJsonArray array = parameters.toArray();
-              QStringList values;
-              for ( const QJsonValue & v : array ) {
-                values.push_back(v.toString());
-              }
-              _parametersCache[hash] = values;
-            }
-          }
-          QJsonValue state = filterObject.value("in_out_state");
-          // Retrieve Input/Output state
-          if ( ! state.isUndefined() ) {
-            QJsonObject stateObject = state.toObject();
-            _inOutPanelStates[hash] = InOutPanel::State::fromJSONObject(stateObject);
-          }
-          ++itFilter;
+  return true;
+}
+
+void ParametersCache::importLegacyFiles(QHash<QByteArray,QByteArray> & records)
+{
+  const QString path = GmicQt::path_rc(false);
+  const QString storeFilename = path + PARAMETERS_STORE_FILENAME;
+  const QString legacyFilename = path + PARAMETERS_CACHE_FILENAME;
+  if ( QFile::exists(storeFilename) ) {
+    KeyValueStore store;
+    if ( store.open(storeFilename) ) {
+      for ( const QByteArray & key : store.keys() ) {
+        if ( key.startsWith("p/") || key.startsWith("s/") ) {
+          records[key] = store.value(key);
         }
       }
     }
-  } else {
-    std::cerr << "[gmic-qt] Error: Cannot read " << jsonFilename.toStdString() << std::endl;
-    std::cerr << "[gmic-qt] Parameters cannot be restored.\n";
+  } else if ( QFile::exists(legacyFilename) ) {
+    importLegacyFile(legacyFilename,records);
   }
 }
 
-void
-ParametersCache::save()
-{
-  // JSON Document format
-  //
-  // {
-  //  "51d288e6f1c6e531cc61289f17e34d8a": {
-  //      "parameters": [
-  //          "6",
-  //          "21.06",
-  //          "1.36",
-  //          "5",
-  //          "0"
-  //      ],
-  //      "in_out_state": {
-  //          "InputLayers": 1,
-  //          "OutputMessages": 5,
-  //          "OutputMode": 100,
-  //          "PreviewMode": 100
-  //      }
-  //  }
-  // }
-
-  QJsonObject documentObject;
-
-  // Add Input/Ouput states
-
-  QHash<QString,InOutPanel::State>::iterator itState = _inOutPanelStates.begin();
-  while ( itState != _inOutPanelStates.end() )  {
-    QJsonObject filterObject;
-    filterObject.insert("in_out_state",itState.value().toJSONObject());
-    documentObject.insert(itState.key(),filterObject);
-    ++itState;
+void ParametersCache::importLegacyFile(const QString & jsonFilename, QHash<QByteArray,QByteArray> & records)
+{
+  QFile jsonFile(jsonFilename);
+  if ( ! jsonFile.open(QFile::ReadOnly) ) {
+    std::cerr << "[gmic-qt] Error: Cannot read " << jsonFilename.toStdString() << std::endl;
+    std::cerr << "[gmic-qt] Parameters cannot be restored.\n";
+    return;
   }
-
-  // Add filters parameters
-
-  QHash<QString,QList<QString> >::iterator itParams = _parametersCache.begin();
-  while ( itParams != _parametersCache.end() ) {
-    QJsonObject filterObject;
-    QJsonObject::iterator entry = documentObject.find(itParams.key());
-    if ( entry != documentObject.end() ) {
-      filterObject = entry.value().toObject();
-    }
-    // Add the parameters list
-    QJsonArray array;
-    QStringList list = itParams.value();
-    for ( const QString & str : list ) {
-      array.push_back(str);
-    }
-    filterObject.insert("parameters",array);
-    documentObject.insert(itParams.key(),filterObject);
-    ++itParams;
+  QJsonDocument jsonDoc = QJsonDocument::fromBinaryData(qUncompress(jsonFile.readAll()));
+  if ( jsonDoc.isNull() ) {
+    std::cerr << "[gmic-qt] Warning: cannot parse " << jsonFilename.toStdString() << std::endl;
+    std::cerr << "[gmic-qt] Last filters parameters are lost!\n";
+    return;
   }
-
-  QJsonDocument jsonDoc(documentObject);
-  QString jsonFilename = QString("%1%2").arg( GmicQt::path_rc(true), PARAMETERS_CACHE_FILENAME );
-  QFile jsonFile(jsonFilename);
-  if ( QFile::exists(jsonFilename) ) {
-    QString bakFilename = QString("%1%2").arg( GmicQt::path_rc(false), PARAMETERS_CACHE_FILENAME ".bak" );
-    QFile::remove(bakFilename);
-    QFile::copy(jsonFilename, bakFilename );
-  }
-  if ( jsonFile.open(QFile::WriteOnly|QFile::Truncate) ) {
-    qint64 count = jsonFile.write(qCompress(jsonDoc.toBinaryData()));
-    //jsonFile.write(jsonDoc.toJson());
-    //jsonFile.write(qCompress(jsonDoc.toBinaryData()));
-    jsonFile.close();
-    if ( count != -1 ) {
-      // Remove obsolete 2.0.0 pre-release files
-      QString path = GmicQt::path_rc(true);
-      QFile::remove( path + "gmic_qt_parameters.dat");
-      QFile::remove( path + "gmic_qt_parameters.json");
-      QFile::remove( path + "gmic_qt_parameters.json.bak");
-      QFile::remove( path + "gmic_qt_parameters_json.dat");
+  if ( !jsonDoc.isObject() ) {
+    std::cerr << "[gmic-qt] Error: JSON file format is not correct ("
+              << jsonFilename.toStdString()
+              << ")\n";
+    return;
+  }
+  QJsonObject documentObject = jsonDoc.object();
+  QJsonObject::iterator itFilter = documentObject.begin();
+  while ( itFilter != documentObject.end() ) {
+    QString hash = itFilter.key();
+    QJsonObject filterObject = itFilter.value().toObject();
+    QJsonValue parameters = filterObject.value("parameters");
+    if ( ! parameters.isUndefined() ) {
+      QJsonArray array = parameters.toArray();
+      QStringList values;
+      for ( const QJsonValue & v : array ) {
+        values.push_back(v.toString());
+      }
+      records[parametersKey(hash)] = encodeValues(values);
     }
-  } else {
-    std::cerr << "[gmic-qt] Error: Cannot write " << jsonFilename.toStdString() << std::endl;
-    std::cerr << "[gmic-qt] Parameters cannot be saved.\n";
+    QJsonValue state = filterObject.value("in_out_state");
+    if ( ! state.isUndefined() ) {
+      InOutPanel::State s = InOutPanel::State::fromJSONObject(state.toObject());
+      records[stateKey(hash)] = encodeState(s);
+    }
+    ++itFilter;
   }
+  // Remove obsolete 2.0.0 pre-release files
+  QString path = GmicQt::path_rc(true);
+  QFile::remove( path + "gmic_qt_parameters.dat");
+  QFile::remove( path + "gmic_qt_parameters.json");
+  QFile::remove( path + "gmic_qt_parameters.json.bak");
+  QFile::remove( path + "gmic_qt_parameters_json.dat");
 }
 
 void
 ParametersCache::setValues(const QString & hash, const QList<QString> & values)
 {
+  QMutexLocker locker(&_mutex);
+  QHash<QString,QList<QString>>::iterator it = _parametersCache.find(hash);
+  if ( it != _parametersCache.end() && it.value() == values ) {
+    return;
+  }
   _parametersCache[hash] = values;
+  if ( openCatalog() ) {
+    UserCatalog::insert(parametersKey(hash),encodeValues(values));
+  }
 }
 
 QList<QString>
 ParametersCache::getValues(const QString & hash)
 {
-  if ( _parametersCache.count(hash) ) {
-    return _parametersCache[hash];
-  } else {
-    return QList<QString>();
+  QMutexLocker locker(&_mutex);
+  QHash<QString,QList<QString>>::iterator it = _parametersCache.find(hash);
+  if ( it != _parametersCache.end() ) {
+    return it.value();
+  }
+  const QByteArray key = parametersKey(hash);
+  if ( openCatalog() && UserCatalog::contains(key) ) {
+    QList<QString> values = decodeValues(UserCatalog::value(key));
+    _parametersCache[hash] = values;
+    return values;
   }
+  return QList<QString>();
 }
 
 void
 ParametersCache::remove(const QString & hash)
 {
+  QMutexLocker locker(&_mutex);
   _parametersCache.remove(hash);
   _inOutPanelStates.remove(hash);
+  if ( openCatalog() ) {
+    UserCatalog::write(QHash<QByteArray,QByteArray>(),QList<QByteArray>() << parametersKey(hash) << stateKey(hash));
+  }
 }
 
 InOutPanel::State ParametersCache::getInputOutputState(const QString & hash)
 {
-  if ( _inOutPanelStates.contains(hash) ) {
-    return _inOutPanelStates[hash];
-  } else {
-    return InOutPanel::State::Unspecified;
+  QMutexLocker locker(&_mutex);
+  QHash<QString,InOutPanel::State>::iterator it = _inOutPanelStates.find(hash);
+  if ( it != _inOutPanelStates.end() ) {
+    return it.value();
+  }
+  const QByteArray key = stateKey(hash);
+  if ( openCatalog() && UserCatalog::contains(key) ) {
+    QJsonDocument doc = QJsonDocument::fromJson(UserCatalog::value(key));
+    InOutPanel::State state = doc.isObject() ? InOutPanel::State::fromJSONObject(doc.object()) : InOutPanel::State::Unspecified;
+    _inOutPanelStates[hash] = state;
+    return state;
   }
+  return InOutPanel::State::Unspecified;
 }
 
 void ParametersCache::setInputOutputState(const QString & hash, const InOutPanel::State & state)
 {
+  QMutexLocker locker(&_mutex);
   if ( state.isUnspecified() ) {
     _inOutPanelStates.remove(hash);
+    if ( openCatalog() ) {
+      UserCatalog::remove(stateKey(hash));
+    }
+    return;
+  }
+  QHash<QString,InOutPanel::State>::iterator it = _inOutPanelStates.find(hash);
+  if ( it != _inOutPanelStates.end() && it.value() == state ) {
     return;
   }
   _inOutPanelStates[hash] = state;
+  if ( openCatalog() ) {
+    UserCatalog::insert(stateKey(hash),encodeState(state));
+  }
 }
 
 void ParametersCache::cleanup(const QSet<QString> & hashesToKeep)
 {
+  QMutexLocker locker(&_mutex);
+
   QSet<QString> obsoleteHashes;
 
-  // Build set of no longer used parameters
+  // Build set of no longer used parameters and In/Out states
   QHash<QString,QList<QString>>::iterator itParam = _parametersCache.begin();
   while ( itParam != _parametersCache.end() ) {
     if ( ! hashesToKeep.contains(itParam.key()) ) {
@@ -226,12 +278,6 @@ void ParametersCache::cleanup(const QSet<QString> & hashesToKeep)
     }
     ++itParam;
   }
-  for ( const QString & h : obsoleteHashes ) {
-    _parametersCache.remove(h);
-  }
-  obsoleteHashes.clear();
-
-  // Build set of no longer used In/Out states
   QHash<QString,InOutPanel::State>::iterator itState = _inOutPanelStates.begin();
   while ( itState != _inOutPanelStates.end() ) {
     if ( ! hashesToKeep.contains(itState.key()) ) {
@@ -239,8 +285,15 @@ void ParametersCache::cleanup(const QSet<QString> & hashesToKeep)
     }
     ++itState;
   }
+  if ( openCatalog() ) {
+    for ( const QByteArray & key : UserCatalog::keys("p/") + UserCatalog::keys("s/") ) {
+      const QString hash = QString::fromLatin1(key.mid(2));
+      if ( ! hashesToKeep.contains(hash) ) {
+        obsoleteHashes.insert(hash);
+      }
+    }
+  }
   for ( const QString & h : obsoleteHashes ) {
-    _inOutPanelStates.remove(h);
+    remove(h);
   }
-  obsoleteHashes.clear();
 }
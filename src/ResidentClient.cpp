@@ -0,0 +1,190 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file ResidentClient.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "ResidentClient.h"
+#include <QLocalSocket>
+#include <QSharedMemory>
+#include <QDataStream>
+#include <QDebug>
+#include "Common.h"
+#include "ResidentServer.h"
+#include "gmic.h"
+
+ResidentClient::ResidentClient(QObject * parent)
+  : QObject(parent),
+    _socket(new QLocalSocket(this)),
+    _images(0),
+    _imageNames(0),
+    _aborted(false)
+{
+  _timer.setSingleShot(true);
+  _timer.setInterval(ResidentProtocol::JobTimeout);
+  connect(&_timer,SIGNAL(timeout()),
+          this,SLOT(onTimeout()));
+}
+
+ResidentClient::~ResidentClient()
+{
+  stop();
+}
+
+bool ResidentClient::start(const QString & command,
+                           const QString & commandPrefix,
+                           const QString & arguments,
+                           const QString & environment,
+                           GmicQt::OutputMessageMode messageMode,
+                           cimg_library::CImgList<float> & images,
+                           cimg_library::CImgList<char> & imageNames)
+{
+  _socket->connectToServer(ResidentProtocol::serverName());
+  if ( ! _socket->waitForConnected(250) ) {
+    _socket->abort();
+    return false;
+  }
+
+  QByteArray inputLayout;
+  QSharedMemory * input = 0;
+  if ( ! ResidentProtocol::storeImages(images,imageNames,inputLayout,input) ) {
+    _socket->abort();
+    return false;
+  }
+  _input.reset(input);
+  QByteArray request;
+  QDataStream out(&request,QIODevice::WriteOnly);
+  out.setVersion(QDataStream::Qt_5_2);
+  out << ResidentProtocol::Magic << ResidentProtocol::Version
+      << QString(GmicQt::HostApplicationShortname)
+      << command << commandPrefix << arguments << environment
+      << static_cast<qint32>(messageMode)
+      << (_input.isNull() ? QString() : _input->key())
+      << inputLayout;
+  if ( ! ResidentProtocol::writeMessage(*_socket,request) ) {
+    stop();
+    return false;
+  }
+
+  _images = &images;
+  _imageNames = &imageNames;
+  _gmicStatus.clear();
+  _errorMessage.clear();
+  _aborted = false;
+  _buffer.clear();
+  connect(_socket,SIGNAL(readyRead()),
+          this,SLOT(onReadyRead()));
+  connect(_socket,SIGNAL(disconnected()),
+          this,SLOT(onDisconnected()));
+  _startTime.start();
+  _timer.start();
+  return true;
+}
+
+QString ResidentClient::gmicStatus() const
+{
+  return _gmicStatus;
+}
+
+QString ResidentClient::errorMessage() const
+{
+  return _errorMessage;
+}
+
+bool ResidentClient::aborted() const
+{
+  return _aborted;
+}
+
+int ResidentClient::duration() const
+{
+  return _startTime.elapsed();
+}
+
+void ResidentClient::cancel()
+{
+  if ( _socket->state() == QLocalSocket::UnconnectedState ) {
+    return;
+  }
+  // The server aborts the job when it finds the socket closed
+  _aborted = true;
+  stop();
+  emit finished();
+}
+
+void ResidentClient::onReadyRead()
+{
+  _buffer.append(_socket->readAll());
+  QByteArray response;
+  if ( ! ResidentProtocol::takeMessage(_buffer,response) ) {
+    return;
+  }
+  QDataStream in(response);
+  in.setVersion(QDataStream::Qt_5_2);
+  quint32 magic = 0;
+  quint32 version = 0;
+  QString outputKey;
+  QByteArray outputLayout;
+  in >> magic >> version >> _errorMessage >> _gmicStatus >> outputKey >> outputLayout;
+  if ( in.status() != QDataStream::Ok || magic != ResidentProtocol::Magic || version != ResidentProtocol::Version ) {
+    qWarning() << "[gmic-qt] Resident: unexpected response, processing locally";
+    stop();
+    emit failed();
+    return;
+  }
+  if ( _errorMessage.isEmpty() ) {
+    // The server keeps the output segment alive until we disconnect.
+    // Input images are only replaced once the output was read, for a local fallback.
+    cimg_library::CImgList<float> images;
+    cimg_library::CImgList<char> imageNames;
+    if ( ! ResidentProtocol::loadImages(outputKey,outputLayout,images,imageNames) ) {
+      stop();
+      emit failed();
+      return;
+    }
+    images.move_to(*_images);
+    imageNames.move_to(*_imageNames);
+  }
+  stop();
+  emit finished();
+}
+
+void ResidentClient::onDisconnected()
+{
+  qWarning() << "[gmic-qt] Resident: connection lost, processing locally";
+  stop();
+  emit failed();
+}
+
+void ResidentClient::onTimeout()
+{
+  _errorMessage = QString("Resident server: no answer after %1 s").arg(ResidentProtocol::JobTimeout / 1000);
+  stop();
+  emit finished();
+}
+
+void ResidentClient::stop()
+{
+  _timer.stop();
+  _socket->disconnect(this);
+  _socket->abort();
+  _input.reset();
+}
@@ -0,0 +1,386 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file ResidentServer.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "ResidentServer.h"
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QSharedMemory>
+#include <QDataStream>
+#include <QUuid>
+#include <QtEndian>
+#include <QDebug>
+#include <cstring>
+#include <iostream>
+#include "Common.h"
+#include "Updater.h"
+#include "StdlibCache.h"
+#include "GmicStdlibParser.h"
+#include "FilterThread.h"
+#include "gmic.h"
+
+QString ResidentProtocol::serverName()
+{
+  QString user = QString::fromLocal8Bit(qgetenv("USER"));
+  if ( user.isEmpty() ) {
+    user = QString::fromLocal8Bit(qgetenv("USERNAME"));
+  }
+  return QString("%1_resident_%2").arg(GMIC_QT_APPLICATION_NAME).arg(user);
+}
+
+bool ResidentProtocol::writeMessage(QLocalSocket & socket, const QByteArray & message)
+{
+  QDataStream ds(&socket);
+  ds.writeBytes(message.constData(),static_cast<uint>(message.size()));
+  return ds.status() == QDataStream::Ok;
+}
+
+bool ResidentProtocol::takeMessage(QByteArray & buffer, QByteArray & message)
+{
+  if ( buffer.size() < static_cast<int>(sizeof(quint32)) ) {
+    return false;
+  }
+  const quint32 size = qFromBigEndian<quint32>(reinterpret_cast<const uchar*>(buffer.constData()));
+  if ( static_cast<quint32>(buffer.size()) < size + sizeof(quint32) ) {
+    return false;
+  }
+  message = buffer.mid(sizeof(quint32),size);
+  buffer.remove(0,size + sizeof(quint32));
+  return true;
+}
+
+bool ResidentProtocol::storeImages(const cimg_library::CImgList<float> & images,
+                                   const cimg_library::CImgList<char> & imageNames,
+                                   QByteArray & layout,
+                                   QSharedMemory * & memory)
+{
+  memory = nullptr;
+  layout.clear();
+  QDataStream ds(&layout,QIODevice::WriteOnly);
+  ds.setVersion(QDataStream::Qt_5_2);
+  ds << static_cast<quint32>(images.size());
+  qint64 bytes = 0;
+  for ( unsigned int i = 0; i < images.size(); ++i ) {
+    const gmic_image<float> & image = images[i];
+    QByteArray name;
+    if ( i < imageNames.size() && imageNames[i] ) {
+      name = QByteArray((const char*)imageNames[i]);
+    }
+    ds << static_cast<qint32>(image._width) << static_cast<qint32>(image._height)
+       << static_cast<qint32>(image._depth) << static_cast<qint32>(image._spectrum)
+       << name;
+    bytes += static_cast<qint64>(image.size()) * sizeof(float);
+  }
+  if ( !bytes ) {
+    return true;
+  }
+  memory = new QSharedMemory(QString("gmic_qt_resident_%1").arg(QUuid::createUuid().toString()));
+  if ( ! memory->create(bytes) ) {
+    qWarning() << "[gmic-qt] Resident: cannot create shared memory" << memory->errorString();
+    delete memory;
+    memory = nullptr;
+    return false;
+  }
+  memory->lock();
+  char * data = static_cast<char*>(memory->data());
+  for ( unsigned int i = 0; i < images.size(); ++i ) {
+    const size_t size = images[i].size() * sizeof(float);
+    if ( size ) {
+      std::memcpy(data,images[i].data(),size);
+      data += size;
+    }
+  }
+  memory->unlock();
+  return true;
+}
+
+bool ResidentProtocol::loadImages(const QString & key,
+                                  const QByteArray & layout,
+                                  cimg_library::CImgList<float> & images,
+                                  cimg_library::CImgList<char> & imageNames)
+{
+  QDataStream ds(layout);
+  ds.setVersion(QDataStream::Qt_5_2);
+  quint32 count = 0;
+  ds >> count;
+  images.assign(count);
+  imageNames.assign(count);
+  QSharedMemory memory(key);
+  const char * data = nullptr;
+  qint64 available = 0;
+  if ( ! key.isEmpty() ) {
+    if ( ! memory.attach(QSharedMemory::ReadOnly) ) {
+      qWarning() << "[gmic-qt] Resident: cannot attach shared memory" << memory.errorString();
+      return false;
+    }
+    memory.lock();
+    data = static_cast<const char*>(memory.constData());
+    available = memory.size();
+  }
+  bool ok = true;
+  for ( quint32 i = 0; i < count && ok; ++i ) {
+    qint32 width, height, depth, spectrum;
+    QByteArray name;
+    ds >> width >> height >> depth >> spectrum >> name;
+    images[i].assign(width,height,depth,spectrum);
+    const qint64 size = static_cast<qint64>(images[i].size()) * sizeof(float);
+    if ( ds.status() != QDataStream::Ok || size > available ) {
+      ok = false;
+    } else if ( size ) {
+      std::memcpy(images[i].data(),data,size);
+      data += size;
+      available -= size;
+    }
+    gmic_image<char>::string(name.constData()).move_to(imageNames[i]);
+  }
+  if ( memory.isAttached() ) {
+    memory.unlock();
+    memory.detach();
+  }
+  if ( !ok ) {
+    images.assign();
+    imageNames.assign();
+  }
+  return ok;
+}
+
+ResidentServer::ResidentServer(QObject * parent)
+  : QObject(parent),
+    _server(0),
+    _interpreter(0),
+    _job(0),
+    _jobSocket(0)
+{
+}
+
+ResidentServer::~ResidentServer()
+{
+  if ( _job ) {
+    _job->abortGmic();
+    _job->wait();
+  }
+  qDeleteAll(_outputs);
+  _outputs.clear();
+  delete _interpreter;
+}
+
+bool ResidentServer::start()
+{
+  const QString name = ResidentProtocol::serverName();
+  {
+    QLocalSocket probe;
+    probe.connectToServer(name);
+    if ( probe.waitForConnected(500) ) {
+      qWarning() << "[gmic-qt] Resident: a server is already running as" << name;
+      return false;
+    }
+  }
+  QLocalServer::removeServer(name);
+
+  // What each plugin invocation would otherwise pay for is done once here
+  loadStdlib();
+  if ( ! _interpreter ) {
+    return false;
+  }
+
+  _server = new QLocalServer(this);
+  _server->setSocketOptions(QLocalServer::UserAccessOption);
+  if ( ! _server->listen(name) ) {
+    qWarning() << "[gmic-qt] Resident: cannot listen on" << name << _server->errorString();
+    return false;
+  }
+  connect(_server,SIGNAL(newConnection()),
+          this,SLOT(onNewConnection()));
+  std::cout << "[gmic-qt] Resident server listening on " << name.toLocal8Bit().constData() << std::endl;
+  return true;
+}
+
+void ResidentServer::onNewConnection()
+{
+  while ( _server->hasPendingConnections() ) {
+    QLocalSocket * socket = _server->nextPendingConnection();
+    _buffers[socket] = QByteArray();
+    connect(socket,SIGNAL(readyRead()),
+            this,SLOT(onReadyRead()));
+    connect(socket,SIGNAL(disconnected()),
+            this,SLOT(onDisconnected()));
+  }
+}
+
+void ResidentServer::onReadyRead()
+{
+  QLocalSocket * socket = qobject_cast<QLocalSocket*>(sender());
+  if ( !socket ) {
+    return;
+  }
+  QByteArray & buffer = _buffers[socket];
+  buffer.append(socket->readAll());
+  QByteArray request;
+  while ( ResidentProtocol::takeMessage(buffer,request) ) {
+    _queue.push_back(qMakePair(socket,request));
+  }
+  startNextJob();
+}
+
+void ResidentServer::onDisconnected()
+{
+  QLocalSocket * socket = qobject_cast<QLocalSocket*>(sender());
+  if ( !socket ) {
+    return;
+  }
+  delete _outputs.take(socket);
+  _buffers.remove(socket);
+  for ( int i = _queue.size() - 1; i >= 0; --i ) {
+    if ( _queue[i].first == socket ) {
+      _queue.removeAt(i);
+    }
+  }
+  if ( socket == _jobSocket ) {
+    // Nobody will read the result
+    _jobSocket = 0;
+    _job->abortGmic();
+  }
+  socket->deleteLater();
+}
+
+void ResidentServer::onJobFinished()
+{
+  FilterThread * job = _job;
+  QLocalSocket * socket = _jobSocket;
+  _job = 0;
+  _jobSocket = 0;
+  if ( socket ) {
+    sendResponse(socket,
+                 job->failed() ? job->errorMessage() : QString(),
+                 job->gmicStatus(),
+                 job->images(),
+                 job->imageNames());
+  }
+  job->deleteLater();
+  startNextJob();
+}
+
+void ResidentServer::startNextJob()
+{
+  while ( !_job && !_queue.isEmpty() ) {
+    const QPair<QLocalSocket*,QByteArray> next = _queue.takeFirst();
+    QLocalSocket * socket = next.first;
+    // The previous output was read once the client sends another job
+    delete _outputs.take(socket);
+
+    QDataStream in(next.second);
+    in.setVersion(QDataStream::Qt_5_2);
+    quint32 magic = 0;
+    quint32 version = 0;
+    QString host;
+    QString command;
+    QString commandPrefix;
+    QString arguments;
+    QString environment;
+    qint32 mode = GmicQt::Quiet;
+    QString inputKey;
+    QByteArray inputLayout;
+    in >> magic >> version >> host >> command >> commandPrefix >> arguments >> environment >> mode >> inputKey >> inputLayout;
+
+    gmic_list<float> images;
+    gmic_list<char> imageNames;
+    if ( in.status() != QDataStream::Ok || magic != ResidentProtocol::Magic || version != ResidentProtocol::Version ) {
+      sendResponse(socket,"Resident server: invalid request",QString(),images,imageNames);
+      continue;
+    }
+    if ( !ResidentProtocol::loadImages(inputKey,inputLayout,images,imageNames) ) {
+      sendResponse(socket,"Resident server: cannot read input images",QString(),images,imageNames);
+      continue;
+    }
+    loadStdlib();
+    if ( ! _interpreter ) {
+      sendResponse(socket,"Resident server: no G'MIC interpreter",QString(),images,imageNames);
+      continue;
+    }
+    // Parsed commands are kept, variables and verbosity set by previous jobs are not
+    _interpreterState.restore(*_interpreter);
+    _interpreter->set_variable("_host",host.toLocal8Bit().constData(),'=');
+
+    _job = new FilterThread(this,
+                            QString(),
+                            command,
+                            arguments,
+                            environment,
+                            static_cast<GmicQt::OutputMessageMode>(mode));
+    _job->setCommandPrefix(commandPrefix);
+    _job->setInterpreter(_interpreter);
+    _job->setInputImages(images,imageNames);
+    _jobSocket = socket;
+    connect(_job,SIGNAL(finished()),
+            this,SLOT(onJobFinished()));
+    _job->start();
+  }
+}
+
+void ResidentServer::sendResponse(QLocalSocket * socket,
+                                  const QString & error,
+                                  const QString & status,
+                                  const cimg_library::CImgList<float> & images,
+                                  const cimg_library::CImgList<char> & imageNames)
+{
+  QString errorMessage = error;
+  QByteArray outputLayout;
+  QSharedMemory * output = 0;
+  if ( errorMessage.isEmpty() && !ResidentProtocol::storeImages(images,imageNames,outputLayout,output) ) {
+    errorMessage = "Resident server: cannot store output images";
+  }
+  if ( output ) {
+    // Kept alive until the client has read it (i.e. disconnected or sent another job)
+    _outputs[socket] = output;
+  }
+
+  QByteArray response;
+  QDataStream out(&response,QIODevice::WriteOnly);
+  out.setVersion(QDataStream::Qt_5_2);
+  out << ResidentProtocol::Magic << ResidentProtocol::Version
+      << errorMessage << status
+      << (output ? output->key() : QString())
+      << outputLayout;
+  ResidentProtocol::writeMessage(*socket,response);
+}
+
+void ResidentServer::loadStdlib()
+{
+  const QString stamp = StdlibCache::manifestStamp();
+  if ( _interpreter && stamp == _stdlibStamp ) {
+    return;
+  }
+  Updater::getInstance()->updateSources(false);
+  GmicStdLibParser::GmicStdlib = Updater::getInstance()->buildFullStdlib();
+  // Building the stdlib may have rewritten the manifest
+  _stdlibStamp = StdlibCache::manifestStamp();
+  delete _interpreter;
+  _interpreter = 0;
+  try {
+    _interpreter = new gmic(0,GmicStdLibParser::GmicStdlib.constData(),true);
+  } catch (gmic_exception & e) {
+    qWarning() << "[gmic-qt] Resident: cannot create G'MIC interpreter:" << e.what();
+    return;
+  }
+  _interpreterState.save(*_interpreter);
+}
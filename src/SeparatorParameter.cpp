@@ -71,8 +71,8 @@ SeparatorParameter::reset()
 {
 }
 
-void SeparatorParameter::initFromText(const char * text, int & textLength)
+void SeparatorParameter::initFromDefinition(const ParameterDefinition & definition)
 {
-  QStringList list = parseText("separator",text,textLength);
+  QStringList list = parseDefinition(definition);
   unused(list);
 }
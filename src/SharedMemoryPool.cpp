@@ -0,0 +1,87 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file SharedMemoryPool.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "SharedMemoryPool.h"
+#include <QDebug>
+#include <QSharedMemory>
+#include <QString>
+#include <QUuid>
+
+namespace {
+const qint64 MinimumSegmentSize = 1024 * 1024;
+const int MaxFreeSegments = 8;
+}
+
+SharedMemoryPool::~SharedMemoryPool()
+{
+  clear();
+}
+
+qint64 SharedMemoryPool::sizeClass(qint64 size)
+{
+  qint64 result = MinimumSegmentSize;
+  while ( result < size ) {
+    result *= 2;
+  }
+  return result;
+}
+
+QSharedMemory * SharedMemoryPool::acquire(qint64 size)
+{
+  const qint64 segmentSize = sizeClass(size);
+  for ( int i = 0; i < _free.size(); ++i ) {
+    // Some systems round the size of the segments up
+    if ( _free[i]->size() >= segmentSize && _free[i]->size() < 2 * segmentSize ) {
+      QSharedMemory * m = _free.takeAt(i);
+      _used.append(m);
+      return m;
+    }
+  }
+  QSharedMemory * m = new QSharedMemory(QString("key_%1").arg(QUuid::createUuid().toString()));
+  if ( ! m->create(segmentSize) ) {
+    qWarning() << "[gmic-qt] Could not create shared memory" << m->error() << m->errorString();
+    delete m;
+    return 0;
+  }
+  _used.append(m);
+  return m;
+}
+
+void SharedMemoryPool::recycle()
+{
+  // The host is done with the segments of the previous output
+  _free.append(_used);
+  _used.clear();
+  while ( _free.size() > MaxFreeSegments ) {
+    delete _free.takeFirst();
+  }
+}
+
+void SharedMemoryPool::clear()
+{
+  qDeleteAll(_free);
+  qDeleteAll(_used);
+  _free.clear();
+  _used.clear();
+}
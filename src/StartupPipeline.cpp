@@ -0,0 +1,233 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file StartupPipeline.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "StartupPipeline.h"
+#include <QCoreApplication>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThread>
+#include "Common.h"
+#include "FiltersVisibilityMap.h"
+#include "ParametersCache.h"
+#include "Updater.h"
+
+class StartupPipeline::Job : public QRunnable
+{
+public:
+  Job(StartupPipeline * pipeline, Task task)
+    : _pipeline(pipeline), _task(task) { }
+  void run()
+  {
+    _pipeline->execute(_task);
+    QMetaObject::invokeMethod(_pipeline,"onTaskFinished",Qt::QueuedConnection,Q_ARG(int,_task));
+  }
+private:
+  StartupPipeline * _pipeline;
+  Task _task;
+};
+
+StartupPipeline::StartupPipeline(QObject * parent)
+  : QObject(parent),
+    _running(false),
+    _downloadsOk(true),
+    _ageLimit(0),
+    _timeout(0),
+    _useNetwork(false),
+    _hasFaves(false)
+{
+}
+
+StartupPipeline::~StartupPipeline()
+{
+  _pool.waitForDone();
+}
+
+void StartupPipeline::start(int ageLimit, int timeout, bool useNetwork)
+{
+  _ageLimit = ageLimit;
+  _timeout = timeout;
+  _useNetwork = useNetwork;
+  _downloadsOk = true;
+  _running = true;
+  _clock.start();
+  {
+    QMutexLocker locker(&_timelineMutex);
+    _timeline.clear();
+  }
+  mark("Startup");
+  // The updater must live in the GUI thread (network access manager)
+  Updater::getInstance();
+  hold("Downloads");
+  run(SourcesTask);
+  run(FavesTask);
+  run(VisibilityTask);
+  run(ParametersTask);
+}
+
+bool StartupPipeline::isRunning() const
+{
+  return _running;
+}
+
+void StartupPipeline::waitForDone()
+{
+  _pool.waitForDone();
+}
+
+void StartupPipeline::hold(const QString & step)
+{
+  _pending.insert(step);
+}
+
+void StartupPipeline::release(const QString & step)
+{
+  if ( _pending.remove(step) ) {
+    mark(step + " (done)");
+    checkFinished();
+  }
+}
+
+void StartupPipeline::mark(const QString & step)
+{
+  TimelineEntry entry;
+  entry.ms = _clock.isValid() ? _clock.elapsed() : 0;
+  entry.step = step;
+  entry.mainThread = (QThread::currentThread() == QCoreApplication::instance()->thread());
+  QMutexLocker locker(&_timelineMutex);
+  _timeline.push_back(entry);
+}
+
+QString StartupPipeline::timeline() const
+{
+  QMutexLocker locker(&_timelineMutex);
+  QString text;
+  for ( const TimelineEntry & entry : _timeline ) {
+    text += QString("%1 ms\t[%2]\t%3\n")
+        .arg(entry.ms,6)
+        .arg(entry.mainThread ? "gui" : "worker")
+        .arg(entry.step);
+  }
+  return text;
+}
+
+bool StartupPipeline::hasFaves() const
+{
+  return _hasFaves;
+}
+
+QByteArray StartupPipeline::takeStdlib()
+{
+  QByteArray stdlib = _stdlib;
+  _stdlib.clear();
+  return stdlib;
+}
+
+QList<StoredFave> StartupPipeline::takeFaves()
+{
+  _hasFaves = false;
+  QList<StoredFave> faves = _faves;
+  _faves.clear();
+  return faves;
+}
+
+QString StartupPipeline::taskName(int task)
+{
+  switch ( task ) {
+  case SourcesTask:
+    return "Sources listing";
+  case FavesTask:
+    return "Faves reading";
+  case VisibilityTask:
+    return "Filters visibility reading";
+  case ParametersTask:
+    return "Parameters store opening";
+  case StdlibTask:
+    return "Stdlib assembling";
+  }
+  return QString();
+}
+
+void StartupPipeline::run(Task task)
+{
+  _pending.insert(taskName(task));
+  _pool.start(new Job(this,task));
+}
+
+void StartupPipeline::execute(Task task)
+{
+  // Worker thread: nothing here may touch widgets, the host or the Updater.
+  // Results go to members of the pipeline, read by the GUI thread once
+  // onTaskFinished() is called.
+  mark(taskName(task) + " (started)");
+  switch ( task ) {
+  case SourcesTask:
+    Updater::listSources(_useNetwork,true,_sources,_sourceIsStdlib);
+    break;
+  case FavesTask:
+    _faves = StoredFave::readFaves();
+    break;
+  case VisibilityTask:
+    FiltersVisibilityMap::load();
+    break;
+  case ParametersTask:
+    ParametersCache::preload();
+    break;
+  case StdlibTask:
+    _stdlib = Updater::buildFullStdlib(_sources,_sourceIsStdlib);
+    break;
+  }
+}
+
+void StartupPipeline::onTaskFinished(int task)
+{
+  if ( task == FavesTask ) {
+    _hasFaves = true;
+  }
+  if ( task == SourcesTask ) {
+    Updater * updater = Updater::getInstance();
+    updater->setSources(_sources,_sourceIsStdlib);
+    connect(updater,SIGNAL(downloadsFinished(bool)),
+            this,SLOT(onDownloadsFinished(bool)));
+    updater->startDownloads(_ageLimit,_timeout,_useNetwork);
+  }
+  release(taskName(task));
+}
+
+void StartupPipeline::onDownloadsFinished(bool ok)
+{
+  QObject::disconnect(Updater::getInstance(),SIGNAL(downloadsFinished(bool)),
+                      this,SLOT(onDownloadsFinished(bool)));
+  _downloadsOk = ok;
+  run(StdlibTask);
+  release("Downloads");
+}
+
+void StartupPipeline::checkFinished()
+{
+  if ( _running && _pending.isEmpty() ) {
+    _running = false;
+    mark("Ready");
+    emit finished(_downloadsOk);
+  }
+}
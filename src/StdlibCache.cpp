@@ -0,0 +1,201 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file StdlibCache.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "StdlibCache.h"
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QDebug>
+#include "Common.h"
+#include "gmic_qt.h"
+#include "gmic.h"
+
+QMutex StdlibCache::_mutex;
+
+namespace {
+
+QString manifestFilename()
+{
+  return QString("%1%2").arg(GmicQt::path_rc(true)).arg(STDLIB_CACHE_MANIFEST_FILENAME);
+}
+
+QString stdlibFilename()
+{
+  return QString("%1%2").arg(GmicQt::path_rc(true)).arg(STDLIB_CACHE_FILENAME);
+}
+
+QString userFilename()
+{
+  return QString::fromLocal8Bit(gmic::path_user());
+}
+
+QString updateFilename()
+{
+  return QString("%1update%2.gmic").arg(GmicQt::path_rc(true)).arg(gmic_version);
+}
+
+}
+
+QString StdlibCache::stamp(const QString & filename)
+{
+  QFileInfo info(filename);
+  if ( filename.isEmpty() || !info.exists() ) {
+    return QString("missing");
+  }
+  return QString("%1:%2").arg(info.lastModified().toMSecsSinceEpoch()).arg(info.size());
+}
+
+QString StdlibCache::manifestStamp()
+{
+  return QString("%1|%2").arg(stamp(manifestFilename())).arg(stamp(userFilename()));
+}
+
+QJsonObject StdlibCache::readManifest()
+{
+  QFile file(manifestFilename());
+  if ( ! file.open(QFile::ReadOnly) ) {
+    return QJsonObject();
+  }
+  QJsonObject manifest = QJsonDocument::fromJson(file.readAll()).object();
+  if ( manifest.value("gmic_version").toInt() != gmic_version ) {
+    return QJsonObject();
+  }
+  return manifest;
+}
+
+void StdlibCache::writeManifest(const QJsonObject & manifest)
+{
+  QSaveFile file(manifestFilename());
+  if ( ! file.open(QFile::WriteOnly) ) {
+    qWarning() << "[gmic-qt] Cannot write" << file.fileName();
+    return;
+  }
+  QJsonObject object = manifest;
+  object.insert("gmic_version",gmic_version);
+  file.write(QJsonDocument(object).toJson());
+  file.commit();
+}
+
+bool StdlibCache::readSources(bool useNetwork, QList<QString> & sources, QMap<QString,bool> & isStdlib)
+{
+  QMutexLocker locker(&_mutex);
+  QJsonObject object = readManifest().value("sources").toObject();
+  if ( object.isEmpty()
+       || object.value("network").toBool() != useNetwork
+       || object.value("user_file").toString() != stamp(userFilename())
+       || object.value("update_file").toString() != stamp(updateFilename()) ) {
+    return false;
+  }
+  sources.clear();
+  isStdlib.clear();
+  for ( const QJsonValue & value : object.value("list").toArray() ) {
+    QJsonObject source = value.toObject();
+    QString name = source.value("source").toString();
+    sources.push_back(name);
+    isStdlib[name] = source.value("stdlib").toBool();
+  }
+  return !sources.isEmpty();
+}
+
+void StdlibCache::writeSources(bool useNetwork, const QList<QString> & sources, const QMap<QString,bool> & isStdlib)
+{
+  QMutexLocker locker(&_mutex);
+  QJsonArray list;
+  for ( const QString & name : sources ) {
+    QJsonObject source;
+    source.insert("source",name);
+    source.insert("stdlib",isStdlib.value(name,false));
+    list.push_back(source);
+  }
+  QJsonObject object;
+  object.insert("network",useNetwork);
+  object.insert("user_file",stamp(userFilename()));
+  object.insert("update_file",stamp(updateFilename()));
+  object.insert("list",list);
+  QJsonObject manifest = readManifest();
+  manifest.insert("sources",object);
+  writeManifest(manifest);
+}
+
+QByteArray StdlibCache::readStdlib(const QList<QString> & files)
+{
+  QMutexLocker locker(&_mutex);
+  QJsonObject object = readManifest().value("stdlib").toObject();
+  if ( object.isEmpty() ) {
+    return QByteArray();
+  }
+  QJsonArray stamps = object.value("files").toArray();
+  if ( stamps.size() != files.size() ) {
+    return QByteArray();
+  }
+  for ( int i = 0; i < files.size(); ++i ) {
+    QJsonObject entry = stamps.at(i).toObject();
+    if ( entry.value("file").toString() != files[i] || entry.value("stamp").toString() != stamp(files[i]) ) {
+      return QByteArray();
+    }
+  }
+  QFile file(stdlibFilename());
+  if ( stamp(file.fileName()) != object.value("stamp").toString() || ! file.open(QFile::ReadOnly) ) {
+    return QByteArray();
+  }
+  QByteArray stdlib = file.readAll();
+  if ( stdlib.isEmpty() || ! stdlib.endsWith('\0') ) {
+    return QByteArray();
+  }
+  stdlib.chop(1);
+  return stdlib;
+}
+
+void StdlibCache::writeStdlib(const QList<QString> & files, const QByteArray & stdlib)
+{
+  QMutexLocker locker(&_mutex);
+  QSaveFile file(stdlibFilename());
+  if ( ! file.open(QFile::WriteOnly) ) {
+    qWarning() << "[gmic-qt] Cannot write" << file.fileName();
+    return;
+  }
+  file.write(stdlib.constData(),stdlib.size());
+  file.write("",1);
+  if ( ! file.commit() ) {
+    qWarning() << "[gmic-qt] Cannot write" << file.fileName();
+    return;
+  }
+  QJsonArray stamps;
+  for ( const QString & filename : files ) {
+    QJsonObject entry;
+    entry.insert("file",filename);
+    entry.insert("stamp",stamp(filename));
+    stamps.push_back(entry);
+  }
+  QJsonObject object;
+  object.insert("files",stamps);
+  object.insert("stamp",stamp(stdlibFilename()));
+  QJsonObject manifest = readManifest();
+  manifest.insert("stdlib",object);
+  writeManifest(manifest);
+}
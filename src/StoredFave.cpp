@@ -34,6 +34,7 @@
 #include <QDebug>
 #include "FiltersTreeFaveItem.h"
 #include "Common.h"
+#include "UserCatalog.h"
 #include "gmic_qt.h"
 #include "gmic.h"
 
@@ -125,7 +126,64 @@ QList<StoredFave> StoredFave::importFaves()
   return faves;
 }
 
+namespace {
+const QByteArray FavesKey("faves");
+
+QByteArray encodeFaves(const QList<StoredFave> & faves)
+{
+  QJsonArray array;
+  for ( const StoredFave & fave : faves ) {
+    array.append(fave.toJSONObject());
+  }
+  return QJsonDocument(array).toJson(QJsonDocument::Compact);
+}
+}
+
 QList<StoredFave> StoredFave::readFaves()
+{
+  if ( ! UserCatalog::open() ) {
+    return readLegacyFaves();
+  }
+  QList<StoredFave> faves;
+  const QByteArray data = UserCatalog::value(FavesKey);
+  if ( data.isEmpty() ) {
+    return faves;
+  }
+  QJsonParseError parseError;
+  QJsonDocument document = QJsonDocument::fromJson(data,&parseError);
+  if ( parseError.error == QJsonParseError::NoError ) {
+    QJsonArray array = document.array();
+    for ( const QJsonValue & value : array ) {
+      faves.push_back(StoredFave::fromJSONObject(value.toObject()));
+    }
+  } else {
+    qWarning() << "[gmic-qt] Error loading faves (parse error)";
+    qWarning() << "[gmic-qt]" << parseError.errorString();
+  }
+  return faves;
+}
+
+bool StoredFave::writeFaves(const QList<StoredFave> & faves)
+{
+  if ( faves.isEmpty() ) {
+    return UserCatalog::remove(FavesKey);
+  }
+  if ( ! UserCatalog::insert(FavesKey,encodeFaves(faves)) ) {
+    std::cerr << "[gmic-qt] Error: Cannot save faves" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+void StoredFave::importLegacyFiles(QHash<QByteArray,QByteArray> & records)
+{
+  const QList<StoredFave> faves = readLegacyFaves();
+  if ( ! faves.isEmpty() ) {
+    records[FavesKey] = encodeFaves(faves);
+  }
+}
+
+QList<StoredFave> StoredFave::readLegacyFaves()
 {
   QList<StoredFave> faves;
 
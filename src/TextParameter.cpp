@@ -119,9 +119,9 @@ TextParameter::reset()
   _value = _default;
 }
 
-void TextParameter::initFromText(const char * text, int & textLength)
+void TextParameter::initFromDefinition(const ParameterDefinition & definition)
 {
-  QStringList list = parseText("text",text,textLength);
+  QStringList list = parseDefinition(definition);
   _name = HtmlTranslator::html2txt(list[0]);
 
   QString value = list[1];
@@ -23,13 +23,15 @@
  *
  */
 #include <QDebug>
+#include <QRegExp>
+#include "CimgzDecoder.h"
 #include "GmicStdlibParser.h"
+#include "StdlibCache.h"
 #include "Updater.h"
 #include "Common.h"
 #include "gmic_qt.h"
 #include "gmic.h"
 #include <iostream>
-#include <iostream>
 
 Updater * Updater::_instance = 0;
 QObject * Updater::_instanceParent = 0;
@@ -39,6 +41,7 @@ Updater::Updater(QObject *parent) : QObject(parent)
 {
   _networkAccessManager = 0;
   _someNetworkUpdatesAchieved = false;
+  _maxConcurrentDownloads = 2;
 }
 
 Updater * Updater::getInstance()
@@ -59,10 +62,26 @@ Updater::~Updater()
 {
 }
 
-void Updater::updateSources(bool useNetwork)
+void Updater::updateSources(bool useNetwork, bool useCache)
+{
+  listSources(useNetwork,useCache,_sources,_sourceIsStdLib);
+}
+
+void Updater::setSources(const QList<QString> & sources, const QMap<QString,bool> & sourceIsStdlib)
 {
-  _sources.clear();
-  _sourceIsStdLib.clear();
+  _sources = sources;
+  _sourceIsStdLib = sourceIsStdlib;
+}
+
+void Updater::listSources(bool useNetwork, bool useCache,
+                          QList<QString> & sources, QMap<QString,bool> & sourceIsStdlib)
+{
+  sources.clear();
+  sourceIsStdlib.clear();
+  if ( useCache && StdlibCache::readSources(useNetwork,sources,sourceIsStdlib) ) {
+    SHOW(sources);
+    return;
+  }
   // Build sources map
   QString prefix;
   if ( _outputMessageMode >= GmicQt::DebugConsole ) {
@@ -76,15 +95,17 @@ void Updater::updateSources(bool useNetwork)
   cimg_library::CImgList<gmic_pixel_type> gptSources;
   cimg_library::CImgList<char> names;
   QString command = QString("%1-gui_filter_sources %2").arg(prefix).arg(useNetwork);
+  bool ok = true;
   try {
     gmic(command.toLocal8Bit().constData(),gptSources,names,0,true);
   } catch (...) {
+    ok = false;
   }
 
-  cimg_library::CImgList<char> sources;
-  gptSources.move_to(sources);
-  cimglist_for(sources,l) {
-    cimg_library::CImg<char> & str = sources[l];
+  cimg_library::CImgList<char> list;
+  gptSources.move_to(list);
+  cimglist_for(list,l) {
+    cimg_library::CImg<char> & str = list[l];
     str.unroll('x');
     bool isStdlib = (str.back() == 1);
     if ( isStdlib ) {
@@ -93,51 +114,116 @@ void Updater::updateSources(bool useNetwork)
       str.columns(0,str.width());
     }
     QString source(str);
-    _sources << source;
-    _sourceIsStdLib[source] = isStdlib;
+    sources << source;
+    sourceIsStdlib[source] = isStdlib;
+  }
+  SHOW(sources);
+  if ( ok && !sources.isEmpty() ) {
+    StdlibCache::writeSources(useNetwork,sources,sourceIsStdlib);
   }
-  SHOW(_sources);
 }
 
 void Updater::startUpdate(int ageLimit, int timeout, bool useNetwork)
 {
-  updateSources(useNetwork);
+  updateSources(useNetwork,false);
+  startDownloads(ageLimit,timeout,useNetwork);
+}
+
+void Updater::startDownloads(int ageLimit, int timeout, bool useNetwork)
+{
   _errorMessages.clear();
   _networkAccessManager = new QNetworkAccessManager(this);
   connect(_networkAccessManager, SIGNAL(finished(QNetworkReply*)),
           this, SLOT(onNetworkReplyFinished(QNetworkReply*)));
   _someNetworkUpdatesAchieved = false;
+  _queuedSources.clear();
   if ( useNetwork ) {
     TRACE << "Internet update";
-    QDateTime limit = QDateTime::currentDateTime().addSecs(-3600*(qint64)ageLimit);
-    for (QString str : _sources ) {
-      if ( str.startsWith("http://") || str.startsWith("https://") ) {
-        QString filename = localFilename(str);
-        QFileInfo info(filename);
-        if ( ! info.exists() || info.lastModified() < limit ) {
-          TRACE << "Downloading" << str << "to" << filename;
-          _pendingReplies.insert(_networkAccessManager->get(QNetworkRequest(QUrl(str))));
-        }
-      }
-    }
+    QSettings settings;
+    _mirror = settings.value(INTERNET_MIRROR_KEY,QString()).toString();
+    _maxConcurrentDownloads = qMax(1,settings.value(INTERNET_MAX_DOWNLOADS_KEY,2).toInt());
+    _queuedSources = remotesThatNeedUpdate(ageLimit);
+    startQueuedDownloads();
   }
   if ( _pendingReplies.isEmpty() ) {
     emit downloadsFinished(true);
     _networkAccessManager->deleteLater();
+    _networkAccessManager = 0;
   } else {
     QTimer::singleShot(timeout * 1000,this,SLOT(onDownloadsTimeout()));
   }
 }
 
+void Updater::startQueuedDownloads()
+{
+  while ( _pendingReplies.size() < _maxConcurrentDownloads && !_queuedSources.isEmpty() ) {
+    const QString source = _queuedSources.takeFirst();
+    TRACE << "Downloading" << source << "to" << localFilename(source);
+    QNetworkReply * reply = _networkAccessManager->get(buildRequest(source));
+    connect(reply,SIGNAL(readyRead()),
+            this,SLOT(onNetworkReplyReadyRead()));
+    _pendingReplies.insert(reply);
+  }
+}
+
+QNetworkRequest Updater::buildRequest(const QString & source) const
+{
+  QUrl url(source);
+  if ( !_mirror.isEmpty() ) {
+    QString base = _mirror;
+    if ( !base.endsWith('/') ) {
+      base += '/';
+    }
+    url = QUrl(base + QUrl(source).fileName());
+  }
+  QNetworkRequest request(url);
+  request.setAttribute(QNetworkRequest::User,source);
+  QSettings settings;
+  const QString filename = localFilename(source);
+  const QByteArray partValidator = settings.value(validatorKey(source,"PartValidator")).toByteArray();
+  const qint64 partSize = QFileInfo(filename + ".part").size();
+  if ( partSize && !partValidator.isEmpty() ) {
+    // Resume an interrupted download, unless the remote file has changed since
+    request.setRawHeader("Range",QString("bytes=%1-").arg(partSize).toLatin1());
+    request.setRawHeader("If-Range",partValidator);
+    request.setRawHeader("Accept-Encoding","identity");
+  } else if ( QFile::exists(filename) ) {
+    const QByteArray etag = settings.value(validatorKey(source,"ETag")).toByteArray();
+    const QByteArray lastModified = settings.value(validatorKey(source,"LastModified")).toByteArray();
+    if ( !etag.isEmpty() ) {
+      request.setRawHeader("If-None-Match",etag);
+    }
+    if ( !lastModified.isEmpty() ) {
+      request.setRawHeader("If-Modified-Since",lastModified);
+    }
+  }
+  return request;
+}
+
+QString Updater::validatorKey(const QString & source, const char * name)
+{
+  return QString("SourcesValidators/%1/%2").arg(QString::fromLatin1(QUrl::toPercentEncoding(source))).arg(name);
+}
+
+QDateTime Updater::lastCheck(const QString & source) const
+{
+  QFileInfo info(localFilename(source));
+  if ( ! info.exists() ) {
+    return QDateTime();
+  }
+  // A source that was not modified on server side is not rewritten, only its check date is
+  QDateTime checked = QSettings().value(validatorKey(source,"Checked")).toDateTime();
+  return (checked.isValid() && checked > info.lastModified()) ? checked : info.lastModified();
+}
+
 QList<QString> Updater::remotesThatNeedUpdate(int ageLimit) const
 {
-  QDateTime limit = QDateTime::currentDateTime().addSecs(-3600*ageLimit);
+  QDateTime limit = QDateTime::currentDateTime().addSecs(-3600*(qint64)ageLimit);
   QList<QString> list;
   for (QString str : _sources ) {
     if ( str.startsWith("http://") || str.startsWith("https://") ) {
-      QString filename = localFilename(str);
-      QFileInfo info(filename);
-      if ( ! info.exists() || info.lastModified() < limit ) {
+      QDateTime checked = lastCheck(str);
+      if ( ! checked.isValid() || checked < limit ) {
         list << str;
       }
     }
@@ -147,17 +233,7 @@ QList<QString> Updater::remotesThatNeedUpdate(int ageLimit) const
 
 bool Updater::someUpdatesNeeded(int ageLimit) const
 {
-  QDateTime limit = QDateTime::currentDateTime().addSecs(-3600*ageLimit);
-  for (QString str : _sources ) {
-    if ( str.startsWith("http://") || str.startsWith("https://") ) {
-      QString filename = localFilename(str);
-      QFileInfo info(filename);
-      if ( ! info.exists() || info.lastModified() < limit ) {
-        return true;
-      }
-    }
-  }
-  return false;
+  return ! remotesThatNeedUpdate(ageLimit).isEmpty();
 }
 
 QList<QString> Updater::errorMessages()
@@ -172,12 +248,41 @@ bool Updater::allDownloadsOk() const
 
 void Updater::processReply(QNetworkReply * reply)
 {
-  QString url = reply->request().url().toString();
-  if ( !reply->bytesAvailable() ) {
+  const QString url = reply->request().attribute(QNetworkRequest::User).toString();
+  const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+  QSettings settings;
+  if ( status == 304 ) {
+    TRACE << "Not modified:" << url;
+    settings.setValue(validatorKey(url,"Checked"),QDateTime::currentDateTime());
     return;
   }
-  QByteArray array = reply->readAll();
-  if ( array.isNull() ) {
+  QByteArray array = _receivedData.take(reply);
+  array.append(reply->readAll());
+  QString filename = localFilename(url);
+  QFile part(filename + ".part");
+  if ( status == 206 ) {
+    // The reply only holds the end of the file, the .part file must hold the beginning
+    QRegExp contentRange("bytes\\s+(\\d+)-");
+    const bool partMatches = contentRange.indexIn(QString::fromLatin1(reply->rawHeader("Content-Range"))) != -1
+        && part.open(QFile::ReadOnly)
+        && part.size() == contentRange.cap(1).toLongLong();
+    if ( !partMatches ) {
+      part.remove();
+      settings.remove(validatorKey(url,"PartValidator"));
+      if ( reply->request().hasRawHeader("Range") ) {
+        TRACE << "Partial file lost, downloading again:" << url;
+        _queuedSources.push_back(url);
+      } else {
+        _errorMessages << QString(tr("Error downloading %1")).arg(url);
+      }
+      return;
+    }
+    array.prepend(part.readAll());
+    part.close();
+  }
+  part.remove();
+  settings.remove(validatorKey(url,"PartValidator"));
+  if ( array.isEmpty() ) {
     _errorMessages << QString(tr("Error downloading %1 (empty file?)")).arg(url);
     return;
   }
@@ -190,7 +295,6 @@ void Updater::processReply(QNetworkReply * reply)
     _errorMessages << QString(tr("Could not read/decompress %1")).arg(url);
     return;
   }
-  QString filename = localFilename(url);
   QFile file(filename);
   if ( !file.open(QFile::WriteOnly) ) {
     _errorMessages << QString(tr("Error creating file %1")).arg(filename);
@@ -200,6 +304,42 @@ void Updater::processReply(QNetworkReply * reply)
     _errorMessages << QString(tr("Error writing file %1")).arg(filename);
   } else {
     _someNetworkUpdatesAchieved = true;
+    settings.setValue(validatorKey(url,"ETag"),reply->rawHeader("ETag"));
+    settings.setValue(validatorKey(url,"LastModified"),reply->rawHeader("Last-Modified"));
+    settings.setValue(validatorKey(url,"Checked"),QDateTime::currentDateTime());
+  }
+}
+
+void Updater::savePartialDownload(QNetworkReply * reply)
+{
+  // Only raw bytes can be resumed (not transparently decoded ones)
+  QByteArray data = _receivedData.take(reply);
+  data.append(reply->readAll());
+  const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+  const QByteArray encoding = reply->rawHeader("Content-Encoding");
+  QByteArray validator = reply->rawHeader("ETag");
+  if ( validator.isEmpty() || validator.startsWith("W/") ) {
+    validator = reply->rawHeader("Last-Modified");
+  }
+  if ( data.isEmpty() || validator.isEmpty() || (status != 200 && status != 206)
+       || (!encoding.isEmpty() && encoding != "identity") ) {
+    return;
+  }
+  const QString url = reply->request().attribute(QNetworkRequest::User).toString();
+  QFile part(localFilename(url) + ".part");
+  if ( part.open(status == 206 ? (QFile::WriteOnly|QFile::Append) : (QFile::WriteOnly|QFile::Truncate))
+       && part.write(data) == data.size() ) {
+    QSettings().setValue(validatorKey(url,"PartValidator"),validator);
+  } else {
+    part.remove();
+  }
+}
+
+void Updater::onNetworkReplyReadyRead()
+{
+  QNetworkReply * reply = qobject_cast<QNetworkReply*>(sender());
+  if ( reply ) {
+    _receivedData[reply].append(reply->readAll());
   }
 }
 
@@ -208,9 +348,12 @@ void Updater::onNetworkReplyFinished(QNetworkReply * reply)
   if ( reply->error() == QNetworkReply::NoError ) {
     processReply(reply);
   } else {
-    _errorMessages << QString(tr("Error downloading %1")).arg(reply->request().url().toString());
+    savePartialDownload(reply);
+    _errorMessages << QString(tr("Error downloading %1")).arg(reply->request().attribute(QNetworkRequest::User).toString());
   }
+  _receivedData.remove(reply);
   _pendingReplies.remove(reply);
+  startQueuedDownloads();
   if ( _pendingReplies.isEmpty() ) {
     emit downloadsFinished(_errorMessages.isEmpty());
     _networkAccessManager->deleteLater();
@@ -227,42 +370,58 @@ void Updater::notifyAllDowloadsOK()
 
 void Updater::onDownloadsTimeout()
 {
+  // Sources not requested yet are given up
+  for ( const QString & source : _queuedSources ) {
+    _errorMessages << QString(tr("Download timeout: %1")).arg(source);
+  }
+  _queuedSources.clear();
   // Make a copy because aborting will call onNetworkReplyFinished, and
   // thus modify the _pendingReplies set.
   QSet<QNetworkReply*> replies = _pendingReplies;
   for ( QNetworkReply * reply : replies ) {
-    _errorMessages << QString(tr("Download timeout: %1")).arg(reply->request().url().toString());
+    _errorMessages << QString(tr("Download timeout: %1")).arg(reply->request().attribute(QNetworkRequest::User).toString());
     reply->abort();
   }
 }
 
 QByteArray Updater::cimgzDecompress(QByteArray array)
 {
+  bool supported;
+  QByteArray result = CimgzDecoder::decode(array.constData(),array.size(),supported);
+  if ( supported ) {
+    if ( result.isNull() ) {
+      qWarning() << "Updater::cimgzDecompress(): Cannot decode corrupted cimgz data";
+    }
+    return result;
+  }
+  // Layouts not handled by CimgzDecoder, CImg's loader needs a file
   QTemporaryFile tmpZ(QDir::tempPath() + QDir::separator() + "gmic_qt_update_XXXXXX_cimgz");
   if ( ! tmpZ.open() ) {
     qWarning() << "Updater::cimgzDecompress(): Error creating" << tmpZ.fileName();
     return QByteArray();
   }
   tmpZ.write(array);
-  tmpZ.flush();
   tmpZ.close();
-  std::FILE * file = fopen(tmpZ.fileName().toLocal8Bit().constData(),"rb");
-  if ( !file ) {
-    qWarning() << "Updater::cimgzDecompress(): Error opening" << tmpZ.fileName();
-    return QByteArray();
-  }
-  cimg_library::CImg<unsigned char> buffer;
-  try {
-    buffer.load_cimg(file);
-  } catch (...) {
-    qWarning() << "Updater::cimgzDecompress(): CImg<>::load_cimg error for file " << tmpZ.fileName();
-    return QByteArray();
-  }
-  return QByteArray((char*)buffer.data(),buffer.size());
+  return cimgzDecompressFile(tmpZ.fileName());
 }
 
 QByteArray Updater::cimgzDecompressFile(QString filename)
 {
+  QFile file(filename);
+  if ( file.open(QFile::ReadOnly) && file.size() ) {
+    const uchar * data = file.map(0,file.size());
+    if ( data ) {
+      bool supported;
+      QByteArray result = CimgzDecoder::decode(reinterpret_cast<const char*>(data),file.size(),supported);
+      if ( supported ) {
+        if ( result.isNull() ) {
+          qWarning() << "Updater::cimgzDecompressFile(): Cannot decode" << filename;
+        }
+        return result;
+      }
+    }
+  }
+  // Layouts not handled by CimgzDecoder
   cimg_library::CImg<unsigned char> buffer;
   try {
     buffer.load_cimg(filename.toLocal8Bit().constData());
@@ -285,8 +444,13 @@ QString Updater::localFilename(QString url)
 
 bool Updater::isStdlib(const QString & source) const
 {
-  QMap<QString,bool>::const_iterator it = _sourceIsStdLib.find(source);
-  if ( it != _sourceIsStdLib.end() ) {
+  return isStdlib(source,_sourceIsStdLib);
+}
+
+bool Updater::isStdlib(const QString & source, const QMap<QString,bool> & sourceIsStdlib)
+{
+  QMap<QString,bool>::const_iterator it = sourceIsStdlib.find(source);
+  if ( it != sourceIsStdlib.end() ) {
     return it.value();
   }
   return false;
@@ -298,21 +462,40 @@ QList<QString> Updater::sources() const
 }
 
 QByteArray Updater::buildFullStdlib() const
+{
+  return buildFullStdlib(_sources,_sourceIsStdLib);
+}
+
+QByteArray Updater::buildFullStdlib(const QList<QString> & sources, const QMap<QString,bool> & sourceIsStdlib)
+{
+  QList<QString> files;
+  for ( const QString & source : sources ) {
+    files.push_back(localFilename(source));
+  }
+  QByteArray stdlib = StdlibCache::readStdlib(files);
+  if ( stdlib.isNull() ) {
+    stdlib = assembleStdlib(sources,sourceIsStdlib);
+    StdlibCache::writeStdlib(files,stdlib);
+  }
+  return stdlib;
+}
+
+QByteArray Updater::assembleStdlib(const QList<QString> & sources, const QMap<QString,bool> & sourceIsStdlib)
 {
   QByteArray result;
-  if ( _sources.isEmpty() ) {
+  if ( sources.isEmpty() ) {
     gmic_image<char> stdlib_h = gmic::decompress_stdlib();
     QByteArray tmp = QByteArray::fromRawData(stdlib_h,stdlib_h.size());
     tmp[tmp.size()-1] = '\n';
     result.append(tmp);
     return result;
   }
-  for ( QString source : _sources ) {
+  for ( QString source : sources ) {
     QString filename = localFilename(source);
     QFile file(filename);
     if ( file.open(QFile::ReadOnly) ) {
       QByteArray array;
-      if ( isStdlib(source) && !file.peek(10).startsWith("#@gmic") ) {
+      if ( isStdlib(source,sourceIsStdlib) && !file.peek(10).startsWith("#@gmic") ) {
         // Try to uncompress
         file.close();
         TRACE << "Appending compressed file:" << filename;
@@ -332,7 +515,7 @@ QByteArray Updater::buildFullStdlib() const
       }
       result.append(array);
       result.append('\n');
-    } else if ( isStdlib(source) ) {
+    } else if ( isStdlib(source,sourceIsStdlib) ) {
       gmic_image<char> stdlib_h = gmic::decompress_stdlib();
       QByteArray tmp = QByteArray::fromRawData(stdlib_h,stdlib_h.size());
       tmp[tmp.size()-1] = '\n';
@@ -0,0 +1,135 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file UserCatalog.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "UserCatalog.h"
+#include <QDebug>
+#include <QMutexLocker>
+#include <iostream>
+#include "Common.h"
+#include "FiltersVisibilityMap.h"
+#include "ParametersCache.h"
+#include "StoredFave.h"
+
+KeyValueStore UserCatalog::_store;
+bool UserCatalog::_opened = false;
+QMutex UserCatalog::_mutex;
+
+namespace {
+const QByteArray VersionKey("catalog/version");
+}
+
+bool UserCatalog::open()
+{
+  QMutexLocker locker(&_mutex);
+  return openStore();
+}
+
+bool UserCatalog::openStore()
+{
+  if ( _opened ) {
+    return _store.isOpen();
+  }
+  _opened = true;
+  const QString filename = GmicQt::path_rc(true) + USER_CATALOG_FILENAME;
+  if ( ! _store.open(filename) ) {
+    std::cerr << "[gmic-qt] Error: Cannot open " << filename.toStdString() << std::endl;
+    std::cerr << "[gmic-qt] Faves, parameters and filters visibility cannot be saved.\n";
+    return false;
+  }
+  const QByteArray version = _store.value(VersionKey);
+  if ( version.isEmpty() ) {
+    importLegacyFiles();
+  } else if ( version.toInt() > Version ) {
+    qWarning() << "[gmic-qt] Warning:" << filename << "was written by a newer version of the plugin";
+  }
+  return true;
+}
+
+void UserCatalog::importLegacyFiles()
+{
+  // The previous files are left untouched, for older versions of the plugin
+  QHash<QByteArray,QByteArray> records;
+  ParametersCache::importLegacyFiles(records);
+  FiltersVisibilityMap::importLegacyFile(records);
+  StoredFave::importLegacyFiles(records);
+  records[VersionKey] = QByteArray::number(Version);
+  if ( ! _store.write(records) ) {
+    qWarning() << "[gmic-qt] Error: Cannot import previous settings into" << _store.filename();
+  }
+}
+
+void UserCatalog::close()
+{
+  QMutexLocker locker(&_mutex);
+  if ( _store.isOpen() && _store.needsCompaction() ) {
+    _store.compact();
+  }
+  _store.close();
+  _opened = false;
+}
+
+bool UserCatalog::contains(const QByteArray & key)
+{
+  QMutexLocker locker(&_mutex);
+  return openStore() && _store.contains(key);
+}
+
+QByteArray UserCatalog::value(const QByteArray & key)
+{
+  QMutexLocker locker(&_mutex);
+  return openStore() ? _store.value(key) : QByteArray();
+}
+
+QList<QByteArray> UserCatalog::keys(const QByteArray & prefix)
+{
+  QMutexLocker locker(&_mutex);
+  QList<QByteArray> result;
+  if ( openStore() ) {
+    for ( const QByteArray & key : _store.keys() ) {
+      if ( key.startsWith(prefix) ) {
+        result.push_back(key);
+      }
+    }
+  }
+  return result;
+}
+
+bool UserCatalog::insert(const QByteArray & key, const QByteArray & value)
+{
+  QMutexLocker locker(&_mutex);
+  return openStore() && _store.insert(key,value);
+}
+
+bool UserCatalog::remove(const QByteArray & key)
+{
+  QMutexLocker locker(&_mutex);
+  return openStore() && _store.remove(key);
+}
+
+bool UserCatalog::write(const QHash<QByteArray,QByteArray> & inserts,
+                        const QList<QByteArray> & removals)
+{
+  QMutexLocker locker(&_mutex);
+  return openStore() && _store.write(inserts,removals);
+}
@@ -36,6 +36,7 @@
 #include "MainWindow.h"
 #include "ProgressInfoWindow.h"
 #include "HeadlessProcessor.h"
+#include "ResidentServer.h"
 #include "Common.h"
 #include "gmic.h"
 
@@ -140,11 +141,8 @@ int launchPlugin()
     Updater::setOutputMessageMode(mode);
     ageLimit = settings.value(INTERNET_UPDATE_PERIODICITY_KEY,0).toInt();
   }
-  Updater * updater = Updater::getInstance();
   MainWindow mainWindow;
-  QObject::connect(updater,SIGNAL(downloadsFinished(bool)),
-                   &mainWindow,SLOT(startupUpdateFinished(bool)));
-  updater->startUpdate(ageLimit,4, ageLimit != INTERNET_NEVER_UPDATE_PERIODICITY );
+  mainWindow.startup(ageLimit, ageLimit != INTERNET_NEVER_UPDATE_PERIODICITY );
   return app.exec();
 }
 
@@ -168,7 +166,7 @@ int launchPluginHeadlessUsingLastParameters()
   if ( processor.command().isEmpty() ) {
     return 0;
   } else {
-    processor.startProcessing();
+    QTimer::singleShot(0,&processor,SLOT(startProcessing()));
     return app.exec();
   }
 }
@@ -195,3 +193,23 @@ int launchPluginHeadless(const char *command, GmicQt::InputMode input, GmicQt::O
   idle.start();
   return app.exec();
 }
+
+int launchPluginServer()
+{
+  int dummy_argc = 1;
+  char dummy_app_name[] = GMIC_QT_APPLICATION_NAME;
+  char * dummy_argv[1] = { dummy_app_name };
+#ifdef _IS_WINDOWS_
+  SetErrorMode(SEM_FAILCRITICALERRORS|SEM_NOGPFAULTERRORBOX|SEM_NOOPENFILEERRORBOX);
+#endif
+  QCoreApplication app(dummy_argc, dummy_argv);
+  QCoreApplication::setOrganizationName(GMIC_QT_ORGANISATION_NAME);
+  QCoreApplication::setOrganizationDomain(GMIC_QT_ORGANISATION_DOMAIN);
+  QCoreApplication::setApplicationName(GMIC_QT_APPLICATION_NAME);
+  Updater::setInstanceParent(&app);
+  ResidentServer server(&app);
+  if ( ! server.start() ) {
+    return 1;
+  }
+  return app.exec();
+}
@@ -47,6 +47,22 @@
 #define _gimp_item_get_visible gimp_item_get_visible
 #endif
 
+#if !((GIMP_MAJOR_VERSION<2) || ((GIMP_MAJOR_VERSION==2) && (GIMP_MINOR_VERSION<=8)))
+#include <gegl.h>
+#if !defined(GEGL_MAJOR_VERSION) || !defined(GEGL_MINOR_VERSION) || !defined(GEGL_MICRO_VERSION)
+#error "GEGL version macros are not defined (gegl-version.h)"
+#endif
+#if (GEGL_MAJOR_VERSION>0) || (GEGL_MINOR_VERSION>4) || ((GEGL_MINOR_VERSION==4) && (GEGL_MICRO_VERSION>=14))
+#define _gegl_buffer_iterator_new(buffer,roi,format,access) gegl_buffer_iterator_new(buffer,roi,0,format,access,GEGL_ABYSS_NONE,1)
+#define _gegl_buffer_iterator_data(it) ((it)->items[0].data)
+#define _gegl_buffer_iterator_roi(it) ((it)->items[0].roi)
+#else
+#define _gegl_buffer_iterator_new(buffer,roi,format,access) gegl_buffer_iterator_new(buffer,roi,0,format,access,GEGL_ABYSS_NONE)
+#define _gegl_buffer_iterator_data(it) ((it)->data[0])
+#define _gegl_buffer_iterator_roi(it) ((it)->roi[0])
+#endif
+#endif
+
 namespace GmicQt {
 const QString HostApplicationName = QString("GIMP %1.%2").arg(GIMP_MAJOR_VERSION).arg(GIMP_MINOR_VERSION);
 const char * HostApplicationShortname = GMIC_QT_XSTRINGIFY(GMIC_HOST);
@@ -58,6 +74,69 @@ int gmic_qt_gimp_image_id;
 cimg_library::CImg<int> inputLayerDimensions;
 std::vector<int> inputLayers;
 
+#if !((GIMP_MAJOR_VERSION<2) || ((GIMP_MAJOR_VERSION==2) && (GIMP_MINOR_VERSION<=8)))
+
+const char * floatFormatName(int spectrum)
+{
+  return spectrum==1 ? "Y' float" : spectrum==2 ? "Y'A float" : spectrum==3 ? "R'G'B' float" : "R'G'B'A float";
+}
+
+/*
+ * Copy an area of a buffer into a planar image (with values in [0,255]),
+ * tile by tile, with no intermediate interleaved image.
+ */
+void readBuffer(GeglBuffer * buffer, const GeglRectangle & rect, int spectrum, cimg_library::CImg<float> & img)
+{
+  img.assign(rect.width,rect.height,1,spectrum);
+  GeglBufferIterator * it = _gegl_buffer_iterator_new(buffer,&rect,babl_format(floatFormatName(spectrum)),GEGL_ACCESS_READ);
+  while ( gegl_buffer_iterator_next(it) ) {
+    const float * const data = static_cast<const float*>(_gegl_buffer_iterator_data(it));
+    const GeglRectangle roi = _gegl_buffer_iterator_roi(it);
+    for ( int row = 0; row < roi.height; ++row ) {
+      const float * const src = data + static_cast<size_t>(row) * roi.width * spectrum;
+      const int x0 = roi.x - rect.x;
+      const int y = roi.y - rect.y + row;
+      for ( int c = 0; c < spectrum; ++c ) {
+        float * const dst = img.data(x0,y,0,c);
+        const float * s = src + c;
+        for ( int x = 0; x < roi.width; ++x, s += spectrum ) {
+          dst[x] = *s * 255;
+        }
+      }
+    }
+  }
+}
+
+/*
+ * Copy a planar image (with values in [0,255]) into an area of a buffer,
+ * tile by tile, with no intermediate interleaved image.
+ */
+void writeBuffer(GeglBuffer * buffer, const GeglRectangle & rect, const cimg_library::CImg<float> & img)
+{
+  const int spectrum = std::min(img.spectrum(),4);
+  GeglRectangle area;
+  gegl_rectangle_set(&area,rect.x,rect.y,std::min(rect.width,img.width()),std::min(rect.height,img.height()));
+  GeglBufferIterator * it = _gegl_buffer_iterator_new(buffer,&area,babl_format(floatFormatName(spectrum)),GEGL_ACCESS_WRITE);
+  while ( gegl_buffer_iterator_next(it) ) {
+    float * const data = static_cast<float*>(_gegl_buffer_iterator_data(it));
+    const GeglRectangle roi = _gegl_buffer_iterator_roi(it);
+    for ( int row = 0; row < roi.height; ++row ) {
+      float * const dst = data + static_cast<size_t>(row) * roi.width * spectrum;
+      const int x0 = roi.x - area.x;
+      const int y = roi.y - area.y + row;
+      for ( int c = 0; c < spectrum; ++c ) {
+        const float * const src = img.data(x0,y,0,c);
+        float * d = dst + c;
+        for ( int x = 0; x < roi.width; ++x, d += spectrum ) {
+          *d = src[x] / 255;
+        }
+      }
+    }
+  }
+}
+
+#endif
+
 #if (GIMP_MAJOR_VERSION>=3 || GIMP_MINOR_VERSION>8) && !defined(GIMP_NORMAL_MODE)
 typedef GimpLayerMode GimpLayerModeEffects;
 #define GIMP_NORMAL_MODE GIMP_LAYER_MODE_NORMAL
@@ -531,13 +610,8 @@ void gmic_qt_get_cropped_images( gmic_list<float> & images,
     GeglRectangle rect;
     gegl_rectangle_set(&rect,ix,iy,iw,ih);
     GeglBuffer *buffer = gimp_drawable_get_buffer(inputLayers[l]);
-    const char *const format = spectrum==1 ? "Y' " gmic_pixel_type_str :
-                                             spectrum==2 ? "Y'A " gmic_pixel_type_str
-                                                         : spectrum==3 ? "R'G'B' " gmic_pixel_type_str
-                                                                       : "R'G'B'A " gmic_pixel_type_str;
-    CImg<float> img(spectrum,iw,ih);
-    gegl_buffer_get(buffer,&rect,1,babl_format(format),img.data(),0,GEGL_ABYSS_NONE);
-    (img *= 255).permute_axes("yzcx");
+    CImg<float> img;
+    readBuffer(buffer,rect,spectrum,img);
     g_object_unref(buffer);
 #endif
     img.move_to(images[l]);
@@ -642,10 +716,7 @@ void gmic_qt_output_images( gmic_list<gmic_pixel_type> & images,
           GeglRectangle rect;
           gegl_rectangle_set(&rect,rgn_x,rgn_y,rgn_width,rgn_height);
           GeglBuffer *buffer = gimp_drawable_get_shadow_buffer(inputLayers[p]);
-          const char *const format = img.spectrum()==1?"Y' float":img.spectrum()==2?"Y'A float":
-                                                                                    img.spectrum()==3?"R'G'B' float":"R'G'B'A float";
-          (img/=255).permute_axes("cxyz");
-          gegl_buffer_set(buffer,&rect,0,babl_format(format),img.data(),0);
+          writeBuffer(buffer,rect,img);
           g_object_unref(buffer);
           gimp_drawable_merge_shadow(inputLayers[p],true);
           gimp_drawable_update(inputLayers[p],0,0,img.width(),img.height());
@@ -728,10 +799,9 @@ void gmic_qt_output_images( gmic_list<gmic_pixel_type> & images,
           gimp_drawable_detach(drawable);
 #else
           GeglBuffer *buffer = gimp_drawable_get_shadow_buffer(layer_id);
-          const char *const format = img.spectrum()==1?"Y' float":img.spectrum()==2?"Y'A float":
-                                                                                    img.spectrum()==3?"R'G'B' float":"R'G'B'A float";
-          (img/=255).permute_axes("cxyz");
-          gegl_buffer_set(buffer,NULL,0,babl_format(format),img.data(),0);
+          GeglRectangle rect;
+          gegl_rectangle_set(&rect,0,0,img.width(),img.height());
+          writeBuffer(buffer,rect,img);
           g_object_unref(buffer);
           gimp_drawable_merge_shadow(layer_id,true);
           gimp_drawable_update(layer_id,0,0,img.width(),img.height());
@@ -808,9 +878,9 @@ void gmic_qt_output_images( gmic_list<gmic_pixel_type> & images,
           gimp_drawable_detach(drawable);
 #else
           GeglBuffer *buffer = gimp_drawable_get_shadow_buffer(layer_id);
-          const char *const format = img.spectrum()==1?"Y' float":img.spectrum()==2?"Y'A float": img.spectrum()==3?"R'G'B' float":"R'G'B'A float";
-          (img/=255).permute_axes("cxyz");
-          gegl_buffer_set(buffer,NULL,0,babl_format(format),img.data(),0);
+          GeglRectangle rect;
+          gegl_rectangle_set(&rect,0,0,img.width(),img.height());
+          writeBuffer(buffer,rect,img);
           g_object_unref(buffer);
           gimp_drawable_merge_shadow(layer_id,true);
           gimp_drawable_update(layer_id,0,0,img.width(),img.height());
@@ -889,10 +959,9 @@ void gmic_qt_output_images( gmic_list<gmic_pixel_type> & images,
           gimp_drawable_detach(drawable);
 #else
           GeglBuffer *buffer = gimp_drawable_get_shadow_buffer(layer_id);
-          const char *const format = img.spectrum()==1?"Y' float":img.spectrum()==2?"Y'A float":
-                                                                                    img.spectrum()==3?"R'G'B' float":"R'G'B'A float";
-          (img/=255).permute_axes("cxyz");
-          gegl_buffer_set(buffer,NULL,0,babl_format(format),img.data(),0);
+          GeglRectangle rect;
+          gegl_rectangle_set(&rect,0,0,img.width(),img.height());
+          writeBuffer(buffer,rect,img);
           g_object_unref(buffer);
           gimp_drawable_merge_shadow(layer_id,true);
           gimp_drawable_update(layer_id,0,0,img.width(),img.height());
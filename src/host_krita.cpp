@@ -31,9 +31,13 @@
 #include <QLocalSocket>
 #include <QDataStream>
 #include <QBuffer>
-#include <QUuid>
+#include <QElapsedTimer>
+#include <QSettings>
+#include <QHash>
+#include <QtEndian>
 
 #include <ImageConverter.h>
+#include <SharedMemoryPool.h>
 
 #include <algorithm>
 #include "host.h"
@@ -54,6 +58,17 @@
  *
  * After a message has been received, "ack" is sent
  *
+ * When Krita launches the plugin with "--protocol=N" (N >= 1), it is
+ * sent the message
+ *
+ * command=gmic_qt_open_connection
+ * protocol=min(N,2)
+ *
+ * and if Krita answers "protocol=1" or "protocol=2" within ProbeTimeout,
+ * a single connection is then kept open for all the following requests,
+ * using the binary protocol described below (see KritaConnection).
+ * Otherwise (older Krita versions do not pass the option), the text
+ * protocol above is used for every request.
  */
 
 namespace GmicQt {
@@ -63,10 +78,16 @@ const char *HostApplicationShortname = GMIC_QT_XSTRINGIFY(GMIC_HOST);
 
 static QString socketKey = "gmic-krita";
 static const char ack[] = "ack";
-static QVector<QSharedMemory*> sharedMemorySegments;
+// Highest binary protocol version announced by Krita (0 for none)
+static int kritaProtocol = 0;
+static const int ProbeTimeout = 2000; // ms
 
+static SharedMemoryPool sharedMemoryPool;
 
-QByteArray sendMessageSynchronously(const QByteArray ba)
+/*
+ * A negative timeout (ms) waits for the answer as long as the socket is valid
+ */
+QByteArray sendMessageSynchronously(const QByteArray ba, int timeout = -1)
 {
     QByteArray answer;
 
@@ -84,12 +105,18 @@ QByteArray sendMessageSynchronously(const QByteArray ba)
     ds.writeBytes(ba.constData(), ba.length());
     socket.waitForBytesWritten();
 
+    QElapsedTimer clock;
+    clock.start();
     while (socket.bytesAvailable() < static_cast<int>(sizeof(quint32))) {
         if (!socket.isValid()) {
             qWarning() << "Stale request";
             return answer;
         }
-        socket.waitForReadyRead(1000);
+        if (timeout >= 0 && clock.elapsed() >= timeout) {
+            qWarning() << "No answer from the Krita instance.";
+            return answer;
+        }
+        socket.waitForReadyRead(timeout >= 0 ? qBound(1, timeout - int(clock.elapsed()), 1000) : 1000);
     }
 
     // Get the answer
@@ -117,10 +144,431 @@ QByteArray sendMessageSynchronously(const QByteArray ba)
     return answer;
 }
 
+namespace {
+
+/*
+ * Binary protocol
+ *
+ * Every message is a frame made of
+ *
+ * size (quint32, bytes following this field)
+ * magic (quint32, "GMKB")
+ * request id (quint32)
+ * message type (quint16)
+ * payload
+ *
+ * Integers are big endian, payloads are QDataStream (Qt 5.2) encoded.
+ * An answer carries the id and type of the request it answers, so several
+ * requests may be sent before their answers are read. No "ack" is sent.
+ *
+ * GetImageSize      request: mode (qint32)
+ *                   answer : width, height (qint32)
+ * GetCroppedImages  request: mode (qint32), x, y, width, height (double)
+ *                   answer : count (quint32), then for each image
+ *                            key (QString), name (QByteArray, UTF-8),
+ *                            width, height (qint32)
+ * Detach            request: empty, answer: empty
+ * OutputImages      request: mode (qint32), count (quint32), then for each image
+ *                            key (QString), name (QByteArray, UTF-8),
+ *                            spectrum, width, height (qint32)
+ *                   answer : empty
+ *
+ * Pixels are always stored plane by plane (as in a CImg), with values in [0,255]
+ * (version 1: 4 channels of float).
+ *
+ * Version 2 adds the sample depth (8, 16 or 32 for float) and the channel count:
+ *
+ * GetImageSize      answer : width, height, depth (qint32)
+ *                            depth is the native one of the document
+ * GetCroppedImages  request: mode (qint32), x, y, width, height (double),
+ *                            depth (qint32, 0 for the native depth)
+ *                   answer : count (quint32), then for each image
+ *                            key (QString), name (QByteArray, UTF-8),
+ *                            width, height, spectrum, depth (qint32)
+ * OutputImages      request: mode (qint32), count (quint32), then for each image
+ *                            key (QString), name (QByteArray, UTF-8),
+ *                            spectrum, width, height, depth (qint32)
+ *
+ * 8 bits samples are in [0,255], 16 bits ones in [0,65535].
+ */
+const quint32 ProtocolMagic = 0x474d4b42; // "GMKB"
+const int ProtocolVersion = 2;
+const int DepthNative = 0;
+const int Depth8 = 8;
+const int Depth16 = 16;
+const int DepthFloat = 32;
+const qint64 FrameHeaderSize = 2 * sizeof(quint32) + sizeof(quint16);
+
+enum MessageType : quint16 {
+    GetImageSize = 1,
+    GetCroppedImages,
+    Detach,
+    OutputImages,
+    MessageTypeCount
+};
+
+const char *messageTypeName(int type)
+{
+    switch (type) {
+    case GetImageSize: return "get_image_size";
+    case GetCroppedImages: return "get_cropped_images";
+    case Detach: return "detach";
+    case OutputImages: return "output_images";
+    default: return "unknown";
+    }
+}
+
+class KritaConnection
+{
+public:
+    static KritaConnection *instance();
+    static void release();
+
+    bool isOpen() const;
+    int version() const;
+
+    /**
+     * Native depth of the document, as last reported by Krita
+     * (DepthFloat if unknown).
+     */
+    int documentDepth() const;
+    void setDocumentDepth(int depth);
+
+    /**
+     * Send a request without waiting for its answer.
+     * @return the request id, or 0 if the connection is broken
+     */
+    quint32 post(MessageType type, const QByteArray &payload, bool discardAnswer = false);
+    bool waitForAnswer(quint32 id, QByteArray &answer);
+    bool request(MessageType type, const QByteArray &payload, QByteArray &answer);
+
+private:
+    KritaConnection();
+    ~KritaConnection();
+    bool open();
+    void close();
+    bool waitForBytes(qint64 count);
+    bool readFrame();
+    /**
+     * Latency of the requests, per message type. Printed on release
+     * when the last applied filter used a debug output mode.
+     */
+    void printStatistics() const;
+
+    struct Pending {
+        MessageType type;
+        qint64 start;
+        bool discardAnswer;
+    };
+    struct Statistics {
+        quint64 count;
+        qint64 totalNs;
+        qint64 maxNs;
+    };
+
+    static KritaConnection *_instance;
+    QLocalSocket *_socket;
+    int _version;
+    int _documentDepth;
+    quint32 _lastId;
+    QHash<quint32, Pending> _pending;
+    QHash<quint32, QByteArray> _answers;
+    QElapsedTimer _clock;
+    Statistics _statistics[MessageTypeCount];
+};
+
+KritaConnection *KritaConnection::_instance = 0;
+
+KritaConnection *KritaConnection::instance()
+{
+    if (!_instance) {
+        _instance = new KritaConnection;
+        _instance->open();
+    }
+    return _instance;
+}
+
+void KritaConnection::release()
+{
+    QSettings settings(GMIC_QT_ORGANISATION_NAME, GMIC_QT_APPLICATION_NAME);
+    const int mode = settings.value(QString("LastExecution/host_%1/OutputMessageMode").arg(GmicQt::HostApplicationShortname), GmicQt::Quiet).toInt();
+    if (_instance && (mode == GmicQt::DebugConsole || mode == GmicQt::DebugLogFile)) {
+        _instance->printStatistics();
+    }
+    delete _instance;
+    _instance = 0;
+}
+
+KritaConnection::KritaConnection()
+    : _socket(0)
+    , _version(0)
+    , _documentDepth(DepthFloat)
+    , _lastId(0)
+{
+    memset(_statistics, 0, sizeof(_statistics));
+    _clock.start();
+}
+
+KritaConnection::~KritaConnection()
+{
+    close();
+}
+
+bool KritaConnection::open()
+{
+    // Older Krita versions do not know this command and only speak the text protocol:
+    // it is only sent if Krita announced the binary protocol on the command line.
+    if (kritaProtocol < 1) {
+        return false;
+    }
+    QByteArray command = QString("command=gmic_qt_open_connection\nprotocol=%1").arg(qMin(kritaProtocol, ProtocolVersion)).toUtf8();
+    QString answer = QString::fromUtf8(sendMessageSynchronously(command, ProbeTimeout)).trimmed();
+    if (!answer.startsWith("protocol=")) {
+        return false;
+    }
+    const int version = answer.mid(9).toInt();
+    if (version < 1 || version > ProtocolVersion) {
+        return false;
+    }
+    _socket = new QLocalSocket;
+    _socket->connectToServer(socketKey);
+    if (!_socket->waitForConnected(1000)) {
+        qWarning() << "Could not open a connection to the Krita instance, using the text protocol.";
+        close();
+        return false;
+    }
+    _version = version;
+    return true;
+}
+
+void KritaConnection::close()
+{
+    if (_socket) {
+        _socket->disconnectFromServer();
+        delete _socket;
+        _socket = 0;
+    }
+    _pending.clear();
+    _answers.clear();
+}
+
+bool KritaConnection::isOpen() const
+{
+    return _socket;
+}
+
+int KritaConnection::version() const
+{
+    return _socket ? _version : 0;
+}
+
+int KritaConnection::documentDepth() const
+{
+    return _documentDepth;
+}
+
+void KritaConnection::setDocumentDepth(int depth)
+{
+    if (depth == Depth8 || depth == Depth16 || depth == DepthFloat) {
+        _documentDepth = depth;
+    }
+}
+
+quint32 KritaConnection::post(MessageType type, const QByteArray &payload, bool discardAnswer)
+{
+    if (!_socket) {
+        return 0;
+    }
+    if (!++_lastId) {
+        ++_lastId;
+    }
+    QByteArray frame;
+    frame.reserve(sizeof(quint32) + FrameHeaderSize + payload.size());
+    QDataStream ds(&frame, QIODevice::WriteOnly);
+    ds << quint32(FrameHeaderSize + payload.size()) << ProtocolMagic << _lastId << quint16(type);
+    frame.append(payload);
+    if (_socket->write(frame) != frame.size()) {
+        qWarning() << "Lost the connection to the Krita instance." << _socket->errorString();
+        close();
+        return 0;
+    }
+    _socket->flush();
+    Pending pending = { type, _clock.nsecsElapsed(), discardAnswer };
+    _pending.insert(_lastId, pending);
+    return _lastId;
+}
+
+bool KritaConnection::waitForBytes(qint64 count)
+{
+    while (_socket->bytesAvailable() < count) {
+        if (_socket->state() != QLocalSocket::ConnectedState) {
+            qWarning() << "Lost the connection to the Krita instance." << _socket->errorString();
+            return false;
+        }
+        _socket->waitForReadyRead(1000);
+    }
+    return true;
+}
+
+bool KritaConnection::readFrame()
+{
+    if (!waitForBytes(sizeof(quint32))) {
+        return false;
+    }
+    uchar sizeBytes[sizeof(quint32)];
+    _socket->read(reinterpret_cast<char *>(sizeBytes), sizeof(quint32));
+    const quint32 size = qFromBigEndian<quint32>(sizeBytes);
+    if (size < FrameHeaderSize || !waitForBytes(size)) {
+        return false;
+    }
+    const QByteArray frame = _socket->read(size);
+    const uchar *header = reinterpret_cast<const uchar *>(frame.constData());
+    const quint32 magic = qFromBigEndian<quint32>(header);
+    const quint32 id = qFromBigEndian<quint32>(header + sizeof(quint32));
+    if (magic != ProtocolMagic) {
+        qWarning() << "Got an invalid answer from the Krita instance.";
+        return false;
+    }
+    QHash<quint32, Pending>::iterator it = _pending.find(id);
+    if (it == _pending.end()) {
+        return true;
+    }
+    Statistics &statistics = _statistics[it.value().type];
+    const qint64 latency = _clock.nsecsElapsed() - it.value().start;
+    ++statistics.count;
+    statistics.totalNs += latency;
+    statistics.maxNs = std::max(statistics.maxNs, latency);
+    if (!it.value().discardAnswer) {
+        _answers.insert(id, frame.mid(FrameHeaderSize));
+    }
+    _pending.erase(it);
+    return true;
+}
+
+bool KritaConnection::waitForAnswer(quint32 id, QByteArray &answer)
+{
+    while (!_answers.contains(id)) {
+        if (!_socket || !_pending.contains(id)) {
+            return false;
+        }
+        if (!readFrame()) {
+            close();
+            return false;
+        }
+    }
+    answer = _answers.take(id);
+    return true;
+}
+
+bool KritaConnection::request(MessageType type, const QByteArray &payload, QByteArray &answer)
+{
+    const quint32 id = post(type, payload);
+    return id && waitForAnswer(id, answer);
+}
+
+void KritaConnection::printStatistics() const
+{
+    for (int type = GetImageSize; type < MessageTypeCount; ++type) {
+        const Statistics &statistics = _statistics[type];
+        if (statistics.count) {
+            qDebug() << "gmic-qt: Krita" << messageTypeName(type) << "requests:" << statistics.count
+                     << "average" << (statistics.totalNs / statistics.count) / 1000 << "us,"
+                     << "max" << statistics.maxNs / 1000 << "us";
+        }
+    }
+}
+
+QDataStream &setupStream(QDataStream &ds)
+{
+    ds.setVersion(QDataStream::Qt_5_2);
+    return ds;
+}
+
+int bytesPerSample(int depth)
+{
+    switch (depth) {
+    case Depth8: return sizeof(quint8);
+    case Depth16: return sizeof(quint16);
+    default: return sizeof(float);
+    }
+}
+
+void readSamples(const void *source, int depth, float *destination, qint64 count)
+{
+    if (depth == Depth8) {
+        const quint8 *samples = static_cast<const quint8 *>(source);
+        for (qint64 i = 0; i < count; ++i) {
+            destination[i] = samples[i];
+        }
+    } else if (depth == Depth16) {
+        const quint16 *samples = static_cast<const quint16 *>(source);
+        const float scale = 255.0f / 65535.0f;
+        for (qint64 i = 0; i < count; ++i) {
+            destination[i] = samples[i] * scale;
+        }
+    } else {
+        memcpy(destination, source, count * sizeof(float));
+    }
+}
+
+void writeSamples(const float *source, qint64 count, int depth, void *destination)
+{
+    if (depth == Depth8) {
+        quint8 *samples = static_cast<quint8 *>(destination);
+        for (qint64 i = 0; i < count; ++i) {
+            samples[i] = static_cast<quint8>(qBound(0.0f, source[i], 255.0f) + 0.5f);
+        }
+    } else if (depth == Depth16) {
+        quint16 *samples = static_cast<quint16 *>(destination);
+        const float scale = 65535.0f / 255.0f;
+        for (qint64 i = 0; i < count; ++i) {
+            samples[i] = static_cast<quint16>(qBound(0.0f, source[i] * scale, 65535.0f) + 0.5f);
+        }
+    } else {
+        memcpy(destination, source, count * sizeof(float));
+    }
+}
+
+struct SharedImageFormat {
+    int width;
+    int height;
+    int spectrum;
+    int depth;
+};
+
+}
+
 void gmic_qt_get_layers_extent(int *width, int *height, GmicQt::InputMode mode)
 {
     *width = 0;
     *height = 0;
+
+    KritaConnection *connection = KritaConnection::instance();
+    if (connection->isOpen()) {
+        QByteArray payload;
+        QByteArray answer;
+        QDataStream request(&payload, QIODevice::WriteOnly);
+        setupStream(request) << qint32(mode);
+        if (connection->request(GetImageSize, payload, answer)) {
+            QDataStream ds(answer);
+            qint32 w = 0;
+            qint32 h = 0;
+            setupStream(ds) >> w >> h;
+            if (ds.status() == QDataStream::Ok) {
+                *width = w;
+                *height = h;
+            }
+            if (connection->version() >= 2) {
+                qint32 depth = 0;
+                ds >> depth;
+                if (ds.status() == QDataStream::Ok) {
+                    connection->setDocumentDepth(depth);
+                }
+            }
+            return;
+        }
+    }
+
     QByteArray command = QString("command=gmic_qt_get_image_size\nmode=%1").arg((int)mode).toUtf8();
 
     QString answer = QString::fromUtf8(sendMessageSynchronously(command));
@@ -151,40 +599,89 @@ void gmic_qt_get_cropped_images(gmic_list<float> & images,
       height = 1.0;
     }
 
-    // Create a message for Krita
-    QString message = QString("command=gmic_qt_get_cropped_images\nmode=%5\ncroprect=%1,%2,%3,%4").arg(x).arg(y).arg(width).arg(height).arg(mode);
-    QByteArray command = message.toUtf8();
-    QString answer = QString::fromUtf8(sendMessageSynchronously(command));
-
-    if (answer.isEmpty()) {
-        qWarning() << "\tgmic-qt: empty answer!";
-        return;
+    QStringList memoryKeys;
+    QList<SharedImageFormat> formats;
+    KritaConnection *connection = KritaConnection::instance();
+    bool done = false;
+    if (connection->isOpen()) {
+        QByteArray payload;
+        QByteArray answer;
+        QDataStream request(&payload, QIODevice::WriteOnly);
+        setupStream(request) << qint32(mode) << x << y << width << height;
+        if (connection->version() >= 2) {
+            // Preview crops end up displayed with 8 bits per channel
+            const bool preview = !entireImage;
+            const int depth = (preview && connection->documentDepth() == Depth16) ? Depth8 : DepthNative;
+            request << qint32(depth);
+        }
+        if (connection->request(GetCroppedImages, payload, answer)) {
+            QDataStream ds(answer);
+            setupStream(ds);
+            quint32 count = 0;
+            ds >> count;
+            images.assign(count);
+            imageNames.assign(count);
+            for (quint32 i = 0; i < count && ds.status() == QDataStream::Ok; ++i) {
+                QString key;
+                QByteArray name;
+                qint32 w = 0;
+                qint32 h = 0;
+                qint32 spectrum = 4;
+                qint32 depth = DepthFloat;
+                ds >> key >> name >> w >> h;
+                if (connection->version() >= 2) {
+                    ds >> spectrum >> depth;
+                }
+                memoryKeys << key;
+                gmic_image<char>::string(name.constData()).move_to(imageNames[i]);
+                SharedImageFormat format = { w, h, spectrum, depth };
+                formats << format;
+            }
+            if (ds.status() != QDataStream::Ok) {
+                qWarning() << "\tgmic-qt: Got the wrong answer!";
+                images.assign();
+                imageNames.assign();
+                return;
+            }
+            done = true;
+        }
     }
 
-    //qDebug() << "\tgmic-qt: " << answer;
+    if (!done) {
+        // Create a message for Krita
+        QString message = QString("command=gmic_qt_get_cropped_images\nmode=%5\ncroprect=%1,%2,%3,%4").arg(x).arg(y).arg(width).arg(height).arg(mode);
+        QByteArray command = message.toUtf8();
+        QString answer = QString::fromUtf8(sendMessageSynchronously(command));
 
-    QStringList imagesList = answer.split("\n", QString::SkipEmptyParts);
+        if (answer.isEmpty()) {
+            qWarning() << "\tgmic-qt: empty answer!";
+            return;
+        }
 
-    images.assign(imagesList.size());
-    imageNames.assign(imagesList.size());
+        //qDebug() << "\tgmic-qt: " << answer;
 
-    //qDebug() << "\tgmic-qt: imagelist size" << imagesList.size();
+        QStringList imagesList = answer.split("\n", QString::SkipEmptyParts);
 
-    // Parse the answer -- there should be no new lines in layernames
-    QStringList memoryKeys;
-    QList<QSize> sizes;
-    // Get the keys for the shared memory areas and the imageNames as prepared by Krita in G'Mic format
-    for (int i = 0; i < imagesList.length(); ++i) {
-        const QString &layer = imagesList[i];
-        QStringList parts = layer.split(',', QString::SkipEmptyParts);
-        if (parts.size() != 4) {
-            qWarning() << "\tgmic-qt: Got the wrong answer!";
+        images.assign(imagesList.size());
+        imageNames.assign(imagesList.size());
+
+        //qDebug() << "\tgmic-qt: imagelist size" << imagesList.size();
+
+        // Parse the answer -- there should be no new lines in layernames
+        // Get the keys for the shared memory areas and the imageNames as prepared by Krita in G'Mic format
+        for (int i = 0; i < imagesList.length(); ++i) {
+            const QString &layer = imagesList[i];
+            QStringList parts = layer.split(',', QString::SkipEmptyParts);
+            if (parts.size() != 4) {
+                qWarning() << "\tgmic-qt: Got the wrong answer!";
+            }
+            memoryKeys << parts[0];
+            QByteArray ba = parts[1].toLatin1();
+            ba = QByteArray::fromHex(ba);
+            gmic_image<char>::string(ba.constData()).move_to(imageNames[i]);
+            SharedImageFormat format = { parts[2].toInt(), parts[3].toInt(), 4, DepthFloat };
+            formats << format;
         }
-        memoryKeys << parts[0];
-        QByteArray ba = parts[1].toLatin1();
-        ba = QByteArray::fromHex(ba);
-        gmic_image<char>::string(ba.constData()).move_to(imageNames[i]);
-        sizes << QSize(parts[2].toInt(), parts[3].toInt());
     }
 
     //qDebug() << "\tgmic-qt: keys" << memoryKeys;
@@ -204,10 +701,14 @@ void gmic_qt_get_cropped_images(gmic_list<float> & images,
             //qDebug() << "Memory segment" << key << m.size() << m.constData() << m.data();
 
             // convert the data to the list of float
-            gmic_image<float> gimg;
-            gimg.assign(sizes[i].width(), sizes[i].height(), 1, 4);
-            memcpy(gimg._data, m.constData(), sizes[i].width() * sizes[i].height() * 4 * sizeof(float));
-            gimg.move_to(images[i]);
+            const SharedImageFormat &format = formats[i];
+            const qint64 count = static_cast<qint64>(format.width) * format.height * format.spectrum;
+            if (count * bytesPerSample(format.depth) <= m.size()) {
+                images[i].assign(format.width, format.height, 1, format.spectrum);
+                readSamples(m.constData(), format.depth, images[i]._data, count);
+            } else {
+                qWarning() << "\tgmic-qt: Shared memory segment is too small" << key;
+            }
 
             if (!m.unlock()) {
                 qWarning() << "\tgmic-qt: Could not unlock memeory segment"  << m.error() << m.errorString();
@@ -221,11 +722,37 @@ void gmic_qt_get_cropped_images(gmic_list<float> & images,
         }
     }
 
-    sendMessageSynchronously("command=gmic_qt_detach");
+    // The answer is not needed, the next request does not wait for it
+    if (!connection->post(Detach, QByteArray(), true)) {
+        sendMessageSynchronously("command=gmic_qt_detach");
+    }
 
     //qDebug() << "\tgmic-qt:  Images size" << images.size() << ", names size" << imageNames.size();
 }
 
+static bool storeOutputImages(const gmic_list<float> &images, int depth, QStringList &keys)
+{
+    keys.clear();
+    for (uint i = 0; i < images.size(); ++i) {
+
+        //qDebug() << "\tgmic-qt: image number" << i;
+
+        const gmic_image<float> &gimg = images[i];
+        const qint64 count = static_cast<qint64>(gimg._width) * gimg._height * gimg._spectrum;
+
+        QSharedMemory *m = sharedMemoryPool.acquire(count * bytesPerSample(depth));
+        if (!m) {
+            return false;
+        }
+
+        m->lock();
+        writeSamples(gimg._data, count, depth, m->data());
+        m->unlock();
+        keys << m->key();
+    }
+    return true;
+}
+
 void gmic_qt_output_images( gmic_list<float> & images,
                             const gmic_list<char> & imageNames,
                             GmicQt::OutputMode mode,
@@ -234,41 +761,44 @@ void gmic_qt_output_images( gmic_list<float> & images,
 
     //qDebug() << "qmic-qt-output-images";
 
-    Q_FOREACH(QSharedMemory *sharedMemory, sharedMemorySegments) {
-        if (sharedMemory->isAttached()) {
-            sharedMemory->detach();
-        }
+    sharedMemoryPool.recycle();
+
+    // Fill qsharedmemory segments with each image, at the depth of the document if Krita accepts it
+    KritaConnection *connection = KritaConnection::instance();
+    const int depth = (connection->version() >= 2) ? connection->documentDepth() : DepthFloat;
+    QStringList keys;
+    if (!storeOutputImages(images, depth, keys)) {
+        return;
     }
-    qDeleteAll(sharedMemorySegments);
-    sharedMemorySegments.clear();
 
-    //qDebug() << "\tqmic-qt: shared memory" << sharedMemorySegments.count();
+    if (connection->isOpen()) {
+        QByteArray payload;
+        QByteArray answer;
+        QDataStream request(&payload, QIODevice::WriteOnly);
+        setupStream(request) << qint32(mode) << quint32(images.size());
+        for (uint i = 0; i < images.size(); ++i) {
+            const gmic_image<float> &gimg = images[i];
+            request << keys[i] << QString((const char *const)imageNames[i]).toUtf8()
+                    << qint32(gimg._spectrum) << qint32(gimg._width) << qint32(gimg._height);
+            if (connection->version() >= 2) {
+                request << qint32(depth);
+            }
+        }
+        if (connection->request(OutputImages, payload, answer)) {
+            return;
+        }
+        // The text protocol only knows about float samples
+        if (depth != DepthFloat && !storeOutputImages(images, DepthFloat, keys)) {
+            return;
+        }
+    }
 
-    // Create qsharedmemory segments for each image
     // Create a message for Krita based on mode, the keys of the qsharedmemory segments and the imageNames
     QString message = QString("command=gmic_qt_output_images\nmode=%1\n").arg(mode);
-
     for (uint i = 0; i < images.size(); ++i) {
-
-        //qDebug() << "\tgmic-qt: image number" << i;
-
-        gmic_image<float> gimg = images.at(i);
-
-        QSharedMemory *m = new QSharedMemory(QString("key_%1").arg(QUuid::createUuid().toString()));
-        sharedMemorySegments.append(m);
-
-        if (!m->create(gimg._width * gimg._height * gimg._spectrum * sizeof(float))) {
-            qWarning() << "Could not create shared memory" << m->error() << m->errorString();
-            return;
-        }
-
-        m->lock();
-        memcpy(m->data(), gimg._data, m->size());
-        m->unlock();
-
+        const gmic_image<float> &gimg = images[i];
         QString layerName((const char *const)imageNames[i]);
-
-        message += "layer=" + m->key() + ","
+        message += "layer=" + keys[i] + ","
                 + layerName.toUtf8().toHex() + ","
                 + QString("%1,%2,%3").arg(gimg._spectrum).arg(gimg._width).arg(gimg._height)
                 + + "\n";
@@ -296,8 +826,11 @@ int main(int argc, char *argv[])
         parser.setApplicationDescription("Krita G'Mic Plugin");
         parser.addHelpOption();
         parser.addPositionalArgument("socket key", "Key to find Krita's local server socket");
+        QCommandLineOption protocolOption("protocol", "Highest binary protocol version supported by Krita", "version", "0");
+        parser.addOption(protocolOption);
         QCoreApplication app(argc, argv);
         parser.process(app);
+        kritaProtocol = parser.value(protocolOption).toInt();
         const QStringList args = parser.positionalArguments();
         if (args.size() > 0) {
             socketKey = args[0];
@@ -318,14 +851,8 @@ int main(int argc, char *argv[])
         r = launchPlugin();
     }
 
-    Q_FOREACH(QSharedMemory *sharedMemory, sharedMemorySegments) {
-        if (sharedMemory->isAttached()) {
-            sharedMemory->detach();
-        }
-    }
-
-    qDeleteAll(sharedMemorySegments);
-    sharedMemorySegments.clear();
+    KritaConnection::release();
+    sharedMemoryPool.clear();
 
     return r;
 }
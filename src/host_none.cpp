@@ -30,12 +30,14 @@
 #include <QDesktopWidget>
 #include <QRegularExpression>
 #include <algorithm>
+#include <cstring>
 #include <iostream>
 #include "host.h"
 #include "gmic_qt.h"
 #include "Common.h"
 #include "ImageConverter.h"
 #include "standalone/ImageDialog.h"
+#include "standalone/BatchProcessor.h"
 #include "gmic.h"
 
 #ifdef _GMIC_QT_DEBUG_
@@ -144,6 +146,14 @@ void gmic_qt_show_message(const char * message)
 int main(int argc, char * argv[])
 {
   QString filename;
+  if ( argc == 2 && !strcmp(argv[1],"--server") ) {
+    return launchPluginServer();
+  }
+  for ( int arg = 1; arg < argc; ++arg ) {
+    if ( !strcmp(argv[arg],"--batch") ) {
+      return BatchProcessor::launch(argc,argv);
+    }
+  }
   if ( argc == 2 ) {
     filename = argv[1];
   }
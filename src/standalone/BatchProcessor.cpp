@@ -0,0 +1,564 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file BatchProcessor.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "standalone/BatchProcessor.h"
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QCommandLineOption>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QImage>
+#include <QImageReader>
+#include <QImageWriter>
+#include <QMutexLocker>
+#include <QScopedPointer>
+#include <QStandardItemModel>
+#include <QThread>
+#include <QThreadStorage>
+#include <QDebug>
+#include <algorithm>
+#include <iostream>
+#include "Common.h"
+#include "Updater.h"
+#include "GmicStdlibParser.h"
+#include "FilterThread.h"
+#include "FilterParamsWidget.h"
+#include "FiltersTreeAbstractFilterItem.h"
+#include "FiltersTreeFilterItem.h"
+#include "FiltersTreeFaveItem.h"
+#include "ImageConverter.h"
+#include "InterpreterState.h"
+#include "ParametersCache.h"
+#include "StoredFave.h"
+#include "standalone/BoundedQueue.h"
+#include "gmic.h"
+
+struct BatchItem {
+  int index;
+  QImage image;
+  gmic_list<float> images;
+  gmic_list<char> imageNames;
+  qint64 pixels;
+  qint64 time[BatchProcessor::StageCount];
+  QString outputFilename;
+  QString errorMessage;
+};
+
+namespace {
+
+// One interpreter per worker thread, so that the stdlib is parsed once per thread
+struct ThreadInterpreter {
+  ThreadInterpreter()
+    : interpreter(0,GmicStdLibParser::GmicStdlib.constData(),true)
+  {
+    interpreter.set_variable("_host",GmicQt::HostApplicationShortname,'=');
+    state.save(interpreter);
+  }
+  gmic interpreter;
+  InterpreterState state;
+};
+QThreadStorage<ThreadInterpreter*> Interpreters;
+
+typedef BoundedQueue<BatchItem*> BatchQueue;
+
+class StageThread : public QThread {
+public:
+  StageThread(BatchProcessor * processor, BatchProcessor::Stage stage, BatchQueue * input, BatchQueue * output)
+    : _processor(processor), _stage(stage), _input(input), _output(output) { }
+  void run() override
+  {
+    BatchItem * item;
+    while ( _input->pop(item) ) {
+      _processor->process(_stage,item);
+      if ( _output ) {
+        _output->push(item);
+      } else {
+        _processor->finish(item);
+      }
+    }
+  }
+private:
+  BatchProcessor * _processor;
+  BatchProcessor::Stage _stage;
+  BatchQueue * _input;
+  BatchQueue * _output;
+};
+
+FiltersTreeAbstractFilterItem * findFilterItem(QStandardItem * folder, const QString & key)
+{
+  const int rows = folder->rowCount();
+  for ( int row = 0; row < rows; ++row ) {
+    QStandardItem * child = folder->child(row);
+    FiltersTreeAbstractFilterItem * filter = FiltersTreeAbstractItem::toAbstractFilter(child);
+    if ( filter ) {
+      if ( filter->hash() == key
+           || filter->command() == key
+           || !filter->plainText().compare(key,Qt::CaseInsensitive) ) {
+        return filter;
+      }
+    } else if ( (filter = findFilterItem(child,key)) ) {
+      return filter;
+    }
+  }
+  return 0;
+}
+
+}
+
+BatchProcessor::BatchProcessor(QObject * parent)
+  : QObject(parent),
+    _jobs(std::max(1,QThread::idealThreadCount())),
+    _failures(0),
+    _pixels(0)
+{
+  for ( int stage = 0; stage < StageCount; ++stage ) {
+    _busyTime[stage] = 0;
+  }
+  _environment = QString("_input_layers=%1 _output_mode=%2 _output_messages=%3 _preview_mode=%4")
+      .arg(GmicQt::Active)
+      .arg(GmicQt::InPlace)
+      .arg(GmicQt::Quiet)
+      .arg(GmicQt::FirstOutput);
+}
+
+BatchProcessor::~BatchProcessor()
+{
+}
+
+int BatchProcessor::launch(int argc, char * argv[])
+{
+  // Nothing is ever shown, no display is required
+  if ( qgetenv("QT_QPA_PLATFORM").isEmpty() ) {
+    qputenv("QT_QPA_PLATFORM","offscreen");
+  }
+  QApplication app(argc,argv);
+  QCoreApplication::setOrganizationName(GMIC_QT_ORGANISATION_NAME);
+  QCoreApplication::setOrganizationDomain(GMIC_QT_ORGANISATION_DOMAIN);
+  QCoreApplication::setApplicationName(GMIC_QT_APPLICATION_NAME);
+  Updater::setInstanceParent(&app);
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("G'MIC-Qt batch processing");
+  parser.addHelpOption();
+  QCommandLineOption batchOption("batch","Process image files without user interaction.");
+  QCommandLineOption filterOption(QStringList() << "f" << "filter",
+                                  "Filter or fave to apply, given its name, its command or its hash.\n"
+                                  "May be repeated to chain several filters.","filter");
+  QCommandLineOption commandOption(QStringList() << "c" << "command",
+                                   "Raw G'MIC command to apply instead of a filter.","command");
+  QCommandLineOption argumentsOption(QStringList() << "a" << "arguments",
+                                     "Filter arguments (default: last used values).","arguments");
+  QCommandLineOption outputOption(QStringList() << "o" << "output",
+                                  "Output directory.","directory");
+  QCommandLineOption jobsOption(QStringList() << "j" << "jobs",
+                                "Number of files processed in parallel.","count",
+                                QString::number(std::max(1,QThread::idealThreadCount())));
+  parser.addOption(batchOption);
+  parser.addOption(filterOption);
+  parser.addOption(commandOption);
+  parser.addOption(argumentsOption);
+  parser.addOption(outputOption);
+  parser.addOption(jobsOption);
+  parser.addPositionalArgument("inputs","Input files, directories or wildcard patterns.","<input>...");
+  parser.process(app);
+
+  if ( parser.isSet(filterOption) == parser.isSet(commandOption) ) {
+    std::cerr << "[gmic-qt] Error: exactly one of --filter or --command is required\n";
+    return 1;
+  }
+  if ( ! parser.isSet(outputOption) ) {
+    std::cerr << "[gmic-qt] Error: an output directory is required (--output)\n";
+    return 1;
+  }
+
+  BatchProcessor processor;
+  QString errorMessage;
+  const QStringList inputs = parser.positionalArguments();
+  for ( const QString & input : inputs ) {
+    if ( ! processor.addInput(input) ) {
+      std::cerr << "[gmic-qt] Warning: no image file matches " << input.toLocal8Bit().constData() << "\n";
+    }
+  }
+  if ( ! processor.fileCount() ) {
+    std::cerr << "[gmic-qt] Error: no input file\n";
+    return 1;
+  }
+  if ( ! processor.setOutputDirectory(parser.value(outputOption),errorMessage) ) {
+    std::cerr << "[gmic-qt] Error: " << errorMessage.toLocal8Bit().constData() << "\n";
+    return 1;
+  }
+  processor.setJobs(parser.value(jobsOption).toInt());
+
+  Updater::getInstance()->updateSources(false);
+  GmicStdLibParser::GmicStdlib = Updater::getInstance()->buildFullStdlib();
+  if ( parser.isSet(filterOption) ) {
+    // --arguments values are matched with --filter values, in order
+    const QStringList filters = parser.values(filterOption);
+    const QStringList arguments = parser.values(argumentsOption);
+    for ( int i = 0; i < filters.size(); ++i ) {
+      if ( ! processor.addFilter(filters[i],(i < arguments.size()) ? arguments[i] : QString(),errorMessage) ) {
+        std::cerr << "[gmic-qt] Error: " << errorMessage.toLocal8Bit().constData() << "\n";
+        return 1;
+      }
+    }
+  } else {
+    processor.setCommand(parser.value(commandOption));
+  }
+  return processor.run() ? 1 : 0;
+}
+
+bool BatchProcessor::addFilter(const QString & filter, const QString & arguments, QString & errorMessage)
+{
+  QStandardItemModel model;
+  GmicStdLibParser::buildFiltersTree(model.invisibleRootItem(),GmicStdLibParser::GmicStdlib,true);
+  FiltersTreeAbstractFilterItem * item = findFilterItem(model.invisibleRootItem(),filter);
+  QScopedPointer<FiltersTreeFaveItem> fave;
+  if ( ! item ) {
+    QList<StoredFave> faves = StoredFave::readFaves();
+    for ( StoredFave & storedFave : faves ) {
+      FiltersTreeFilterItem * original = FiltersTreeAbstractItem::findFilter(model.invisibleRootItem(),
+                                                                             storedFave.originalFilterHash());
+      if ( original ) {
+        fave.reset(new FiltersTreeFaveItem(original,storedFave.name(),storedFave.defaultParameters()));
+        if ( fave->hash() == filter || !fave->plainText().compare(filter,Qt::CaseInsensitive) ) {
+          item = fave.data();
+          break;
+        }
+      }
+    }
+  }
+  if ( ! item ) {
+    errorMessage = QString("Unknown filter or fave: %1").arg(filter);
+    return false;
+  }
+  if ( ! _command.isEmpty() ) {
+    _commandPrefix = (_commandPrefix.isEmpty() ? QString() : _commandPrefix + " ") + QString("-%1 %2").arg(_command).arg(_arguments);
+    _filterName += " > ";
+  }
+  _filterName += item->plainText();
+  _command = item->command();
+  if ( arguments.isNull() ) {
+    // Same values as the plugin would use (last used ones, or defaults)
+    ParametersCache::load(true);
+    FilterParamsWidget parameters;
+    parameters.build(item,QList<QString>());
+    _arguments = parameters.valueString();
+  } else {
+    _arguments = arguments;
+  }
+  return true;
+}
+
+void BatchProcessor::setCommand(const QString & command)
+{
+  _filterName = "Custom command";
+  _commandPrefix.clear();
+  _command = "skip 0";
+  _arguments = command;
+}
+
+int BatchProcessor::addInput(const QString & input)
+{
+  QFileInfo info(input);
+  if ( info.isFile() ) {
+    _files.push_back(info.absoluteFilePath());
+    return 1;
+  }
+  QDir dir;
+  QStringList nameFilters;
+  if ( info.isDir() ) {
+    dir = QDir(input);
+    const QList<QByteArray> formats = QImageReader::supportedImageFormats();
+    for ( const QByteArray & format : formats ) {
+      nameFilters.push_back(QString("*.%1").arg(QString::fromLatin1(format)));
+    }
+  } else {
+    dir = info.absoluteDir();
+    nameFilters.push_back(info.fileName());
+  }
+  QStringList entries = dir.entryList(nameFilters,QDir::Files|QDir::Readable,QDir::Name);
+  for ( const QString & entry : entries ) {
+    _files.push_back(dir.absoluteFilePath(entry));
+  }
+  return entries.size();
+}
+
+bool BatchProcessor::setOutputDirectory(const QString & path, QString & errorMessage)
+{
+  if ( ! QDir().mkpath(path) ) {
+    errorMessage = QString("Cannot create output directory %1").arg(path);
+    return false;
+  }
+  _outputDirectory = QDir(QDir(path).canonicalPath());
+  return true;
+}
+
+void BatchProcessor::setJobs(int jobs)
+{
+  _jobs = std::max(1,jobs);
+}
+
+int BatchProcessor::jobs() const
+{
+  return _jobs;
+}
+
+int BatchProcessor::fileCount() const
+{
+  return _files.size();
+}
+
+int BatchProcessor::run()
+{
+  _failures = 0;
+  _pixels = 0;
+  // Output names are reserved in input order, so that they do not depend on thread timing
+  _outputFiles.clear();
+  QStringList outputFilenames;
+  for ( const QString & file : _files ) {
+    outputFilenames.push_back(reserveOutputFilename(file));
+  }
+  for ( int stage = 0; stage < StageCount; ++stage ) {
+    _busyTime[stage] = 0;
+  }
+  report(QString("Applying %1 (%2) to %3 file(s) with %4 job(s)")
+         .arg(_filterName)
+         .arg(FilterThread::buildCommandLine(_command,_arguments,GmicQt::Quiet,_commandPrefix))
+         .arg(_files.size()).arg(_jobs));
+  QElapsedTimer timer;
+  timer.start();
+
+  // queues[stage] feeds the given stage. Their capacity bounds the number
+  // of images alive at once, whatever the number of input files.
+  QList<BatchQueue*> queues;
+  QList<QList<StageThread*>> threads;
+  for ( int stage = 0; stage < StageCount; ++stage ) {
+    queues.push_back(new BatchQueue(_jobs));
+  }
+  for ( int stage = 0; stage < StageCount; ++stage ) {
+    threads.push_back(QList<StageThread*>());
+    for ( int n = 0; n < stageThreadCount(static_cast<Stage>(stage)); ++n ) {
+      StageThread * thread = new StageThread(this,static_cast<Stage>(stage),
+                                             queues[stage],
+                                             (stage + 1 < StageCount) ? queues[stage + 1] : 0);
+      threads.back().push_back(thread);
+      thread->start();
+    }
+  }
+  for ( int index = 0; index < _files.size(); ++index ) {
+    BatchItem * item = new BatchItem;
+    item->index = index;
+    item->pixels = 0;
+    item->outputFilename = outputFilenames[index];
+    for ( int stage = 0; stage < StageCount; ++stage ) {
+      item->time[stage] = 0;
+    }
+    queues[Decode]->push(item);
+  }
+  // Drain the pipeline, stage after stage
+  for ( int stage = 0; stage < StageCount; ++stage ) {
+    queues[stage]->close();
+    for ( StageThread * thread : threads[stage] ) {
+      thread->wait();
+      delete thread;
+    }
+  }
+
+  const qint64 elapsed = std::max(qint64(1),timer.elapsed());
+  const double seconds = elapsed / 1000.0;
+  report(QString("%1 file(s) processed, %2 failure(s), in %3 s (%4 files/s, %5 Mpixels/s)")
+         .arg(_files.size() - _failures)
+         .arg(_failures)
+         .arg(seconds,0,'f',2)
+         .arg((_files.size() - _failures) / seconds,0,'f',2)
+         .arg(_pixels / (seconds * 1e6),0,'f',2));
+  for ( int stage = 0; stage < StageCount; ++stage ) {
+    const int count = stageThreadCount(static_cast<Stage>(stage));
+    report(QString("  %1: %2 thread(s), %3% busy, queue mean length %4/%5, producers blocked %6 ms")
+           .arg(QString(stageName(static_cast<Stage>(stage))),-8)
+           .arg(count)
+           .arg(100.0 * _busyTime[stage] / (count * elapsed),0,'f',1)
+           .arg(queues[stage]->meanSize(),0,'f',1)
+           .arg(queues[stage]->capacity())
+           .arg(queues[stage]->pushWaitTime()));
+  }
+  qDeleteAll(queues);
+  return _failures;
+}
+
+int BatchProcessor::stageThreadCount(Stage stage) const
+{
+  switch ( stage ) {
+  case Decode:
+  case Encode:
+    return std::max(1,_jobs / 2);
+  case Filter:
+    return _jobs;
+  default:
+    return 1;
+  }
+}
+
+const char * BatchProcessor::stageName(Stage stage)
+{
+  switch ( stage ) {
+  case Decode:
+    return "decode";
+  case Convert:
+    return "convert";
+  case Filter:
+    return "filter";
+  case Encode:
+    return "encode";
+  default:
+    return "?";
+  }
+}
+
+void BatchProcessor::process(Stage stage, BatchItem * item)
+{
+  if ( ! item->errorMessage.isEmpty() ) {
+    return;
+  }
+  QElapsedTimer timer;
+  timer.start();
+  const QString & filename = _files[item->index];
+  switch ( stage ) {
+  case Decode:
+    if ( ! item->image.load(filename) ) {
+      item->errorMessage = "cannot read file";
+    }
+    break;
+  case Convert:
+  {
+    item->images.assign(1);
+    item->imageNames.assign(1);
+    ImageConverter::convert(item->image.convertToFormat(QImage::Format_ARGB32),item->images[0]);
+    item->pixels = static_cast<qint64>(item->image.width()) * item->image.height();
+    item->image = QImage();
+    QByteArray name = QString("pos(0,0),name(%1)").arg(QFileInfo(filename).fileName()).toUtf8();
+    gmic_image<char>::string(name.constData()).move_to(item->imageNames[0]);
+  }
+    break;
+  case Filter:
+    try {
+      if ( ! Interpreters.hasLocalData() ) {
+        Interpreters.setLocalData(new ThreadInterpreter);
+      }
+      ThreadInterpreter * local = Interpreters.localData();
+      // Variables and verbosity set while processing previous files are dropped
+      local->state.restore(local->interpreter);
+      gmic * interpreter = &local->interpreter;
+      interpreter->run(QString("-v - %1").arg(_environment).toLocal8Bit().constData(),item->images,item->imageNames);
+      interpreter->run(FilterThread::buildCommandLine(_command,_arguments,GmicQt::Quiet,_commandPrefix).toLocal8Bit().constData(),
+                       item->images,item->imageNames);
+    } catch (gmic_exception & e) {
+      item->errorMessage = e.what();
+    }
+    break;
+  case Encode:
+    for ( unsigned int i = 0; i < item->images.size() && item->errorMessage.isEmpty(); ++i ) {
+      QImage output;
+      ImageConverter::convert(item->images[i],output);
+      const QString outputFile = outputFilename(item->outputFilename,i,item->images.size());
+      if ( ! output.save(outputFile) ) {
+        item->errorMessage = QString("cannot write %1").arg(outputFile);
+      }
+    }
+    item->images.assign();
+    item->imageNames.assign();
+    break;
+  default:
+    break;
+  }
+  item->time[stage] = timer.elapsed();
+  QMutexLocker locker(&_mutex);
+  _busyTime[stage] += item->time[stage];
+}
+
+void BatchProcessor::finish(BatchItem * item)
+{
+  const QString shortName = QFileInfo(_files[item->index]).fileName();
+  QMutexLocker locker(&_mutex);
+  if ( item->errorMessage.isEmpty() ) {
+    _pixels += item->pixels;
+    report(QString("%1: decode %2 ms, convert %3 ms, filter %4 ms, encode %5 ms")
+           .arg(shortName)
+           .arg(item->time[Decode])
+           .arg(item->time[Convert])
+           .arg(item->time[Filter])
+           .arg(item->time[Encode]));
+  } else {
+    ++_failures;
+    report(QString("%1: %2").arg(shortName).arg(item->errorMessage));
+  }
+  delete item;
+}
+
+QString BatchProcessor::reserveOutputFilename(const QString & inputFilename)
+{
+  QFileInfo info(inputFilename);
+  QString suffix = info.suffix().toLower();
+  if ( ! QImageWriter::supportedImageFormats().contains(suffix.toLatin1()) ) {
+    suffix = "png";
+  }
+  const QString baseName = info.completeBaseName();
+  // Inputs with the same base name (a.jpg and a.png, or files from several
+  // directories) must not overwrite each other, nor any existing file
+  // (input files included).
+  QString filename = _outputDirectory.absoluteFilePath(QString("%1.%2").arg(baseName).arg(suffix));
+  int n = 0;
+  while ( _outputFiles.contains(filename) || QFileInfo::exists(filename) ) {
+    filename = _outputDirectory.absoluteFilePath(QString("%1_%2.%3").arg(baseName).arg(++n).arg(suffix));
+  }
+  if ( n ) {
+    report(QString("%1: output written as %2").arg(info.fileName()).arg(QFileInfo(filename).fileName()));
+  }
+  _outputFiles.insert(filename);
+  return filename;
+}
+
+QString BatchProcessor::outputFilename(const QString & reservedFilename, int imageIndex, int imageCount)
+{
+  if ( imageCount == 1 ) {
+    return reservedFilename;
+  }
+  // All reserved names are known before encoding starts, so that these
+  // never take the name reserved for another input
+  QFileInfo info(reservedFilename);
+  const QString stem = info.dir().absoluteFilePath(info.completeBaseName());
+  QString filename = QString("%1_%2.%3").arg(stem).arg(imageIndex).arg(info.suffix());
+  QMutexLocker locker(&_mutex);
+  int n = 0;
+  while ( _outputFiles.contains(filename) || QFileInfo::exists(filename) ) {
+    filename = QString("%1_%2_%3.%4").arg(stem).arg(imageIndex).arg(++n).arg(info.suffix());
+  }
+  _outputFiles.insert(filename);
+  return filename;
+}
+
+void BatchProcessor::report(const QString & text)
+{
+  std::cout << "[gmic-qt] " << text.toLocal8Bit().constData() << std::endl;
+}
@@ -0,0 +1,200 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file CimgzDecoderTest.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtTest>
+#include "CimgzDecoder.h"
+#undef cimg_display
+#define cimg_display 0
+#include "CImg.h"
+
+using namespace cimg_library;
+
+/*
+ * Files are written with CImg's own writer, then decoded in memory and
+ * compared with what CImg<unsigned char>::load_cimg() reads from them.
+ */
+class CimgzDecoderTest : public QObject
+{
+  Q_OBJECT
+
+private slots:
+  void initTestCase();
+  void roundTrip_data();
+  void roundTrip();
+  void comments();
+  void unsupportedLayouts_data();
+  void unsupportedLayouts();
+  void corruptedData();
+
+private:
+  QString save(const CImgList<unsigned char> & list, bool compressed);
+  static QByteArray loadWithCImg(const QString & filename);
+  static QByteArray readFile(const QString & filename);
+  static CImgList<unsigned char> makeList(int count, int width, int height, int depth, int spectrum);
+  QTemporaryDir _dir;
+  int _fileCount;
+};
+
+void CimgzDecoderTest::initTestCase()
+{
+  QVERIFY(_dir.isValid());
+  _fileCount = 0;
+}
+
+QString CimgzDecoderTest::save(const CImgList<unsigned char> & list, bool compressed)
+{
+  const QString filename = _dir.path() + QString("/test%1.cimgz").arg(_fileCount++);
+  list.save_cimg(filename.toLocal8Bit().constData(),compressed);
+  return filename;
+}
+
+QByteArray CimgzDecoderTest::loadWithCImg(const QString & filename)
+{
+  CImg<unsigned char> image;
+  image.load_cimg(filename.toLocal8Bit().constData());
+  return QByteArray(reinterpret_cast<const char*>(image.data()),static_cast<int>(image.size()));
+}
+
+QByteArray CimgzDecoderTest::readFile(const QString & filename)
+{
+  QFile file(filename);
+  return file.open(QFile::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+CImgList<unsigned char> CimgzDecoderTest::makeList(int count, int width, int height, int depth, int spectrum)
+{
+  // Text-like content, as in the filter sources, with a few arbitrary bytes
+  static const char text[] = "#@gui Filter name : command, command_preview(0)\n#@gui : Amplitude = float(10,0,100)\n";
+  CImgList<unsigned char> list(count,width,height,depth,spectrum);
+  unsigned long n = 0;
+  cimglist_for(list,l) {
+    cimg_for(list[l],ptr,unsigned char) {
+      *ptr = (n % 97 == 96) ? static_cast<unsigned char>(n * 131) : static_cast<unsigned char>(text[n % (sizeof(text) - 1)]);
+      ++n;
+    }
+  }
+  return list;
+}
+
+void CimgzDecoderTest::roundTrip_data()
+{
+  QTest::addColumn<int>("count");
+  QTest::addColumn<int>("width");
+  QTest::addColumn<int>("height");
+  QTest::addColumn<int>("depth");
+  QTest::addColumn<int>("spectrum");
+  QTest::addColumn<bool>("compressed");
+  QTest::newRow("single compressed") << 1 << 4096 << 1 << 1 << 1 << true;
+  QTest::newRow("single raw") << 1 << 4096 << 1 << 1 << 1 << false;
+  QTest::newRow("single 2D color") << 1 << 17 << 13 << 1 << 3 << true;
+  QTest::newRow("single volume") << 1 << 8 << 5 << 3 << 2 << true;
+  QTest::newRow("list compressed") << 5 << 1000 << 1 << 1 << 1 << true;
+  QTest::newRow("list raw") << 3 << 1000 << 1 << 1 << 1 << false;
+  QTest::newRow("list of planes") << 4 << 9 << 7 << 2 << 1 << true;
+  QTest::newRow("large") << 1 << (1 << 22) << 1 << 1 << 1 << true;
+}
+
+void CimgzDecoderTest::roundTrip()
+{
+  QFETCH(int,count);
+  QFETCH(int,width);
+  QFETCH(int,height);
+  QFETCH(int,depth);
+  QFETCH(int,spectrum);
+  QFETCH(bool,compressed);
+  const QString filename = save(makeList(count,width,height,depth,spectrum),compressed);
+  const QByteArray data = readFile(filename);
+  bool supported = false;
+  const QByteArray decoded = CimgzDecoder::decode(data.constData(),data.size(),supported);
+  QVERIFY(supported);
+  QVERIFY(!decoded.isNull());
+  QCOMPARE(decoded,loadWithCImg(filename));
+}
+
+void CimgzDecoderTest::comments()
+{
+  const QString filename = save(makeList(2,100,1,1,1),true);
+  const QByteArray data = QByteArray("# First comment\n#\n") + readFile(filename);
+  QFile file(filename);
+  QVERIFY(file.open(QFile::WriteOnly));
+  file.write(data);
+  file.close();
+  bool supported = false;
+  const QByteArray decoded = CimgzDecoder::decode(data.constData(),data.size(),supported);
+  QVERIFY(supported);
+  QCOMPARE(decoded,loadWithCImg(filename));
+}
+
+void CimgzDecoderTest::unsupportedLayouts_data()
+{
+  QTest::addColumn<QByteArray>("data");
+  {
+    // Appending color images along z interleaves their channels
+    QByteArray data = readFile(save(makeList(2,10,10,1,3),true));
+    QTest::newRow("list of color images") << data;
+  }
+  {
+    // Appending images of different sizes along z pads them
+    CImgList<unsigned char> list = makeList(2,10,10,1,1);
+    list[1].resize(12,10,1,1,0);
+    QTest::newRow("list of different sizes") << readFile(save(list,true));
+  }
+  {
+    const QString filename = _dir.path() + "/float.cimgz";
+    CImg<float>(10,10,1,1,0.5f).save_cimg(filename.toLocal8Bit().constData(),true);
+    QTest::newRow("float") << readFile(filename);
+  }
+}
+
+void CimgzDecoderTest::unsupportedLayouts()
+{
+  QFETCH(QByteArray,data);
+  QVERIFY(!data.isEmpty());
+  bool supported = true;
+  const QByteArray decoded = CimgzDecoder::decode(data.constData(),data.size(),supported);
+  QVERIFY(!supported);
+  QVERIFY(decoded.isNull());
+}
+
+void CimgzDecoderTest::corruptedData()
+{
+  const QByteArray data = readFile(save(makeList(1,4096,1,1,1),true));
+  bool supported;
+  // Truncated
+  for ( int size = 0; size < data.size(); size += 7 ) {
+    QVERIFY(CimgzDecoder::decode(data.constData(),size,supported).isNull());
+  }
+  // Damaged compressed stream
+  QByteArray damaged = data;
+  for ( int i = damaged.indexOf('\n',damaged.indexOf('\n') + 1) + 1; i < damaged.size(); i += 5 ) {
+    damaged[i] = static_cast<char>(damaged[i] ^ 0x5a);
+  }
+  QVERIFY(CimgzDecoder::decode(damaged.constData(),damaged.size(),supported).isNull());
+  QVERIFY(supported);
+}
+
+QTEST_APPLESS_MAIN(CimgzDecoderTest)
+#include "CimgzDecoderTest.moc"
@@ -0,0 +1,134 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file FilterParamsWidgetTest.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <QCoreApplication>
+#include <QSettings>
+#include <QStandardItem>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <QVector>
+#include <QtTest>
+#include "FilterParamsWidget.h"
+#include "FiltersTreeAbstractFilterItem.h"
+#include "FiltersTreeBuilder.h"
+#include "gmic.h"
+
+/*
+ * Selecting the filters of the whole stdlib one after the other in the
+ * parameters widget, as done when browsing the filters tree.
+ */
+class FilterParamsWidgetTest : public QObject
+{
+  Q_OBJECT
+
+private slots:
+  void initTestCase();
+  void cleanupTestCase();
+  void values();
+  void benchmarkSwitching();
+
+private:
+  void collectFilters(QStandardItem * folder);
+  QTemporaryDir _dir;
+  QStandardItem * _root;
+  QVector<const FiltersTreeAbstractFilterItem*> _filters;
+};
+
+void FilterParamsWidgetTest::initTestCase()
+{
+  // Saved parameters are looked up in the user catalog (under GMIC_PATH)
+  QVERIFY(_dir.isValid());
+  qputenv("GMIC_PATH",QFile::encodeName(_dir.path() + "/"));
+  QCoreApplication::setOrganizationName("gmic_qt_tests");
+  QCoreApplication::setApplicationName("FilterParamsWidgetTest");
+  QSettings::setDefaultFormat(QSettings::IniFormat);
+  QSettings::setPath(QSettings::IniFormat,QSettings::UserScope,_dir.path());
+
+  const gmic_image<char> stdlib = gmic::decompress_stdlib();
+  QByteArray data(stdlib.data(),static_cast<int>(stdlib.size()) - 1);
+  data.append('\n');
+  FiltersTreeBuilder builder(0,data,false);
+  builder.build();
+  _root = builder.takeRoot();
+  collectFilters(_root);
+  QVERIFY(_filters.size() > 100);
+}
+
+void FilterParamsWidgetTest::cleanupTestCase()
+{
+  _filters.clear();
+  delete _root;
+}
+
+void FilterParamsWidgetTest::collectFilters(QStandardItem * folder)
+{
+  for ( int row = 0; row < folder->rowCount(); ++row ) {
+    QStandardItem * item = folder->child(row);
+    if ( FiltersTreeAbstractItem::isFolder(item) ) {
+      collectFilters(item);
+    } else if ( FiltersTreeAbstractFilterItem * filter = FiltersTreeAbstractItem::toAbstractFilter(item) ) {
+      _filters.push_back(filter);
+    }
+  }
+}
+
+void FilterParamsWidgetTest::values()
+{
+  // Values survive switching to every other filter and back
+  FilterParamsWidget widget;
+  const FiltersTreeAbstractFilterItem * filter = 0;
+  for ( int i = 0; i < _filters.size() && !filter; ++i ) {
+    widget.build(_filters[i],QList<QString>());
+    if ( widget.actualParametersCount() > 1 ) {
+      filter = _filters[i];
+    }
+  }
+  QVERIFY(filter);
+  const QStringList defaults = widget.valueStringList();
+  QCOMPARE(defaults.size(),widget.actualParametersCount());
+  const QString valueString = widget.valueString();
+  QCOMPARE(widget.filterHash(),filter->hash());
+  for ( int i = 0; i < _filters.size(); ++i ) {
+    widget.build(_filters[i],QList<QString>());
+    QCOMPARE(widget.valueStringList().size(),widget.actualParametersCount());
+  }
+  widget.build(filter,defaults);
+  QCOMPARE(widget.valueStringList(),defaults);
+  QCOMPARE(widget.valueString(),valueString);
+}
+
+void FilterParamsWidgetTest::benchmarkSwitching()
+{
+  FilterParamsWidget widget;
+  widget.resize(400,600);
+  widget.show();
+  QBENCHMARK {
+    for ( int i = 0; i < _filters.size(); ++i ) {
+      widget.build(_filters[i],QList<QString>());
+    }
+  }
+}
+
+QTEST_MAIN(FilterParamsWidgetTest)
+#include "FilterParamsWidgetTest.moc"
@@ -0,0 +1,163 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file FiltersSearchIndexTest.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <QCoreApplication>
+#include <QSettings>
+#include <QStandardItem>
+#include <QTemporaryDir>
+#include <QtTest>
+#include "FiltersSearchIndex.h"
+#include "FiltersTreeAbstractFilterItem.h"
+#include "FiltersTreeBuilder.h"
+#include "gmic.h"
+
+/*
+ * Search in the filters of the whole stdlib: typos, usage ranking,
+ * and the time taken by each keystroke typed in the search field.
+ */
+class FiltersSearchIndexTest : public QObject
+{
+  Q_OBJECT
+
+private slots:
+  void initTestCase();
+  void cleanupTestCase();
+  void typos_data();
+  void typos();
+  void usage();
+  void benchmarkBuild();
+  void benchmarkTyping_data();
+  void benchmarkTyping();
+
+private:
+  int rank(const QString & query, const QString & hash);
+  QTemporaryDir _dir;
+  QStandardItem * _root;
+  FiltersSearchIndex _index;
+};
+
+void FiltersSearchIndexTest::initTestCase()
+{
+  // Usage is kept in the settings
+  QVERIFY(_dir.isValid());
+  QCoreApplication::setOrganizationName("gmic_qt_tests");
+  QCoreApplication::setApplicationName("FiltersSearchIndexTest");
+  QSettings::setDefaultFormat(QSettings::IniFormat);
+  QSettings::setPath(QSettings::IniFormat,QSettings::UserScope,_dir.path());
+
+  const gmic_image<char> stdlib = gmic::decompress_stdlib();
+  QByteArray data(stdlib.data(),static_cast<int>(stdlib.size()) - 1);
+  data.append('\n');
+  FiltersTreeBuilder builder(0,data,false);
+  builder.build();
+  _root = builder.takeRoot();
+  _index.build(_root);
+  QVERIFY(_index.size() > 100);
+}
+
+void FiltersSearchIndexTest::cleanupTestCase()
+{
+  _index.clear();
+  delete _root;
+}
+
+int FiltersSearchIndexTest::rank(const QString & query, const QString & hash)
+{
+  const QVector<FiltersTreeAbstractFilterItem*> & result = _index.search(query);
+  for ( int i = 0; i < result.size(); ++i ) {
+    if ( result[i]->hash() == hash ) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+void FiltersSearchIndexTest::typos_data()
+{
+  QTest::addColumn<QString>("query");
+  QTest::addColumn<QString>("expected");
+  QTest::newRow("word") << "blur" << "blur";
+  QTest::newRow("prefix") << "sharpe" << "sharp";
+  QTest::newRow("extra letter") << "blurr" << "blur";
+  QTest::newRow("missing letter") << "sharpn" << "sharp";
+}
+
+void FiltersSearchIndexTest::typos()
+{
+  QFETCH(QString,query);
+  QFETCH(QString,expected);
+  const QVector<FiltersTreeAbstractFilterItem*> & result = _index.search(query);
+  QVERIFY(!result.isEmpty());
+  // Matches in names rank first
+  QVERIFY2(FiltersSearchIndex::normalize(result.first()->plainText()).contains(expected),
+           qPrintable(result.first()->plainText()));
+}
+
+void FiltersSearchIndexTest::usage()
+{
+  const QVector<FiltersTreeAbstractFilterItem*> result = _index.search("blur");
+  QVERIFY(result.size() > 2);
+  const QString hash = result.last()->hash();
+  const int before = rank("blur",hash);
+  for ( int i = 0; i < 10; ++i ) {
+    _index.recordUsage(hash);
+  }
+  const int after = rank("blur",hash);
+  QVERIFY(after >= 0);
+  QVERIFY(after < before);
+}
+
+void FiltersSearchIndexTest::benchmarkBuild()
+{
+  FiltersSearchIndex index;
+  QBENCHMARK {
+    index.build(_root);
+  }
+}
+
+void FiltersSearchIndexTest::benchmarkTyping_data()
+{
+  QTest::addColumn<QString>("query");
+  QTest::newRow("words") << "gaussian blur";
+  QTest::newRow("typo") << "sharpn";
+  QTest::newRow("typos") << "colr curvs";
+  QTest::newRow("no match") << "zzzzzz";
+}
+
+void FiltersSearchIndexTest::benchmarkTyping()
+{
+  // Every prefix of the query, as typed in the search field, on an
+  // index whose caches are empty
+  QFETCH(QString,query);
+  FiltersSearchIndex index;
+  index.build(_root);
+  QBENCHMARK_ONCE {
+    for ( int length = 1; length <= query.length(); ++length ) {
+      index.search(query.left(length));
+    }
+  }
+}
+
+QTEST_MAIN(FiltersSearchIndexTest)
+#include "FiltersSearchIndexTest.moc"
@@ -0,0 +1,136 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file FiltersTreeItemDelegateTest.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <QImage>
+#include <QPainter>
+#include <QScrollBar>
+#include <QStandardItemModel>
+#include <QStyledItemDelegate>
+#include <QTextDocument>
+#include <QTreeView>
+#include <QtTest>
+#include "FiltersTreeBuilder.h"
+#include "FiltersTreeItemDelegate.h"
+#include "gmic.h"
+
+/*
+ * Scrolling through the whole filters tree in a (headless) view, with the
+ * delegate of the plugin and with one that lays out the text of an item
+ * each time it is painted, as it was done before.
+ */
+class DocumentPerPaintDelegate : public QStyledItemDelegate
+{
+public:
+  DocumentPerPaintDelegate(QObject * parent) : QStyledItemDelegate(parent) { }
+
+protected:
+  void paint(QPainter * painter, const QStyleOptionViewItem & option, const QModelIndex & index) const
+  {
+    QStyleOptionViewItem options = option;
+    initStyleOption(&options,index);
+    painter->save();
+    QTextDocument doc;
+    doc.setHtml(options.text);
+    options.text = "";
+    options.widget->style()->drawControl(QStyle::CE_ItemViewItem,&options,painter);
+    painter->translate(options.rect.left(),options.rect.top());
+    doc.drawContents(painter,QRect(0,0,options.rect.width(),options.rect.height()));
+    painter->restore();
+  }
+
+  QSize sizeHint(const QStyleOptionViewItem & option, const QModelIndex & index) const
+  {
+    QStyleOptionViewItem options = option;
+    initStyleOption(&options,index);
+    QTextDocument doc;
+    doc.setHtml(options.text);
+    doc.setTextWidth(options.rect.width());
+    return QSize(doc.idealWidth(),doc.size().height());
+  }
+};
+
+class FiltersTreeItemDelegateTest : public QObject
+{
+  Q_OBJECT
+
+private slots:
+  void initTestCase();
+  void benchmarkScrolling_data();
+  void benchmarkScrolling();
+
+private:
+  QStandardItemModel _model;
+};
+
+void FiltersTreeItemDelegateTest::initTestCase()
+{
+  const gmic_image<char> stdlib = gmic::decompress_stdlib();
+  QByteArray data(stdlib.data(),static_cast<int>(stdlib.size()) - 1);
+  data.append('\n');
+  FiltersTreeBuilder builder(0,data,false);
+  builder.build();
+  QStandardItem * root = builder.takeRoot();
+  QStandardItem * modelRoot = _model.invisibleRootItem();
+  while ( root->rowCount() ) {
+    modelRoot->appendRow(root->takeRow(0));
+  }
+  delete root;
+  QVERIFY(_model.rowCount() > 0);
+}
+
+void FiltersTreeItemDelegateTest::benchmarkScrolling_data()
+{
+  QTest::addColumn<bool>("cached");
+  QTest::newRow("FiltersTreeItemDelegate") << true;
+  QTest::newRow("document per paint") << false;
+}
+
+void FiltersTreeItemDelegateTest::benchmarkScrolling()
+{
+  QFETCH(bool,cached);
+  QTreeView view;
+  if ( cached ) {
+    view.setItemDelegate(new FiltersTreeItemDelegate(&view));
+  } else {
+    view.setItemDelegate(new DocumentPerPaintDelegate(&view));
+  }
+  view.setModel(&_model);
+  view.resize(400,600);
+  view.expandAll();
+  view.show();
+  QVERIFY(QTest::qWaitForWindowExposed(&view));
+  QScrollBar * bar = view.verticalScrollBar();
+  QVERIFY(bar->maximum() > 0);
+  QImage image(view.viewport()->size(),QImage::Format_ARGB32);
+  QBENCHMARK {
+    // From top to bottom, one page at a time
+    for ( int value = bar->minimum(); value <= bar->maximum(); value += bar->pageStep() ) {
+      bar->setValue(value);
+      view.viewport()->render(&image);
+    }
+  }
+}
+
+QTEST_MAIN(FiltersTreeItemDelegateTest)
+#include "FiltersTreeItemDelegateTest.moc"
@@ -0,0 +1,105 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file GmicStdlibParserTest.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <QStandardItem>
+#include <QtTest>
+#include "FiltersTreeAbstractFilterItem.h"
+#include "FiltersTreeBuilder.h"
+#include "gmic.h"
+
+/*
+ * Building the filters tree from the whole stdlib, as done at startup
+ * and whenever the selection mode is toggled.
+ */
+class GmicStdlibParserTest : public QObject
+{
+  Q_OBJECT
+
+private slots:
+  void initTestCase();
+  void filtersTree();
+  void benchmarkFiltersTree_data();
+  void benchmarkFiltersTree();
+
+private:
+  static void checkFilters(QStandardItem * folder, int & count);
+  QByteArray _stdlib;
+};
+
+void GmicStdlibParserTest::initTestCase()
+{
+  const gmic_image<char> stdlib = gmic::decompress_stdlib();
+  QVERIFY(stdlib.size() > 1);
+  _stdlib = QByteArray(stdlib.data(),static_cast<int>(stdlib.size()) - 1);
+  _stdlib.append('\n');
+}
+
+void GmicStdlibParserTest::checkFilters(QStandardItem * folder, int & count)
+{
+  for ( int row = 0; row < folder->rowCount(); ++row ) {
+    QStandardItem * item = folder->child(row);
+    if ( FiltersTreeAbstractItem::isFolder(item) ) {
+      QVERIFY(item->rowCount() > 0);
+      checkFilters(item,count);
+    } else {
+      FiltersTreeAbstractFilterItem * filter = FiltersTreeAbstractItem::toAbstractFilter(item);
+      QVERIFY(filter);
+      QVERIFY(!filter->plainText().isEmpty());
+      QVERIFY(!filter->command().isEmpty());
+      QVERIFY(!filter->hash().isEmpty());
+      ++count;
+    }
+  }
+}
+
+void GmicStdlibParserTest::filtersTree()
+{
+  FiltersTreeBuilder builder(0,_stdlib,false);
+  builder.build();
+  QStandardItem * root = builder.takeRoot();
+  int count = 0;
+  checkFilters(root,count);
+  delete root;
+  QVERIFY(count > 100);
+  QCOMPARE(count,builder.filtersCount());
+}
+
+void GmicStdlibParserTest::benchmarkFiltersTree_data()
+{
+  QTest::addColumn<bool>("withVisibility");
+  QTest::newRow("filters") << false;
+  QTest::newRow("selection mode") << true;
+}
+
+void GmicStdlibParserTest::benchmarkFiltersTree()
+{
+  QFETCH(bool,withVisibility);
+  QBENCHMARK {
+    FiltersTreeBuilder builder(0,_stdlib,withVisibility);
+    builder.build();
+  }
+}
+
+QTEST_MAIN(GmicStdlibParserTest)
+#include "GmicStdlibParserTest.moc"
@@ -0,0 +1,94 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file HostStub.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <QString>
+#include <algorithm>
+#include <iostream>
+#include "Common.h"
+#include "host.h"
+#include "gmic_qt.h"
+#include "gmic.h"
+
+/*
+ * Host functions for the benchmarks, which are linked with the plugin
+ * sources but not with any host: a single random image, outputs are dropped.
+ */
+
+namespace GmicQt {
+const QString HostApplicationName = QString("Tests");
+const char * HostApplicationShortname = GMIC_QT_XSTRINGIFY(GMIC_HOST);
+}
+
+namespace {
+const int ImageWidth = 1024;
+const int ImageHeight = 768;
+}
+
+void gmic_qt_get_image_size(int * width, int * height)
+{
+  *width = ImageWidth;
+  *height = ImageHeight;
+}
+
+void gmic_qt_get_layers_extent(int * width, int * height, GmicQt::InputMode)
+{
+  gmic_qt_get_image_size(width,height);
+}
+
+void gmic_qt_get_cropped_images(gmic_list<float> & images,
+                                gmic_list<char> & imageNames,
+                                double x, double y, double width, double height,
+                                GmicQt::InputMode mode)
+{
+  if ( mode == GmicQt::NoInput ) {
+    images.assign();
+    imageNames.assign();
+    return;
+  }
+  if ( x < 0 && y < 0 && width < 0 && height < 0 ) {
+    width = 1.0;
+    height = 1.0;
+  }
+  images.assign(1);
+  imageNames.assign(1);
+  gmic_image<char>::string("pos(0,0),name(stub)").move_to(imageNames[0]);
+  images[0].assign(std::max(1,static_cast<int>(width * ImageWidth)),
+                   std::max(1,static_cast<int>(height * ImageHeight)),1,3).rand(0,255);
+}
+
+void gmic_qt_output_images(gmic_list<float> &,
+                           const gmic_list<char> &,
+                           GmicQt::OutputMode,
+                           const char *)
+{
+}
+
+void gmic_qt_apply_color_profile(cimg_library::CImg<gmic_pixel_type> &)
+{
+}
+
+void gmic_qt_show_message(const char * message)
+{
+  std::cout << message << std::endl;
+}
@@ -0,0 +1,151 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file HtmlTranslatorTest.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <QList>
+#include <QStringList>
+#include <QTextDocument>
+#include <QtTest>
+#include "HtmlTranslator.h"
+#include "gmic.h"
+
+/*
+ * Conversion of filter and folder names to plain text: the simple markup
+ * stripper must give the same text as QTextDocument, which it replaces.
+ */
+class HtmlTranslatorTest : public QObject
+{
+  Q_OBJECT
+
+private slots:
+  void initTestCase();
+  void simpleMarkup_data();
+  void simpleMarkup();
+  void fallback_data();
+  void fallback();
+  void stdlibNames();
+  void benchmarkNames_data();
+  void benchmarkNames();
+
+private:
+  static QString documentText(const QString & html);
+  QStringList _names;
+};
+
+void HtmlTranslatorTest::initTestCase()
+{
+  // Folder and filter names, as found in the #@gui lines of the stdlib
+  const gmic_image<char> stdlib = gmic::decompress_stdlib();
+  const QList<QByteArray> lines = QByteArray(stdlib.data(),static_cast<int>(stdlib.size()) - 1).split('\n');
+  for ( const QByteArray & line : lines ) {
+    if ( line.startsWith("#@gui ") && !line.startsWith("#@gui :") ) {
+      const int colon = line.indexOf(':');
+      const QString name = QString::fromUtf8(line.mid(6,(colon == -1) ? -1 : colon - 6)).trimmed();
+      if ( !name.isEmpty() ) {
+        _names.push_back(name);
+      }
+    }
+  }
+  QVERIFY(_names.size() > 100);
+}
+
+QString HtmlTranslatorTest::documentText(const QString & html)
+{
+  QTextDocument document;
+  document.setHtml(html);
+  return document.toPlainText();
+}
+
+void HtmlTranslatorTest::simpleMarkup_data()
+{
+  QTest::addColumn<QString>("html");
+  QTest::newRow("plain") << "Plain name";
+  QTest::newRow("bold") << "<b>Bold</b> name";
+  QTest::newRow("font") << "<font color=\"#ff0000\">Red</font> filter";
+  QTest::newRow("nested") << "<i><b>Both</b></i> styles";
+  QTest::newRow("named entities") << "Colors &amp; Tones &lt;3&gt;";
+  QTest::newRow("numeric entities") << "&#233;t&#xE9;";
+  QTest::newRow("non breaking space") << "Black&nbsp;&amp;&nbsp;White";
+  QTest::newRow("spaces") << "Spaced \t  out";
+  QTest::newRow("lone ampersand") << "Black & White";
+}
+
+void HtmlTranslatorTest::simpleMarkup()
+{
+  QFETCH(QString,html);
+  QString text;
+  QVERIFY(HtmlTranslator::stripSimpleHtml(html,text));
+  QCOMPARE(text,documentText(html));
+}
+
+void HtmlTranslatorTest::fallback_data()
+{
+  QTest::addColumn<QString>("html");
+  QTest::newRow("line break") << "First<br>Second";
+  QTest::newRow("paragraph") << "<p>Paragraph</p>";
+  QTest::newRow("unknown entity") << "&hearts; Love";
+}
+
+void HtmlTranslatorTest::fallback()
+{
+  QFETCH(QString,html);
+  QString text;
+  QVERIFY(!HtmlTranslator::stripSimpleHtml(html,text));
+  QCOMPARE(HtmlTranslator::html2txt(html,true),documentText(html));
+}
+
+void HtmlTranslatorTest::stdlibNames()
+{
+  for ( const QString & name : _names ) {
+    QString text;
+    if ( HtmlTranslator::stripSimpleHtml(name,text) ) {
+      QCOMPARE(text,documentText(name));
+    }
+  }
+}
+
+void HtmlTranslatorTest::benchmarkNames_data()
+{
+  QTest::addColumn<bool>("document");
+  QTest::newRow("html2txt") << false;
+  QTest::newRow("QTextDocument") << true;
+}
+
+void HtmlTranslatorTest::benchmarkNames()
+{
+  // All the names converted when building the filters tree, now and
+  // with the QTextDocument round trip done before
+  QFETCH(bool,document);
+  QBENCHMARK {
+    for ( const QString & name : _names ) {
+      if ( document ) {
+        documentText(name);
+      } else {
+        HtmlTranslator::html2txt(name,true);
+      }
+    }
+  }
+}
+
+QTEST_MAIN(HtmlTranslatorTest)
+#include "HtmlTranslatorTest.moc"
@@ -0,0 +1,175 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file ParameterDefinitionTest.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <QPair>
+#include <QStandardItem>
+#include <QStringList>
+#include <QVector>
+#include <QtTest>
+#include "FiltersTreeAbstractFilterItem.h"
+#include "FiltersTreeBuilder.h"
+#include "ParameterDefinition.h"
+#include "gmic.h"
+
+/*
+ * Splitting the parameters of filters, as done each time a filter is
+ * selected, for every filter of the stdlib.
+ */
+class ParameterDefinitionTest : public QObject
+{
+  Q_OBJECT
+
+private slots:
+  void initTestCase();
+  void definitions_data();
+  void definitions();
+  void errors_data();
+  void errors();
+  void stdlibFilters();
+  void benchmarkSwitching_data();
+  void benchmarkSwitching();
+
+private:
+  void collectFilters(QStandardItem * folder);
+  QVector<QPair<QString,QString> > _filters; // (hash, parameters)
+};
+
+void ParameterDefinitionTest::initTestCase()
+{
+  const gmic_image<char> stdlib = gmic::decompress_stdlib();
+  QByteArray data(stdlib.data(),static_cast<int>(stdlib.size()) - 1);
+  data.append('\n');
+  FiltersTreeBuilder builder(0,data,false);
+  builder.build();
+  QStandardItem * root = builder.takeRoot();
+  collectFilters(root);
+  delete root;
+  QVERIFY(_filters.size() > 100);
+}
+
+void ParameterDefinitionTest::collectFilters(QStandardItem * folder)
+{
+  for ( int row = 0; row < folder->rowCount(); ++row ) {
+    QStandardItem * item = folder->child(row);
+    if ( FiltersTreeAbstractItem::isFolder(item) ) {
+      collectFilters(item);
+    } else if ( FiltersTreeAbstractFilterItem * filter = FiltersTreeAbstractItem::toAbstractFilter(item) ) {
+      _filters.push_back(qMakePair(filter->hash(),filter->parameters()));
+    }
+  }
+}
+
+void ParameterDefinitionTest::definitions_data()
+{
+  QTest::addColumn<QString>("text");
+  QTest::addColumn<QString>("name");
+  QTest::addColumn<QString>("type");
+  QTest::addColumn<QString>("values");
+  QTest::addColumn<bool>("update");
+  QTest::newRow("float") << "Radius = _float(3,0,20)" << "Radius" << "float" << "3,0,20" << false;
+  QTest::newRow("braces") << "Mode=Choice{\"A (a)\",\"B\"}" << "Mode" << "choice" << "\"A (a)\",\"B\"" << true;
+  QTest::newRow("brackets") << "  Text = text[ \"Hello\" ] " << "Text" << "text" << "\"Hello\"" << true;
+}
+
+void ParameterDefinitionTest::definitions()
+{
+  QFETCH(QString,text);
+  QFETCH(QString,name);
+  QFETCH(QString,type);
+  QFETCH(QString,values);
+  QFETCH(bool,update);
+  QVector<ParameterDefinition> definitions;
+  QString error;
+  QVERIFY(ParameterDefinition::parse(text + ", Size = int(1,0,10)",definitions,error));
+  QVERIFY(error.isEmpty());
+  QCOMPARE(definitions.size(),2);
+  QCOMPARE(definitions[0].name,name);
+  QCOMPARE(definitions[0].type,type);
+  QCOMPARE(definitions[0].values,values);
+  QCOMPARE(definitions[0].update,update);
+  QCOMPARE(definitions[1].name,QString("Size"));
+}
+
+void ParameterDefinitionTest::errors_data()
+{
+  QTest::addColumn<QString>("text");
+  QTest::newRow("no type") << "Radius float(3)";
+  QTest::newRow("unknown type") << "Radius = real(3)";
+  QTest::newRow("unclosed") << "Radius = float(3,0,20";
+}
+
+void ParameterDefinitionTest::errors()
+{
+  QFETCH(QString,text);
+  QVector<ParameterDefinition> definitions;
+  QString error;
+  QVERIFY(!ParameterDefinition::parse(text,definitions,error));
+  QVERIFY(!error.isEmpty());
+}
+
+void ParameterDefinitionTest::stdlibFilters()
+{
+  QStringList failures;
+  QVector<ParameterDefinition> definitions;
+  QString error;
+  for ( int i = 0; i < _filters.size(); ++i ) {
+    if ( !ParameterDefinition::parse(_filters[i].second,definitions,error) ) {
+      failures << error;
+    }
+  }
+  QVERIFY2(failures.isEmpty(),qPrintable(failures.join("\n")));
+}
+
+void ParameterDefinitionTest::benchmarkSwitching_data()
+{
+  QTest::addColumn<bool>("cached");
+  QTest::newRow("parse") << false;
+  QTest::newRow("cachedParse") << true;
+}
+
+void ParameterDefinitionTest::benchmarkSwitching()
+{
+  QFETCH(bool,cached);
+  QVector<ParameterDefinition> definitions;
+  QString error;
+  ParameterDefinition::clearCache();
+  if ( cached ) {
+    // Every filter has been selected once
+    for ( int i = 0; i < _filters.size(); ++i ) {
+      ParameterDefinition::cachedParse(_filters[i].first,_filters[i].second,error);
+    }
+  }
+  QBENCHMARK {
+    for ( int i = 0; i < _filters.size(); ++i ) {
+      if ( cached ) {
+        definitions = ParameterDefinition::cachedParse(_filters[i].first,_filters[i].second,error);
+      } else {
+        ParameterDefinition::parse(_filters[i].second,definitions,error);
+      }
+    }
+  }
+}
+
+QTEST_MAIN(ParameterDefinitionTest)
+#include "ParameterDefinitionTest.moc"
@@ -0,0 +1,167 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file SharedMemoryPoolTest.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <QByteArray>
+#include <QSet>
+#include <QSharedMemory>
+#include <QString>
+#include <QUuid>
+#include <QtTest>
+#include <cstring>
+#include "SharedMemoryPool.h"
+
+/*
+ * Output images written to shared memory segments and read back by
+ * the host, with segments reused from one output to the next or
+ * created for each output.
+ */
+class SharedMemoryPoolTest : public QObject
+{
+  Q_OBJECT
+
+private slots:
+  void reuse();
+  void maxFreeSegments();
+  void transfer();
+  void benchmarkOutput_data();
+  void benchmarkOutput();
+
+private:
+  static bool read(const QString & key, QByteArray & data);
+  static void write(QSharedMemory * segment, const QByteArray & data);
+};
+
+bool SharedMemoryPoolTest::read(const QString & key, QByteArray & data)
+{
+  // What the host does with each key it is sent
+  QSharedMemory segment(key);
+  if ( ! segment.attach(QSharedMemory::ReadOnly) ) {
+    return false;
+  }
+  segment.lock();
+  std::memcpy(data.data(),segment.constData(),data.size());
+  segment.unlock();
+  segment.detach();
+  return true;
+}
+
+void SharedMemoryPoolTest::write(QSharedMemory * segment, const QByteArray & data)
+{
+  segment->lock();
+  std::memcpy(segment->data(),data.constData(),data.size());
+  segment->unlock();
+}
+
+void SharedMemoryPoolTest::reuse()
+{
+  SharedMemoryPool pool;
+  QSharedMemory * first = pool.acquire(3 * 1024 * 1024);
+  QVERIFY(first);
+  QVERIFY(first->size() >= 3 * 1024 * 1024);
+  const QString key = first->key();
+  pool.recycle();
+
+  // Same size class, reused
+  QSharedMemory * segment = pool.acquire(3 * 1024 * 1024 + 1);
+  QVERIFY(segment);
+  QCOMPARE(segment->key(),key);
+
+  // In use, or too small
+  QSharedMemory * other = pool.acquire(3 * 1024 * 1024);
+  QVERIFY(other);
+  QVERIFY(other->key() != key);
+  QSharedMemory * larger = pool.acquire(10 * 1024 * 1024);
+  QVERIFY(larger);
+  QVERIFY(larger->size() >= 10 * 1024 * 1024);
+  QVERIFY(larger->key() != key);
+  pool.clear();
+}
+
+void SharedMemoryPoolTest::maxFreeSegments()
+{
+  SharedMemoryPool pool;
+  QSet<QString> keys;
+  for ( int i = 0; i < 12; ++i ) {
+    QSharedMemory * segment = pool.acquire(1024);
+    QVERIFY(segment);
+    keys.insert(segment->key());
+  }
+  pool.recycle();
+  int reused = 0;
+  for ( int i = 0; i < 12; ++i ) {
+    QSharedMemory * segment = pool.acquire(1024);
+    QVERIFY(segment);
+    reused += keys.contains(segment->key());
+  }
+  QCOMPARE(reused,8);
+}
+
+void SharedMemoryPoolTest::transfer()
+{
+  SharedMemoryPool pool;
+  QByteArray data(2 * 1024 * 1024,'\0');
+  for ( int output = 0; output < 3; ++output ) {
+    pool.recycle();
+    data.fill(static_cast<char>('a' + output));
+    QSharedMemory * segment = pool.acquire(data.size());
+    QVERIFY(segment);
+    write(segment,data);
+    QByteArray received(data.size(),'\0');
+    QVERIFY(read(segment->key(),received));
+    QCOMPARE(received,data);
+  }
+}
+
+void SharedMemoryPoolTest::benchmarkOutput_data()
+{
+  QTest::addColumn<bool>("pooled");
+  QTest::newRow("SharedMemoryPool") << true;
+  QTest::newRow("segment per output") << false;
+}
+
+void SharedMemoryPoolTest::benchmarkOutput()
+{
+  QFETCH(bool,pooled);
+  // A 1920x1080 RGBA image of floats
+  QByteArray data(1920 * 1080 * 4 * static_cast<int>(sizeof(float)),'\1');
+  QByteArray received(data.size(),'\0');
+  SharedMemoryPool pool;
+  QBENCHMARK {
+    if ( pooled ) {
+      pool.recycle();
+      QSharedMemory * segment = pool.acquire(data.size());
+      QVERIFY(segment);
+      write(segment,data);
+      QVERIFY(read(segment->key(),received));
+    } else {
+      QSharedMemory segment(QString("key_%1").arg(QUuid::createUuid().toString()));
+      QVERIFY(segment.create(data.size()));
+      write(&segment,data);
+      QVERIFY(read(segment.key(),received));
+    }
+  }
+}
+
+QTEST_GUILESS_MAIN(SharedMemoryPoolTest)
+#include "SharedMemoryPoolTest.moc"
@@ -0,0 +1,356 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file UpdaterTest.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <QCoreApplication>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QNetworkProxy>
+#include <QRegExp>
+#include <QSettings>
+#include <QSignalSpy>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+#include <QtTest>
+#include <functional>
+#include "StdlibCache.h"
+#include "Updater.h"
+#include "gmic_qt.h"
+
+/*
+ * Downloads of the Updater against a local stand-in for the sources server:
+ * conditional requests, and downloads resumed from a .part file.
+ */
+
+namespace {
+
+QByteArray RcPath;
+
+QByteArray readFile(const QString & filename)
+{
+  QFile file(filename);
+  return file.open(QFile::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+}
+
+// The Updater stores the downloaded files in the resources directory
+namespace GmicQt {
+const char * path_rc(bool)
+{
+  return RcPath.constData();
+}
+}
+
+/**
+ * @brief Minimal HTTP/1.1 server serving a single file, honoring
+ *        If-None-Match, Range and If-Range like a real server would.
+ */
+class HttpStandIn : public QTcpServer
+{
+  Q_OBJECT
+
+public:
+  struct Request {
+    QHash<QByteArray,QByteArray> headers; // Lower case names
+  };
+
+  HttpStandIn()
+  {
+    connect(this,SIGNAL(newConnection()),this,SLOT(onNewConnection()));
+    reset();
+  }
+
+  void reset()
+  {
+    body = "#@gmic\n";
+    for ( int line = 0; body.size() < 65536; ++line ) {
+      body += QString("#@gui Filter %1 : command_%1, command_preview_%1(0)\n").arg(line).toLatin1();
+    }
+    etag = "\"v1\"";
+    cutAfter = -1;
+    requests.clear();
+    onRequest = nullptr;
+  }
+
+  QByteArray body;
+  QByteArray etag;
+  int cutAfter;                      // If not -1, connection is closed after that many bytes of content
+  QList<Request> requests;
+  std::function<void(const Request &)> onRequest;
+
+private slots:
+  void onNewConnection()
+  {
+    while ( QTcpSocket * socket = nextPendingConnection() ) {
+      connect(socket,SIGNAL(readyRead()),this,SLOT(onReadyRead()));
+      connect(socket,SIGNAL(disconnected()),socket,SLOT(deleteLater()));
+    }
+  }
+
+  void onReadyRead()
+  {
+    QTcpSocket * socket = qobject_cast<QTcpSocket*>(sender());
+    QByteArray & buffer = _buffers[socket];
+    buffer += socket->readAll();
+    const int end = buffer.indexOf("\r\n\r\n");
+    if ( end == -1 ) {
+      return;
+    }
+    Request request;
+    const QList<QByteArray> lines = buffer.left(end).split('\n');
+    for ( int i = 1; i < lines.size(); ++i ) {
+      const int colon = lines[i].indexOf(':');
+      if ( colon > 0 ) {
+        request.headers.insert(lines[i].left(colon).trimmed().toLower(),lines[i].mid(colon + 1).trimmed());
+      }
+    }
+    _buffers.remove(socket);
+    requests.push_back(request);
+    if ( onRequest ) {
+      onRequest(request);
+    }
+    socket->write(answer(request));
+    socket->disconnectFromHost();
+  }
+
+private:
+  QByteArray answer(const Request & request) const
+  {
+    if ( request.headers.value("if-none-match") == etag ) {
+      return "HTTP/1.1 304 Not Modified\r\nETag: " + etag + "\r\nConnection: close\r\n\r\n";
+    }
+    QByteArray status = "200 OK";
+    QByteArray content = body;
+    QByteArray extraHeaders;
+    QRegExp range("bytes=(\\d+)-");
+    if ( range.exactMatch(QString::fromLatin1(request.headers.value("range")))
+         && (!request.headers.contains("if-range") || request.headers.value("if-range") == etag) ) {
+      const int start = range.cap(1).toInt();
+      if ( start < body.size() ) {
+        status = "206 Partial Content";
+        content = body.mid(start);
+        extraHeaders = QString("Content-Range: bytes %1-%2/%3\r\n").arg(start).arg(body.size() - 1).arg(body.size()).toLatin1();
+      }
+    }
+    QByteArray header = "HTTP/1.1 " + status + "\r\nETag: " + etag + "\r\n" + extraHeaders
+        + "Content-Length: " + QByteArray::number(content.size()) + "\r\nConnection: close\r\n\r\n";
+    return header + (cutAfter == -1 ? content : content.left(cutAfter));
+  }
+
+  QHash<QTcpSocket*,QByteArray> _buffers;
+};
+
+class UpdaterTest : public QObject
+{
+  Q_OBJECT
+
+private slots:
+  void initTestCase();
+  void init();
+  void fullDownload();
+  void notModified();
+  void modified();
+  void resume();
+  void resumeChangedFile();
+  void missingPartFile();
+  void resizedPartFile();
+
+private:
+  bool update();
+  QString localFile() const;
+  QString partFile() const;
+  QTemporaryDir _dir;
+  HttpStandIn _server;
+  QString _source;
+};
+
+void UpdaterTest::initTestCase()
+{
+  QVERIFY(_dir.isValid());
+  RcPath = QFile::encodeName(_dir.path() + "/");
+  QCoreApplication::setOrganizationName("gmic_qt_tests");
+  QCoreApplication::setApplicationName("UpdaterTest");
+  QSettings::setDefaultFormat(QSettings::IniFormat);
+  QSettings::setPath(QSettings::IniFormat,QSettings::UserScope,_dir.path());
+  QNetworkProxy::setApplicationProxy(QNetworkProxy::NoProxy);
+  QVERIFY(_server.listen(QHostAddress::LocalHost));
+  _source = QString("http://127.0.0.1:%1/update_test.gmic").arg(_server.serverPort());
+
+  // Let updateSources() pick the test source from the sources cache
+  Updater::setInstanceParent(QCoreApplication::instance());
+  QList<QString> sources;
+  sources << _source;
+  QMap<QString,bool> isStdlib;
+  isStdlib[_source] = false;
+  StdlibCache::writeSources(true,sources,isStdlib);
+  Updater::getInstance()->updateSources(true,true);
+  QCOMPARE(Updater::getInstance()->sources(),sources);
+}
+
+void UpdaterTest::init()
+{
+  _server.reset();
+  QFile::remove(localFile());
+  QFile::remove(partFile());
+  QSettings().remove("SourcesValidators");
+}
+
+QString UpdaterTest::localFile() const
+{
+  return _dir.path() + "/update_test.gmic";
+}
+
+QString UpdaterTest::partFile() const
+{
+  return localFile() + ".part";
+}
+
+bool UpdaterTest::update()
+{
+  // Sources checked less than 0 hours ago are fetched again
+  QTest::qWait(10);
+  Updater * updater = Updater::getInstance();
+  QSignalSpy spy(updater,SIGNAL(downloadsFinished(bool)));
+  updater->startDownloads(0,3600,true);
+  if ( spy.isEmpty() && !spy.wait(10000) ) {
+    return false;
+  }
+  return spy.first().first().toBool();
+}
+
+void UpdaterTest::fullDownload()
+{
+  QVERIFY(update());
+  QCOMPARE(_server.requests.size(),1);
+  QVERIFY(!_server.requests[0].headers.contains("if-none-match"));
+  QVERIFY(!_server.requests[0].headers.contains("range"));
+  QCOMPARE(readFile(localFile()),_server.body);
+  QVERIFY(Updater::getInstance()->someNetworkUpdateAchieved());
+}
+
+void UpdaterTest::notModified()
+{
+  QVERIFY(update());
+  const QDateTime written = QFileInfo(localFile()).lastModified();
+  QTest::qWait(1100);
+  QVERIFY(update());
+  QCOMPARE(_server.requests.size(),2);
+  QCOMPARE(_server.requests[1].headers.value("if-none-match"),_server.etag);
+  // A 304 answer leaves the local file (and thus the cached stdlib) untouched
+  QCOMPARE(QFileInfo(localFile()).lastModified(),written);
+  QVERIFY(!Updater::getInstance()->someNetworkUpdateAchieved());
+  QCOMPARE(readFile(localFile()),_server.body);
+}
+
+void UpdaterTest::modified()
+{
+  QVERIFY(update());
+  _server.etag = "\"v2\"";
+  _server.body += "#@gui Filter added : command_added\n";
+  QVERIFY(update());
+  QCOMPARE(_server.requests.size(),2);
+  QCOMPARE(_server.requests[1].headers.value("if-none-match"),QByteArray("\"v1\""));
+  QCOMPARE(readFile(localFile()),_server.body);
+}
+
+void UpdaterTest::resume()
+{
+  _server.cutAfter = 20000;
+  QVERIFY(!update());
+  QVERIFY(!QFile::exists(localFile()));
+  QCOMPARE(QFileInfo(partFile()).size(),qint64(20000));
+
+  _server.cutAfter = -1;
+  QVERIFY(update());
+  QCOMPARE(_server.requests.size(),2);
+  QCOMPARE(_server.requests[1].headers.value("range"),QByteArray("bytes=20000-"));
+  QCOMPARE(_server.requests[1].headers.value("if-range"),_server.etag);
+  QCOMPARE(readFile(localFile()),_server.body);
+  QVERIFY(!QFile::exists(partFile()));
+}
+
+void UpdaterTest::resumeChangedFile()
+{
+  _server.cutAfter = 20000;
+  QVERIFY(!update());
+  QVERIFY(QFile::exists(partFile()));
+
+  // If-Range does not match anymore, the server sends the whole new file
+  _server.cutAfter = -1;
+  _server.etag = "\"v2\"";
+  _server.body.replace("command_","new_command_");
+  QVERIFY(update());
+  QCOMPARE(_server.requests.size(),2);
+  QVERIFY(_server.requests[1].headers.contains("range"));
+  QCOMPARE(readFile(localFile()),_server.body);
+  QVERIFY(!QFile::exists(partFile()));
+}
+
+void UpdaterTest::missingPartFile()
+{
+  _server.cutAfter = 20000;
+  QVERIFY(!update());
+  QVERIFY(QFile::exists(partFile()));
+
+  // The .part file disappears while the range request is on its way
+  _server.cutAfter = -1;
+  const QString part = partFile();
+  _server.onRequest = [part](const HttpStandIn::Request & request) {
+    if ( request.headers.contains("range") ) {
+      QFile::remove(part);
+    }
+  };
+  QVERIFY(update());
+  // The 206 answer is dropped and the whole file is downloaded again
+  QCOMPARE(_server.requests.size(),3);
+  QVERIFY(_server.requests[1].headers.contains("range"));
+  QVERIFY(!_server.requests[2].headers.contains("range"));
+  QCOMPARE(readFile(localFile()),_server.body);
+  QVERIFY(!QFile::exists(partFile()));
+}
+
+void UpdaterTest::resizedPartFile()
+{
+  _server.cutAfter = 20000;
+  QVERIFY(!update());
+
+  // The .part file no longer ends where the requested range starts
+  _server.cutAfter = -1;
+  const QString part = partFile();
+  _server.onRequest = [part](const HttpStandIn::Request & request) {
+    QFile file(part);
+    if ( request.headers.contains("range") && file.open(QFile::WriteOnly|QFile::Append) ) {
+      file.write("garbage");
+    }
+  };
+  QVERIFY(update());
+  QCOMPARE(_server.requests.size(),3);
+  QVERIFY(!_server.requests[2].headers.contains("range"));
+  QCOMPARE(readFile(localFile()),_server.body);
+}
+
+QTEST_GUILESS_MAIN(UpdaterTest)
+#include "UpdaterTest.moc"
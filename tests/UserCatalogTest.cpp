@@ -0,0 +1,128 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file UserCatalogTest.cpp
+ *
+ *  Copyright 2017 Sebastien Fourey
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <QCryptographicHash>
+#include <QFile>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <QtTest>
+#include "FiltersVisibilityMap.h"
+#include "InOutPanel.h"
+#include "ParametersCache.h"
+#include "StoredFave.h"
+#include "UserCatalog.h"
+
+/*
+ * Reading the user data about filters (last parameters, Input/Output
+ * states, hidden filters and faves) from the catalog, as done at startup.
+ */
+class UserCatalogTest : public QObject
+{
+  Q_OBJECT
+
+private slots:
+  void initTestCase();
+  void cleanupTestCase();
+  void reload();
+  void benchmarkStartup();
+
+private:
+  static QString hash(int index);
+  static void startup();
+  static const int FiltersCount = 2000;
+  static const int FavesCount = 100;
+  QTemporaryDir _dir;
+  QList<QString> _values;
+  InOutPanel::State _state;
+};
+
+QString UserCatalogTest::hash(int index)
+{
+  return QString::fromLatin1(QCryptographicHash::hash(QByteArray::number(index),QCryptographicHash::Md5).toHex());
+}
+
+void UserCatalogTest::startup()
+{
+  ParametersCache::load(true);
+  FiltersVisibilityMap::load();
+  StoredFave::readFaves();
+  ParametersCache::preload();
+}
+
+void UserCatalogTest::initTestCase()
+{
+  // The catalog is created under GMIC_PATH
+  QVERIFY(_dir.isValid());
+  qputenv("GMIC_PATH",QFile::encodeName(_dir.path() + "/"));
+  _values << "3" << "0.5" << "\"Some text\"" << "1";
+  _state = InOutPanel::State(GmicQt::All,GmicQt::NewLayers,GmicQt::FirstOutput,GmicQt::Quiet);
+
+  ParametersCache::load(true);
+  for ( int i = 0; i < FiltersCount; ++i ) {
+    ParametersCache::setValues(hash(i),_values);
+    if ( i % 4 == 0 ) {
+      ParametersCache::setInputOutputState(hash(i),_state);
+    }
+    if ( i % 10 == 0 ) {
+      FiltersVisibilityMap::setVisibility(hash(i),false);
+    }
+  }
+  FiltersVisibilityMap::save();
+  QList<StoredFave> faves;
+  for ( int i = 0; i < FavesCount; ++i ) {
+    faves.push_back(StoredFave(QString("Fave %1").arg(i),"Blur","blur","blur",QStringList() << "3"));
+  }
+  QVERIFY(StoredFave::writeFaves(faves));
+  UserCatalog::close();
+}
+
+void UserCatalogTest::cleanupTestCase()
+{
+  UserCatalog::close();
+}
+
+void UserCatalogTest::reload()
+{
+  UserCatalog::close();
+  startup();
+  QCOMPARE(ParametersCache::getValues(hash(0)),_values);
+  QCOMPARE(ParametersCache::getValues(hash(FiltersCount - 1)),_values);
+  QVERIFY(ParametersCache::getValues(hash(FiltersCount)).isEmpty());
+  QVERIFY(ParametersCache::getInputOutputState(hash(0)) == _state);
+  QVERIFY(ParametersCache::getInputOutputState(hash(1)).isUnspecified());
+  QVERIFY(!FiltersVisibilityMap::filterIsVisible(hash(0)));
+  QVERIFY(FiltersVisibilityMap::filterIsVisible(hash(1)));
+  QCOMPARE(StoredFave::readFaves().size(),static_cast<int>(FavesCount));
+}
+
+void UserCatalogTest::benchmarkStartup()
+{
+  QBENCHMARK {
+    UserCatalog::close();
+    startup();
+  }
+}
+
+QTEST_GUILESS_MAIN(UserCatalogTest)
+#include "UserCatalogTest.moc"